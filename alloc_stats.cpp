@@ -0,0 +1,99 @@
+#include "alloc_stats.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Zero-initialized, so usable from operator new before any constructor runs
+thread_local AllocCounters counters;
+thread_local AllocSite currentSite = AllocSite::OTHER;
+
+} // namespace
+
+const char* allocSiteName(AllocSite site) {
+    switch (site) {
+#define X(name, label) case AllocSite::name: return label;
+        ALLOC_SITES(X)
+#undef X
+        case AllocSite::Count: break;
+    }
+    return "?";
+}
+
+const AllocCounters& threadAllocCounters() {
+    return counters;
+}
+
+void resetAllocPeak() {
+    counters.peakLiveBytes = counters.liveBytes;
+}
+
+AllocSiteScope::AllocSiteScope(AllocSite site) : previous(currentSite) {
+    currentSite = site;
+}
+
+AllocSiteScope::~AllocSiteScope() {
+    currentSite = previous;
+}
+
+#ifdef ALLOC_STATS
+
+// Every block carries its size in a header so delete can account for it
+// without relying on sized deallocation. Over-aligned new/delete are not
+// replaced and bypass the counters.
+namespace {
+
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+void* countedAlloc(size_t size) noexcept {
+    void* raw = std::malloc(size + kHeader);
+    if (!raw) {
+        return nullptr;
+    }
+    *static_cast<size_t*>(raw) = size;
+
+    size_t site = static_cast<size_t>(currentSite);
+    ++counters.allocations;
+    counters.bytes += size;
+    ++counters.siteAllocations[site];
+    counters.siteBytes[site] += size;
+    counters.liveBytes += static_cast<int64_t>(size);
+    if (counters.liveBytes > counters.peakLiveBytes) {
+        counters.peakLiveBytes = counters.liveBytes;
+    }
+    return static_cast<char*>(raw) + kHeader;
+}
+
+void* countedAllocOrThrow(size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void countedFree(void* p) noexcept {
+    if (!p) {
+        return;
+    }
+    char* raw = static_cast<char*>(p) - kHeader;
+    ++counters.frees;
+    counters.liveBytes -= static_cast<int64_t>(*reinterpret_cast<size_t*>(raw));
+    std::free(raw);
+}
+
+} // namespace
+
+void* operator new(size_t size) { return countedAllocOrThrow(size); }
+void* operator new[](size_t size) { return countedAllocOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+#endif // ALLOC_STATS
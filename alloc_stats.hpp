@@ -0,0 +1,82 @@
+#ifndef ALLOC_STATS_HPP
+#define ALLOC_STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocation accounting for --stats. Building with -DALLOC_STATS
+// (`make clean alloc-stats`) replaces the global operator new/delete with
+// versions that count allocations, bytes and live bytes for the calling
+// thread. In a normal build nothing is replaced and every counter stays 0.
+//
+// ALLOC_SITE(X) tags allocations made until the end of the enclosing block
+// with a call-site category, so the report can say where they came from:
+//   PARSE             AST nodes, token strings and parser stacks
+//   SCOPE             pooled Scope objects, when the ScopeStack grows past its
+//                     deepest earlier use
+//   SYMBOL            symbol slots, name strings and bucket tables past a
+//                     scope's earlier size, signature pool growth, and the
+//                     GlobalSymbolTable built under shareGlobals()
+//   CALL_CHECK        the argument and parameter type lists of an
+//                     INVALID_SIGNATURE error; only on that failure path
+
+#define ALLOC_SITES(X)                       \
+    X(OTHER, "other")                        \
+    X(PARSE, "parse")                        \
+    X(SCOPE, "scope")                        \
+    X(SYMBOL, "symbol")                      \
+    X(CALL_CHECK, "call-check")
+
+enum class AllocSite : uint8_t {
+#define X(name, label) name,
+    ALLOC_SITES(X)
+#undef X
+    Count
+};
+
+constexpr size_t kAllocSiteCount = static_cast<size_t>(AllocSite::Count);
+
+const char* allocSiteName(AllocSite site);
+
+struct AllocCounters {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    uint64_t frees = 0;
+    int64_t liveBytes = 0;       // can go negative if other threads free this thread's blocks
+    int64_t peakLiveBytes = 0;   // since the last resetAllocPeak()
+    uint64_t siteAllocations[kAllocSiteCount] = {};
+    uint64_t siteBytes[kAllocSiteCount] = {};
+};
+
+#ifdef ALLOC_STATS
+constexpr bool kAllocStatsEnabled = true;
+#else
+constexpr bool kAllocStatsEnabled = false;
+#endif
+
+// Counters of the calling thread
+const AllocCounters& threadAllocCounters();
+
+// Restart peak tracking at the current live byte count
+void resetAllocPeak();
+
+// Sets the calling thread's allocation site for its lifetime
+class AllocSiteScope {
+ private:
+    AllocSite previous;
+
+ public:
+    explicit AllocSiteScope(AllocSite site);
+    ~AllocSiteScope();
+
+    AllocSiteScope(const AllocSiteScope&) = delete;
+    AllocSiteScope& operator=(const AllocSiteScope&) = delete;
+};
+
+#ifdef ALLOC_STATS
+#define ALLOC_SITE(site) AllocSiteScope allocSiteScope(AllocSite::site)
+#else
+#define ALLOC_SITE(site) ((void)0)
+#endif
+
+#endif // ALLOC_STATS_HPP
@@ -0,0 +1,61 @@
+#include "analysis_context.hpp"
+#include <algorithm>
+#include <mutex>
+#include "frontend.hpp"
+
+AnalysisContext::~AnalysisContext() {
+    delete root;
+}
+
+bool AnalysisContext::analyze(const char* source, size_t size) {
+    delete root;
+    root = nullptr;
+    diagnosticList.clear();
+    globalSymbols.clear();
+
+    SyntaxError syntaxError;
+    try {
+        std::scoped_lock lock(scannerMutex, parserMutex);
+        root = parseSource(source, size, syntaxError);
+    } catch (const std::exception& e) {
+        // The scanner rejects some input by throwing
+        diagnosticList.push_back(messageDiagnostic(DiagnosticKind::SYNTAX, e.what()));
+        return false;
+    }
+    if (!root) {
+        diagnosticList.push_back(syntaxDiagnostic(syntaxError));
+        return false;
+    }
+
+    analyzer.reset(root);
+    std::optional<SemanticError> error = analyzer.tryAnalyze();
+    auto collect = [this](const SymbolInfo& symbol) { globalSymbols.push_back(&symbol); };
+    if (const auto& functions = analyzer.sharedGlobals()) {
+        functions->forEachSymbol(collect);
+    }
+    if (const Scope* globals = analyzer.globals()) {
+        globals->forEachSymbol(collect);
+        std::sort(globalSymbols.begin(), globalSymbols.end(),
+                  [](const SymbolInfo* a, const SymbolInfo* b) { return a->name < b->name; });
+    }
+    if (error) {
+        diagnosticList.push_back(semanticDiagnostic(*error));
+        return false;
+    }
+    return true;
+}
+
+const SymbolInfo* AnalysisContext::findGlobal(const std::string& name) const {
+    auto it = std::lower_bound(globalSymbols.begin(), globalSymbols.end(), name,
+                               [](const SymbolInfo* symbol, const std::string& key) {
+                                   return symbol->name < key;
+                               });
+    if (it != globalSymbols.end() && (*it)->name == name) {
+        return *it;
+    }
+    return nullptr;
+}
+
+const ProgramNode* AnalysisContext::program() const {
+    return static_cast<const ProgramNode*>(root);
+}
@@ -0,0 +1,69 @@
+#ifndef ANALYSIS_CONTEXT_HPP
+#define ANALYSIS_CONTEXT_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "astnode.hpp"
+#include "diagnostics.hpp"
+#include "exception.hpp"
+#include "semantic_analyzer.hpp"
+
+// In-process entry point of libsemantic: parse and analyze a source buffer,
+// then read back diagnostics, global symbols and the typed AST.
+//
+//     AnalysisContext context;
+//     if (!context.analyze(source, size)) {
+//         for (const Diagnostic& d : context.diagnostics()) ...
+//     }
+//     const SymbolInfo* main = context.findGlobal("main");
+//
+// A context is meant to be kept and reused: the analyzer's block and
+// expression stacks and the result vectors keep their capacity from one
+// call to the next. When the program still declares the same functions (an
+// edit inside a body), the frozen function table of the last call is reused
+// instead of declaring them again. Parsing goes through the flex/bison
+// globals, so it is serialized, under the frontend.hpp locks, with every
+// other parse in the process; analysis is not. A single context must not be
+// used from two threads at once.
+
+class AnalysisContext {
+ private:
+    SemanticAnalyzer analyzer;
+    ASTNode* root;
+    std::vector<Diagnostic> diagnosticList;
+    std::vector<const SymbolInfo*> globalSymbols;
+
+ public:
+    AnalysisContext() : analyzer(nullptr), root(nullptr) { analyzer.shareGlobals(); }
+    ~AnalysisContext();
+
+    AnalysisContext(const AnalysisContext&) = delete;
+    AnalysisContext& operator=(const AnalysisContext&) = delete;
+
+    // Parse and analyze `size` bytes of source. Returns true if the program
+    // is valid. Everything below describes this call until the next one.
+    bool analyze(const char* source, size_t size);
+    bool analyze(const std::string& source) { return analyze(source.data(), source.size()); }
+
+    // At most one entry, of kind SYNTAX or SEMANTIC: parsing and analysis
+    // both stop at the first error
+    const std::vector<Diagnostic>& diagnostics() const { return diagnosticList; }
+
+    // Functions and global variables, sorted by name. After a semantic error
+    // this is every function plus the globals declared before the error;
+    // after a syntax error it is empty.
+    const std::vector<const SymbolInfo*>& globals() const { return globalSymbols; }
+    const SymbolInfo* findGlobal(const std::string& name) const;
+
+    // The return and parameter types of a function from globals()
+    FunctionSignature signature(const SymbolInfo& function) const {
+        return analyzer.signature(function);
+    }
+
+    // The analyzed tree with a type on every expression, or nullptr after a
+    // syntax error
+    const ProgramNode* program() const;
+};
+
+#endif // ANALYSIS_CONTEXT_HPP
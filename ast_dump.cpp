@@ -0,0 +1,663 @@
+#include "ast_dump.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "data_type.hpp"
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+DumpWriter::DumpWriter(int fd, size_t capacity)
+    : buffer(capacity > 0 ? capacity : 1), used(0), fd(fd), stream(nullptr), error(false),
+      writeCalls(0) {}
+
+DumpWriter::DumpWriter(std::ostream& stream, size_t capacity)
+    : buffer(capacity > 0 ? capacity : 1), used(0), fd(-1), stream(&stream), error(false),
+      writeCalls(0) {}
+
+DumpWriter::~DumpWriter() {
+    flush();
+}
+
+void DumpWriter::writeOut(const char* data, size_t size) {
+    if (error) {
+        return;
+    }
+    if (stream) {
+        ++writeCalls;
+        stream->write(data, static_cast<std::streamsize>(size));
+        error = !*stream;
+        return;
+    }
+    while (size > 0) {
+        ++writeCalls;
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = true;
+            return;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void DumpWriter::flush() {
+    if (used > 0) {
+        writeOut(buffer.data(), used);
+        used = 0;
+    }
+}
+
+void DumpWriter::spaces(int count) {
+    while (count > 0) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        size_t run = std::min(static_cast<size_t>(count), buffer.size() - used);
+        std::memset(buffer.data() + used, ' ', run);
+        used += run;
+        count -= static_cast<int>(run);
+    }
+}
+
+bool parseDumpFormat(const char* name, DumpFormat& format) {
+    if (std::strcmp(name, "text") == 0) {
+        format = DumpFormat::TEXT;
+    } else if (std::strcmp(name, "json") == 0) {
+        format = DumpFormat::JSON;
+    } else if (std::strcmp(name, "sexpr") == 0) {
+        format = DumpFormat::SEXPR;
+    } else if (std::strcmp(name, "dot") == 0) {
+        format = DumpFormat::DOT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+// ============================================================================
+// NODE DESCRIPTIONS
+// ============================================================================
+
+// One scalar attribute of a node, pointing into the node or the NodeView
+struct Attr {
+    const char* key;
+    const char* data;
+    size_t size;
+    bool quoted;    // string rather than number/boolean
+};
+
+// A run of children under one name: a single child pointer or a vector
+struct Group {
+    const char* key;        // JSON/S-expression/DOT name
+    const char* label;      // TEXT label line, or nullptr to list the children directly
+    const void* items;      // Node* const*
+    size_t count;
+    const ASTNode* (*at)(const void* items, size_t i);
+    bool list;              // vector of children (a JSON array) rather than one child
+    bool optional;          // TEXT leaves out an empty group, label included
+};
+
+// Everything the formats need to know about one node
+struct NodeView {
+    const char* kind;
+    Attr attrs[4];
+    int attrCount;
+    Group groups[3];
+    int groupCount;
+    const std::vector<Parameter>* parameters;   // FunctionDeclNode only
+    std::string* header;    // TEXT line and DOT label; nullptr for JSON/S-expressions
+    char number[32];        // formatted literal value
+};
+
+template <typename Node>
+const ASTNode* itemAt(const void* items, size_t i) {
+    return static_cast<Node* const*>(items)[i];
+}
+
+void addAttr(NodeView& view, const char* key, const char* data, size_t size, bool quoted) {
+    view.attrs[view.attrCount++] = Attr{key, data, size, quoted};
+}
+
+void addAttr(NodeView& view, const char* key, const std::string& value) {
+    addAttr(view, key, value.data(), value.size(), true);
+}
+
+void addRaw(NodeView& view, const char* key, const char* value) {
+    addAttr(view, key, value, std::strlen(value), false);
+}
+
+template <typename Node>
+void addChild(NodeView& view, const char* key, const char* label, Node* const& child,
+              bool optional = false) {
+    view.groups[view.groupCount++] =
+        Group{key, label, &child, child ? 1u : 0u, itemAt<Node>, false, optional};
+}
+
+template <typename Node>
+void addList(NodeView& view, const char* key, const char* label,
+             const std::vector<Node*>& items, bool optional = false) {
+    view.groups[view.groupCount++] =
+        Group{key, label, items.data(), items.size(), itemAt<Node>, true, optional};
+}
+
+// TEXT keeps ostream's default "%g"; the structured formats print the
+// shortest form that reads back as the same double
+void formatFloat(NodeView& view, double value, DumpFormat format) {
+    if (format == DumpFormat::TEXT || format == DumpFormat::DOT) {
+        std::snprintf(view.number, sizeof(view.number), "%g", value);
+    } else if (format == DumpFormat::JSON && !std::isfinite(value)) {
+        std::snprintf(view.number, sizeof(view.number), "null");
+    } else {
+        std::snprintf(view.number, sizeof(view.number), "%.15g", value);
+        if (std::strtod(view.number, nullptr) != value) {
+            std::snprintf(view.number, sizeof(view.number), "%.17g", value);
+        }
+    }
+}
+
+const char* boolName(bool value) {
+    return value ? "true" : "false";
+}
+
+void describe(const ASTNode* node, DumpFormat format, NodeView& view) {
+    view.attrCount = 0;
+    view.groupCount = 0;
+    view.parameters = nullptr;
+    std::string* header = view.header;
+    if (header) {
+        header->clear();
+    }
+    if (dynamic_cast<const ExprNode*>(node)) {
+        addAttr(view, "type", dataTypeName(node->dataType));
+    }
+
+    if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        view.kind = "BinaryOpNode";
+        addAttr(view, "op", binary->op);
+        addChild(view, "left", nullptr, binary->left);
+        addChild(view, "right", nullptr, binary->right);
+        if (header) header->append("BinaryOpNode: ").append(binary->op);
+    } else if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+        view.kind = "IdentifierNode";
+        addAttr(view, "name", identifier->name);
+        if (header) header->append("IdentifierNode: ").append(identifier->name);
+    } else if (auto integer = dynamic_cast<const IntegerNode*>(node)) {
+        view.kind = "IntegerNode";
+        std::snprintf(view.number, sizeof(view.number), "%d", integer->value);
+        addRaw(view, "value", view.number);
+        if (header) header->append("Integer: ").append(view.number);
+    } else if (auto floating = dynamic_cast<const FloatNode*>(node)) {
+        view.kind = "FloatNode";
+        formatFloat(view, floating->value, format);
+        addRaw(view, "value", view.number);
+        if (header) header->append("Float: ").append(view.number);
+    } else if (auto boolean = dynamic_cast<const BoolNode*>(node)) {
+        view.kind = "BoolNode";
+        addRaw(view, "value", boolName(boolean->value));
+        if (header) header->append("Bool: ").append(boolName(boolean->value));
+    } else if (auto literal = dynamic_cast<const LiteralNode*>(node)) {
+        view.kind = "LiteralNode";
+        const char* literalType = "bool";
+        const char* value = "";
+        if (literal->litType == LiteralNode::LiteralType::BOOL) {
+            value = boolName(literal->boolValue);
+        } else if (literal->litType == LiteralNode::LiteralType::INT) {
+            std::snprintf(view.number, sizeof(view.number), "%d", literal->intValue);
+            literalType = "int";
+            value = view.number;
+        } else if (literal->litType == LiteralNode::LiteralType::FLOAT) {
+            formatFloat(view, literal->floatValue, format);
+            literalType = "float";
+            value = view.number;
+        }
+        addRaw(view, "value", value);
+        addAttr(view, "literalType", literalType, std::strlen(literalType), true);
+        if (header) {
+            header->append("LiteralNode: ").append(value).append(" (").append(literalType)
+                .append(")");
+        }
+    } else if (auto unary = dynamic_cast<const UnaryOpNode*>(node)) {
+        view.kind = "UnaryOpNode";
+        addAttr(view, "op", unary->op);
+        addChild(view, "operand", nullptr, unary->operand);
+        if (header) header->append("UnaryOpNode: ").append(unary->op);
+    } else if (auto call = dynamic_cast<const FunctionCallNode*>(node)) {
+        view.kind = "FunctionCallNode";
+        addAttr(view, "name", call->functionName);
+        addList(view, "arguments", nullptr, call->arguments);
+        if (header) header->append("FunctionCallNode: ").append(call->functionName);
+    } else if (auto assignment = dynamic_cast<const AssignmentStmtNode*>(node)) {
+        view.kind = "AssignmentStmtNode";
+        addAttr(view, "name", assignment->variableName);
+        addChild(view, "value", nullptr, assignment->value);
+        if (header) header->append("AssignmentStmtNode: ").append(assignment->variableName)
+            .append(" =");
+    } else if (auto varDecl = dynamic_cast<const VarDeclNode*>(node)) {
+        view.kind = "VarDeclNode";
+        addAttr(view, "name", varDecl->name);
+        addAttr(view, "declaredType", varDecl->typeNode->typeName);
+        addRaw(view, "constant", boolName(varDecl->isConstant));
+        addChild(view, "initializer", nullptr, varDecl->initializer, true);
+        if (header) {
+            header->append(varDecl->isConstant ? "ConstDeclNode: " : "VarDeclNode: ")
+                .append(varDecl->name).append(" : ").append(varDecl->typeNode->typeName);
+            if (varDecl->initializer) header->append(" =");
+        }
+    } else if (auto ifStmt = dynamic_cast<const IfStmtNode*>(node)) {
+        view.kind = "IfStmtNode";
+        addChild(view, "condition", "Condition:", ifStmt->condition);
+        addList(view, "then", "Then:", ifStmt->thenItems);
+        addList(view, "else", "Else:", ifStmt->elseItems, true);
+        if (header) header->append("IfStmtNode:");
+    } else if (auto whileStmt = dynamic_cast<const WhileStmtNode*>(node)) {
+        view.kind = "WhileStmtNode";
+        addChild(view, "condition", "Condition:", whileStmt->condition);
+        addList(view, "body", "Body:", whileStmt->bodyItems);
+        if (header) header->append("WhileStmtNode:");
+    } else if (auto returnStmt = dynamic_cast<const ReturnStmtNode*>(node)) {
+        view.kind = "ReturnStmtNode";
+        addChild(view, "value", nullptr, returnStmt->value, true);
+        if (header) header->append(returnStmt->value ? "ReturnStmtNode:" : "ReturnStmtNode");
+    } else if (auto printStmt = dynamic_cast<const PrintStmtNode*>(node)) {
+        view.kind = "PrintStmtNode";
+        addChild(view, "expression", nullptr, printStmt->expression);
+        if (header) header->append("PrintStmtNode:");
+    } else if (auto function = dynamic_cast<const FunctionDeclNode*>(node)) {
+        view.kind = "FunctionDeclNode";
+        addAttr(view, "name", function->name);
+        addAttr(view, "returnType", dataTypeName(function->returnType));
+        view.parameters = &function->parameters;
+        addList(view, "body", "Body:", function->bodyItems);
+        if (header) {
+            header->append("FunctionDeclNode: ").append(function->name).append("(");
+            for (size_t i = 0; i < function->parameters.size(); ++i) {
+                if (i > 0) header->append(", ");
+                header->append(function->parameters[i].name).append(":")
+                    .append(dataTypeName(function->parameters[i].type));
+            }
+            header->append(") -> ").append(dataTypeName(function->returnType));
+        }
+    } else if (auto program = dynamic_cast<const ProgramNode*>(node)) {
+        view.kind = "ProgramNode";
+        addList(view, "declarations", nullptr, program->declarations);
+        if (header) header->append("ProgramNode:");
+    } else if (auto block = dynamic_cast<const BlockNode*>(node)) {
+        view.kind = "BlockNode";
+        addList(view, "items", nullptr, block->items);
+        if (header) header->append("BlockNode:");
+    } else if (auto assign = dynamic_cast<const AssignmentNode*>(node)) {
+        view.kind = "AssignmentNode";
+        addAttr(view, "name", assign->variableName);
+        addChild(view, "value", nullptr, assign->value);
+        if (header) header->append("AssignmentNode: ").append(assign->variableName).append(" :=");
+    } else if (auto ifNode = dynamic_cast<const IfNode*>(node)) {
+        view.kind = "IfNode";
+        addChild(view, "condition", "Condition:", ifNode->condition);
+        addChild(view, "then", "Then:", ifNode->thenBranch);
+        addChild(view, "else", "Else:", ifNode->elseBranch, true);
+        if (header) header->append("IfNode:");
+    } else if (auto whileNode = dynamic_cast<const WhileNode*>(node)) {
+        view.kind = "WhileNode";
+        addChild(view, "condition", "Condition:", whileNode->condition);
+        addChild(view, "body", "Body:", whileNode->body);
+        if (header) header->append("WhileNode:");
+    } else if (auto returnNode = dynamic_cast<const ReturnNode*>(node)) {
+        view.kind = "ReturnNode";
+        addChild(view, "value", nullptr, returnNode->value, true);
+        if (header) header->append(returnNode->value ? "ReturnNode:" : "ReturnNode");
+    } else if (auto printNode = dynamic_cast<const PrintNode*>(node)) {
+        view.kind = "PrintNode";
+        addChild(view, "expression", nullptr, printNode->expression);
+        if (header) header->append("PrintNode:");
+    } else if (auto exprStmt = dynamic_cast<const ExprStmtNode*>(node)) {
+        view.kind = "ExprStmtNode";
+        addChild(view, "expression", nullptr, exprStmt->expression);
+        if (header) header->append("ExprStmtNode:");
+    } else {
+        view.kind = "ASTNode";
+        if (header) header->append("ASTNode");
+    }
+}
+
+// ============================================================================
+// OUTPUT HELPERS
+// ============================================================================
+
+void writeString(DumpWriter& out, const char* s) {
+    out.write(s, std::strlen(s));
+}
+
+void writeString(DumpWriter& out, const std::string& s) {
+    out.write(s.data(), s.size());
+}
+
+void writeUnsigned(DumpWriter& out, size_t value) {
+    char digits[24];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    out.write(p, static_cast<size_t>(end - p));
+}
+
+// JSON string literal; S-expression strings use the same escapes
+void writeQuoted(DumpWriter& out, const char* data, size_t size) {
+    out.put('"');
+    for (size_t i = 0; i < size; ++i) {
+        char c = data[i];
+        switch (c) {
+            case '"': out.write("\\\"", 2); break;
+            case '\\': out.write("\\\\", 2); break;
+            case '\n': out.write("\\n", 2); break;
+            case '\t': out.write("\\t", 2); break;
+            case '\r': out.write("\\r", 2); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    writeString(out, escaped);
+                } else {
+                    out.put(c);
+                }
+        }
+    }
+    out.put('"');
+}
+
+void writeQuoted(DumpWriter& out, const std::string& s) {
+    writeQuoted(out, s.data(), s.size());
+}
+
+void writeAttrValue(DumpWriter& out, const Attr& attr) {
+    if (attr.quoted) {
+        writeQuoted(out, attr.data, attr.size);
+    } else {
+        out.write(attr.data, attr.size);
+    }
+}
+
+// ============================================================================
+// FORMATS
+// ============================================================================
+
+// One line of the TEXT listing: a subtree, or a label such as "Then:" when
+// `node` is null
+struct TextStep {
+    const ASTNode* node;
+    const char* label;
+    int indent;
+};
+
+void dumpText(const ASTNode* root, DumpWriter& out, int indent) {
+    std::string header;
+    NodeView view;
+    view.header = &header;
+    std::vector<TextStep> pending;
+    pending.push_back(TextStep{root, nullptr, indent});
+    while (!pending.empty()) {
+        TextStep step = pending.back();
+        pending.pop_back();
+        out.spaces(step.indent);
+        if (!step.node) {
+            writeString(out, step.label);
+            out.put('\n');
+            continue;
+        }
+        describe(step.node, DumpFormat::TEXT, view);
+        writeString(out, header);
+        out.put('\n');
+
+        // Push what follows the header line, last first
+        for (int g = view.groupCount - 1; g >= 0; --g) {
+            const Group& group = view.groups[g];
+            if (group.optional && group.count == 0) {
+                continue;
+            }
+            int childIndent = step.indent + (group.label ? 4 : 2);
+            for (size_t i = group.count; i-- > 0;) {
+                if (const ASTNode* child = group.at(group.items, i)) {
+                    pending.push_back(TextStep{child, nullptr, childIndent});
+                }
+            }
+            if (group.label) {
+                pending.push_back(TextStep{nullptr, group.label, step.indent + 2});
+            }
+        }
+    }
+}
+
+// A piece of JSON or S-expression output: `before`, then `key` when set,
+// then `after`, then the subtree at `node` when set. Every string is a
+// literal, so the pending stack holds no copies.
+struct TokenStep {
+    const char* before;
+    const char* key;
+    const char* after;
+    const ASTNode* node;
+};
+
+void writeParametersJson(DumpWriter& out, const std::vector<Parameter>& parameters) {
+    writeString(out, ",\"parameters\":[");
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        writeString(out, i > 0 ? ",{\"name\":" : "{\"name\":");
+        writeQuoted(out, parameters[i].name);
+        writeString(out, ",\"type\":");
+        writeQuoted(out, dataTypeName(parameters[i].type));
+        out.put('}');
+    }
+    out.put(']');
+}
+
+void dumpJson(const ASTNode* root, DumpWriter& out) {
+    NodeView view;
+    view.header = nullptr;
+    std::vector<TokenStep> pending;
+    pending.push_back(TokenStep{"", nullptr, root ? "" : "null", root});
+    while (!pending.empty()) {
+        TokenStep step = pending.back();
+        pending.pop_back();
+        writeString(out, step.before);
+        if (step.key) {
+            out.put('"');
+            writeString(out, step.key);
+            writeString(out, "\":");
+        }
+        writeString(out, step.after);
+        if (!step.node) {
+            continue;
+        }
+
+        describe(step.node, DumpFormat::JSON, view);
+        writeString(out, "{\"kind\":\"");
+        writeString(out, view.kind);
+        out.put('"');
+        for (int a = 0; a < view.attrCount; ++a) {
+            writeString(out, ",\"");
+            writeString(out, view.attrs[a].key);
+            writeString(out, "\":");
+            writeAttrValue(out, view.attrs[a]);
+        }
+        if (view.parameters) {
+            writeParametersJson(out, *view.parameters);
+        }
+
+        pending.push_back(TokenStep{"}", nullptr, "", nullptr});
+        for (int g = view.groupCount - 1; g >= 0; --g) {
+            const Group& group = view.groups[g];
+            if (!group.list) {
+                pending.push_back(TokenStep{",", group.key, group.count ? "" : "null",
+                                            group.count ? group.at(group.items, 0) : nullptr});
+                continue;
+            }
+            pending.push_back(TokenStep{"]", nullptr, "", nullptr});
+            for (size_t i = group.count; i-- > 0;) {
+                const ASTNode* child = group.at(group.items, i);
+                pending.push_back(TokenStep{i > 0 ? "," : "", nullptr, child ? "" : "null", child});
+            }
+            pending.push_back(TokenStep{",", group.key, "[", nullptr});
+        }
+    }
+    out.put('\n');
+}
+
+void dumpSexpr(const ASTNode* root, DumpWriter& out) {
+    NodeView view;
+    view.header = nullptr;
+    std::vector<TokenStep> pending;
+    pending.push_back(TokenStep{"", nullptr, root ? "" : "nil", root});
+    while (!pending.empty()) {
+        TokenStep step = pending.back();
+        pending.pop_back();
+        writeString(out, step.before);
+        if (step.key) {
+            writeString(out, step.key);
+        }
+        writeString(out, step.after);
+        if (!step.node) {
+            continue;
+        }
+
+        describe(step.node, DumpFormat::SEXPR, view);
+        out.put('(');
+        writeString(out, view.kind);
+        for (int a = 0; a < view.attrCount; ++a) {
+            writeString(out, " :");
+            writeString(out, view.attrs[a].key);
+            out.put(' ');
+            writeAttrValue(out, view.attrs[a]);
+        }
+        if (view.parameters) {
+            writeString(out, " :parameters (");
+            for (size_t i = 0; i < view.parameters->size(); ++i) {
+                writeString(out, i > 0 ? " (" : "(");
+                writeQuoted(out, (*view.parameters)[i].name);
+                out.put(' ');
+                writeQuoted(out, dataTypeName((*view.parameters)[i].type));
+                out.put(')');
+            }
+            out.put(')');
+        }
+
+        // Labelled groups become (key child ...); the rest follow inline
+        pending.push_back(TokenStep{")", nullptr, "", nullptr});
+        for (int g = view.groupCount - 1; g >= 0; --g) {
+            const Group& group = view.groups[g];
+            if (group.label) {
+                pending.push_back(TokenStep{")", nullptr, "", nullptr});
+            }
+            for (size_t i = group.count; i-- > 0;) {
+                const ASTNode* child = group.at(group.items, i);
+                pending.push_back(TokenStep{" ", nullptr, child ? "" : "nil", child});
+            }
+            if (group.label) {
+                pending.push_back(TokenStep{" (", group.key, "", nullptr});
+            }
+        }
+    }
+    out.put('\n');
+}
+
+// DOT label text: quotes and backslashes escaped
+void writeDotEscaped(DumpWriter& out, const char* data, size_t size) {
+    size_t start = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] == '"' || data[i] == '\\') {
+            out.write(data + start, i - start);
+            out.put('\\');
+            start = i;
+        }
+    }
+    out.write(data + start, size - start);
+}
+
+struct DotStep {
+    const ASTNode* node;
+    size_t parent;
+    const char* edge;   // group key; nullptr for the root
+};
+
+void dumpDot(const ASTNode* root, DumpWriter& out) {
+    std::string header;
+    NodeView view;
+    view.header = &header;
+    std::vector<DotStep> pending;
+    if (root) {
+        pending.push_back(DotStep{root, 0, nullptr});
+    }
+    size_t nextId = 0;
+    writeString(out, "digraph AST {\n  node [shape=box, fontname=\"monospace\"];\n");
+    while (!pending.empty()) {
+        DotStep step = pending.back();
+        pending.pop_back();
+        size_t id = nextId++;
+
+        describe(step.node, DumpFormat::DOT, view);
+        writeString(out, "  n");
+        writeUnsigned(out, id);
+        writeString(out, " [label=\"");
+        // The TEXT header without its trailing colon
+        size_t length = header.size();
+        if (length > 0 && header[length - 1] == ':') {
+            --length;
+        }
+        writeDotEscaped(out, header.data(), length);
+        if (view.attrCount > 0 && std::strcmp(view.attrs[0].key, "type") == 0) {
+            writeString(out, "\\ntype: ");
+            out.write(view.attrs[0].data, view.attrs[0].size);
+        }
+        writeString(out, "\"];\n");
+        if (step.edge) {
+            writeString(out, "  n");
+            writeUnsigned(out, step.parent);
+            writeString(out, " -> n");
+            writeUnsigned(out, id);
+            writeString(out, " [label=\"");
+            writeString(out, step.edge);
+            writeString(out, "\"];\n");
+        }
+
+        for (int g = view.groupCount - 1; g >= 0; --g) {
+            const Group& group = view.groups[g];
+            for (size_t i = group.count; i-- > 0;) {
+                if (const ASTNode* child = group.at(group.items, i)) {
+                    pending.push_back(DotStep{child, id, group.key});
+                }
+            }
+        }
+    }
+    writeString(out, "}\n");
+}
+
+} // namespace
+
+void dumpAST(const ASTNode* root, DumpFormat format, DumpWriter& out, int indent) {
+    switch (format) {
+        case DumpFormat::TEXT:
+            if (root) {
+                dumpText(root, out, indent);
+            }
+            break;
+        case DumpFormat::JSON:
+            dumpJson(root, out);
+            break;
+        case DumpFormat::SEXPR:
+            dumpSexpr(root, out);
+            break;
+        case DumpFormat::DOT:
+            dumpDot(root, out);
+            break;
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef AST_DUMP_HPP
+#define AST_DUMP_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <vector>
+#include "astnode.hpp"
+
+// AST dumps for ASTNode::print and semanticdriver --dump. Output is
+// formatted into one large buffer that is handed to write() (or to an
+// ostream) only when it fills up or on flush(), so a big tree costs a
+// handful of system calls instead of one per line.
+//
+//   TEXT   the indented listing ASTNode::print has always produced
+//   JSON   one object per node: {"kind": ..., attributes..., children...}
+//   SEXPR  (Kind :attribute value ... (group child ...) child ...)
+//   DOT    a Graphviz digraph, one box per node
+
+enum class DumpFormat {
+    TEXT,
+    JSON,
+    SEXPR,
+    DOT
+};
+
+// "text", "json", "sexpr" or "dot"; returns false for anything else
+bool parseDumpFormat(const char* name, DumpFormat& format);
+
+class DumpWriter {
+ private:
+    std::vector<char> buffer;
+    size_t used;
+    int fd;                 // -1 when writing to `stream`
+    std::ostream* stream;
+    bool error;
+    size_t writeCalls;
+
+    void writeOut(const char* data, size_t size);
+
+ public:
+    static constexpr size_t kDefaultCapacity = 1 << 20;
+
+    explicit DumpWriter(int fd, size_t capacity = kDefaultCapacity);
+    explicit DumpWriter(std::ostream& stream, size_t capacity = kDefaultCapacity);
+    ~DumpWriter();
+
+    DumpWriter(const DumpWriter&) = delete;
+    DumpWriter& operator=(const DumpWriter&) = delete;
+
+    void write(const char* data, size_t size) {
+        if (size > buffer.size() - used) {
+            flush();
+            if (size >= buffer.size()) {
+                writeOut(data, size);
+                return;
+            }
+        }
+        std::memcpy(buffer.data() + used, data, size);
+        used += size;
+    }
+
+    void put(char c) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = c;
+    }
+
+    void spaces(int count);
+
+    // Hand everything buffered to the fd or stream. The buffer keeps its
+    // capacity, so a writer can be reused for any number of dumps.
+    void flush();
+
+    // A write() failed (other than EINTR); later output is dropped
+    bool failed() const { return error; }
+
+    // Number of write() calls or ostream writes made so far
+    size_t writes() const { return writeCalls; }
+};
+
+// Dump the tree under `root` (which may be null). `indent` shifts the whole
+// TEXT listing right and is ignored by the other formats. Output stays in
+// `out` until it fills up or is flushed.
+void dumpAST(const ASTNode* root, DumpFormat format, DumpWriter& out, int indent = 0);
+
+#endif // AST_DUMP_HPP
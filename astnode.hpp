@@ -12,7 +12,9 @@
 #ifndef SCOPE_HPP
 #define SCOPE_HPP
 
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include "data_type.hpp"
@@ -29,78 +31,314 @@ struct SymbolInfo {
     SymbolKind kind;
     bool isConstant;
     
-    // For functions
-    std::vector<DataType> paramTypes;
-    DataType returnType;
+    // For functions: the ID of its return and parameter types in the
+    // analyzer's SignaturePool (see SemanticAnalyzer::signature)
+    static constexpr uint32_t kNoSignature = UINT32_MAX;
+    uint32_t signature;
     
     SymbolInfo() : type(DataType::IOTA), kind(SymbolKind::VARIABLE), 
-                   isConstant(false), returnType(DataType::IOTA) {}
+                   isConstant(false), signature(kNoSignature) {}
     
     SymbolInfo(const std::string& n, DataType t, SymbolKind k, bool constant = false)
-        : name(n), type(t), kind(k), isConstant(constant), returnType(DataType::IOTA) {}
+        : name(n), type(t), kind(k), isConstant(constant), signature(kNoSignature) {}
+};
+
+// Optional instrumentation for --stats. Every scope shares its parent's
+// counters, so attaching them to the global scope covers a whole analysis.
+struct ScopeCounters {
+    // Bucket i counts lookups that examined [2^i, 2^(i+1)) scopes; the last
+    // bucket takes everything deeper
+    static constexpr size_t kDepthBuckets = 12;
+    
+    uint64_t scopesCreated = 0;
+    uint64_t symbolsAdded = 0;
+    uint64_t lookups = 0;
+    uint64_t lookupDepth[kDepthBuckets] = {};
+    size_t peakDepth = 0;
+    
+    void recordScope(size_t depth) {
+        ++scopesCreated;
+        if (depth > peakDepth) peakDepth = depth;
+    }
+    
+    void recordLookup(size_t examined) {
+        ++lookups;
+        size_t bucket = 0;
+        while (examined > 1 && bucket + 1 < kDepthBuckets) {
+            examined >>= 1;
+            ++bucket;
+        }
+        ++lookupDepth[bucket];
+    }
 };
 
+// Symbols declared in one block. Scopes are owned and recycled by a
+// ScopeStack: reset() empties a scope in O(1) but keeps its symbol slots
+// (name strings included) and its hash table, so a block
+// that declares no more than an earlier one at the same depth allocates
+// nothing.
 class Scope {
  private:
-    std::map<std::string, std::unique_ptr<SymbolInfo>> table;
+    // Open addressing with linear probing. A bucket only counts as taken
+    // when it carries the scope's current generation, which is how reset()
+    // clears the table without touching it.
+    struct Bucket {
+        uint32_t generation;
+        uint32_t slot;
+        size_t hash;
+    };
+    
+    std::vector<std::unique_ptr<SymbolInfo>> slots;  // [0, used) are live
+    size_t used = 0;
+    std::vector<Bucket> buckets;                     // empty or a power of two
+    uint32_t generation = 1;
+    ScopeCounters* counters = nullptr;
+    size_t depth = 1;  // 1 for the global scope
+    
+    static size_t hashName(const std::string& name) {
+        return std::hash<std::string>()(name);
+    }
+    
+    SymbolInfo* find(const std::string& name, size_t hash) const {
+        if (used == 0) {
+            return nullptr;
+        }
+        size_t mask = buckets.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const Bucket& bucket = buckets[i];
+            if (bucket.generation != generation) {
+                return nullptr;
+            }
+            if (bucket.hash == hash && slots[bucket.slot]->name == name) {
+                return slots[bucket.slot].get();
+            }
+        }
+    }
     
- public:
-    std::shared_ptr<Scope> parent;
+    // The innermost declaration in this scope or a parent; `examined` is
+    // set to the number of scopes searched
+    SymbolInfo* findInChain(const std::string& name, size_t& examined) {
+        size_t hash = hashName(name);
+        examined = 0;
+        for (Scope* scope = this; scope; scope = scope->parent) {
+            ++examined;
+            if (SymbolInfo* info = scope->find(name, hash)) {
+                return info;
+            }
+        }
+        return nullptr;
+    }
     
-    explicit Scope(std::shared_ptr<Scope> parent = nullptr) : parent(parent) {}
+    void insertBucket(uint32_t slot, size_t hash) {
+        size_t mask = buckets.size() - 1;
+        size_t i = hash & mask;
+        while (buckets[i].generation == generation) {
+            i = (i + 1) & mask;
+        }
+        buckets[i] = Bucket{generation, slot, hash};
+    }
+    
+    // Double the table once it would pass half full
+    void reserveBucket() {
+        if ((used + 1) * 2 <= buckets.size()) {
+            return;
+        }
+        std::vector<Bucket> old;
+        old.swap(buckets);
+        buckets.assign(old.empty() ? 8 : old.size() * 2, Bucket{0, 0, 0});
+        for (const Bucket& bucket : old) {
+            if (bucket.generation == generation) {
+                insertBucket(bucket.slot, bucket.hash);
+            }
+        }
+    }
     
-    // Add a symbol to this scope
-    bool addSymbol(const std::string& name, std::unique_ptr<SymbolInfo> info) {
-        if (table.find(name) != table.end()) {
-            return false; // Already exists in this scope
+ public:
+    Scope* parent = nullptr;
+    
+    // Empty the scope and make it a child of `parentScope`, or a global
+    // scope reporting to `rootCounters` when that is null
+    void reset(Scope* parentScope, ScopeCounters* rootCounters = nullptr) {
+        parent = parentScope;
+        counters = parentScope ? parentScope->counters : rootCounters;
+        depth = parentScope ? parentScope->depth + 1 : 1;
+        clear();
+        if (counters) counters->recordScope(depth);
+    }
+    
+    // Drop every symbol but stay the same scope: same parent and counters,
+    // and not counted as a new scope
+    void clear() {
+        used = 0;
+        if (++generation == 0) {
+            for (Bucket& bucket : buckets) bucket.generation = 0;
+            generation = 1;
         }
-        table[name] = std::move(info);
-        return true;
+    }
+    
+    // Add a symbol to this scope and return it for the caller to fill in
+    // further; nullptr if the name is already declared here
+    SymbolInfo* addSymbol(const std::string& name, DataType type, SymbolKind kind,
+                          bool constant = false) {
+        size_t hash = hashName(name);
+        if (find(name, hash)) {
+            return nullptr; // Already exists in this scope
+        }
+        reserveBucket();
+        if (used == slots.size()) {
+            slots.push_back(std::make_unique<SymbolInfo>());
+        }
+        SymbolInfo* info = slots[used].get();
+        info->name = name;
+        info->type = type;
+        info->kind = kind;
+        info->isConstant = constant;
+        info->signature = SymbolInfo::kNoSignature;
+        insertBucket(static_cast<uint32_t>(used), hash);
+        ++used;
+        if (counters) ++counters->symbolsAdded;
+        return info;
     }
     
     // Look up a symbol in this scope only
     SymbolInfo* lookupLocal(const std::string& name) {
-        auto it = table.find(name);
-        if (it != table.end()) {
-            return it->second.get();
-        }
-        return nullptr;
+        return find(name, hashName(name));
     }
     
     // Look up a symbol in this scope and parent scopes
     SymbolInfo* lookup(const std::string& name) {
-        auto it = table.find(name);
-        if (it != table.end()) {
-            return it->second.get();
-        }
-        if (parent) {
-            return parent->lookup(name);
+        size_t examined;
+        SymbolInfo* info = findInChain(name, examined);
+        if (counters) counters->recordLookup(examined);
+        return info;
+    }
+    
+    // Same, but a name no open scope declares is then passed to `fallback`
+    // (name -> const SymbolInfo*), which stands behind the global scope and
+    // counts as one more scope examined
+    template <typename Fallback>
+    const SymbolInfo* lookup(const std::string& name, Fallback fallback) {
+        size_t examined;
+        if (SymbolInfo* info = findInChain(name, examined)) {
+            if (counters) counters->recordLookup(examined);
+            return info;
         }
-        return nullptr;
+        const SymbolInfo* info = fallback(name);
+        if (counters) counters->recordLookup(examined + 1);
+        return info;
     }
     
     // Check if symbol exists in this scope only
     bool existsLocal(const std::string& name) const {
-        return table.find(name) != table.end();
+        return find(name, hashName(name)) != nullptr;
+    }
+    
+    // Call visit(const SymbolInfo&) for each symbol in this scope, in
+    // declaration order
+    template <typename Visit>
+    void forEachSymbol(Visit visit) const {
+        for (size_t i = 0; i < used; ++i) {
+            visit(*slots[i]);
+        }
     }
 };
 
+// The chain of open scopes, innermost last, with plain pointers between
+// them. Popped scopes stay in the pool and are reset when pushed again.
+class ScopeStack {
+ private:
+    std::vector<std::unique_ptr<Scope>> pool;  // [0, active) are open
+    size_t active = 0;
+    
+ public:
+    // Close every scope and open a fresh global one
+    Scope* reset(ScopeCounters* counters = nullptr) {
+        active = 0;
+        Scope* global = push();
+        global->reset(nullptr, counters);
+        return global;
+    }
+    
+    // Open a child of the innermost scope and return it
+    Scope* push() {
+        if (active == pool.size()) {
+            pool.push_back(std::make_unique<Scope>());
+        }
+        Scope* scope = pool[active].get();
+        if (active > 0) {
+            scope->reset(pool[active - 1].get());
+        }
+        ++active;
+        return scope;
+    }
+    
+    // Close the innermost scope and return its parent
+    Scope* pop() {
+        --active;
+        return active ? pool[active - 1].get() : nullptr;
+    }
+    
+    // The global scope, or null before the first reset()
+    Scope* global() const { return active ? pool[0].get() : nullptr; }
+};
+
 #endif // SCOPE_HPP
 
 // Forward declarations
 class Visitor;
+class ASTNode;
+
+// The name operator<< prints for `type`, without building a stream each time
+const std::string& dataTypeName(DataType type);
+
+// Delete `node` and everything below it. Node destructors hand their
+// children to destroyNode instead of deleting them. Shallow subtrees are
+// deleted recursively as before; below kMaxDeleteDepth levels children are
+// queued on a heap worklist that the outermost call drains, so stack use
+// stays bounded however deep the tree is. The plain recursive step is inline
+// (defined after ASTNode); the outermost call and the queueing are not.
+inline void destroyNode(ASTNode* node);
+void destroyNodeOutOfLine(ASTNode* node);
+
+constexpr int kMaxDeleteDepth = 128;
+inline thread_local int deleteDepth = 0;   // destroyNode levels on this thread
+
+// Where a node's text starts and ends in the source, 1-based as the parser
+// counts it. Nodes built outside the parser keep all zeros.
+struct SourceSpan {
+    int firstLine = 0;
+    int firstColumn = 0;
+    int lastLine = 0;
+    int lastColumn = 0;
+};
 
 // Base class
 class ASTNode {
  public:
     virtual ~ASTNode() = default;
-    virtual void print(int indent = 0) const = 0;
+    
+    // Print the subtree to std::cout as indented text (see ast_dump.hpp)
+    void print(int indent = 0) const;
+    
     virtual void accept(Visitor& v) = 0;
     
     // For type checking
     DataType dataType = DataType::IOTA;
+    
+    // Set by the parser, for diagnostics
+    SourceSpan span;
 };
 
+inline void destroyNode(ASTNode* node) {
+    if (deleteDepth > 0 && deleteDepth < kMaxDeleteDepth) {
+        ++deleteDepth;
+        delete node;
+        --deleteDepth;
+        return;
+    }
+    destroyNodeOutOfLine(node);
+}
+
 // Expression base
 class ExprNode : public ASTNode {
  public:
@@ -164,10 +402,6 @@ class IntegerNode : public ExprNode {
         dataType = DataType::INT;
     }
     
-    void print(int indent = 0) const override {
-        std::cout << std::string(indent, ' ') << "Integer: " << value << std::endl;
-    }
-    
     void accept(Visitor& v) override;
 };
 
@@ -179,10 +413,6 @@ class FloatNode : public ExprNode {
         dataType = DataType::FLOAT;
     }
     
-    void print(int indent = 0) const override {
-        std::cout << std::string(indent, ' ') << "Float: " << value << std::endl;
-    }
-    
     void accept(Visitor& v) override;
 };
 
@@ -194,10 +424,6 @@ class BoolNode : public ExprNode {
         dataType = DataType::BOOL;
     }
     
-    void print(int indent = 0) const override {
-        std::cout << std::string(indent, ' ') << "Bool: " << (value ? "true" : "false") << std::endl;
-    }
-    
     void accept(Visitor& v) override;
 };
 
@@ -219,7 +445,6 @@ class LiteralNode : public ExprNode {
         dataType = DataType::BOOL;
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -229,7 +454,6 @@ class IdentifierNode : public ExprNode {
     
     explicit IdentifierNode(const std::string& n) : name(n) {}
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -243,11 +467,10 @@ class BinaryOpNode : public ExprNode {
         : left(l), op(o), right(r) {}
     
     ~BinaryOpNode() {
-        delete left;
-        delete right;
+        destroyNode(left);
+        destroyNode(right);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -259,10 +482,9 @@ class UnaryOpNode : public ExprNode {
     UnaryOpNode(const std::string& o, ExprNode* operand) : op(o), operand(operand) {}
     
     ~UnaryOpNode() {
-        delete operand;
+        destroyNode(operand);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -274,14 +496,13 @@ class FunctionCallNode : public ExprNode {
     explicit FunctionCallNode(const std::string& name) : functionName(name) {}
     
     ~FunctionCallNode() {
-        for (auto arg : arguments) delete arg;
+        for (auto arg : arguments) destroyNode(arg);
     }
     
     void addArgument(ExprNode* arg) {
         arguments.push_back(arg);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -294,10 +515,9 @@ class PrintStmtNode : public StmtNode {
     explicit PrintStmtNode(ExprNode* expr) : expression(expr) {}
     
     ~PrintStmtNode() {
-        delete expression;
+        destroyNode(expression);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -310,9 +530,9 @@ class IfStmtNode : public StmtNode {
     explicit IfStmtNode(ExprNode* cond) : condition(cond) {}
     
     ~IfStmtNode() {
-        delete condition;
-        for (auto item : thenItems) delete item;
-        for (auto item : elseItems) delete item;
+        destroyNode(condition);
+        for (auto item : thenItems) destroyNode(item);
+        for (auto item : elseItems) destroyNode(item);
     }
     
     void addThenItem(ASTNode* item) {
@@ -323,7 +543,6 @@ class IfStmtNode : public StmtNode {
         elseItems.push_back(item);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -335,15 +554,14 @@ class WhileStmtNode : public StmtNode {
     explicit WhileStmtNode(ExprNode* cond) : condition(cond) {}
     
     ~WhileStmtNode() {
-        delete condition;
-        for (auto item : bodyItems) delete item;
+        destroyNode(condition);
+        for (auto item : bodyItems) destroyNode(item);
     }
     
     void addBodyItem(ASTNode* item) {
         bodyItems.push_back(item);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -356,10 +574,9 @@ class AssignmentStmtNode : public StmtNode {
         : variableName(name), value(val) {}
     
     ~AssignmentStmtNode() {
-        delete value;
+        destroyNode(value);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -370,10 +587,9 @@ class ReturnStmtNode : public StmtNode {
     explicit ReturnStmtNode(ExprNode* val = nullptr) : value(val) {}
     
     ~ReturnStmtNode() {
-        delete value;
+        destroyNode(value);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -383,14 +599,13 @@ class BlockNode : public StmtNode {
     std::shared_ptr<Scope> scope;
     
     ~BlockNode() {
-        for (auto item : items) delete item;
+        for (auto item : items) destroyNode(item);
     }
     
     void addItem(CodeItemNode* item) {
         items.push_back(item);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -406,14 +621,13 @@ class VarDeclNode : public DeclNode {
     
     ~VarDeclNode() {
         delete typeNode;
-        delete initializer;
+        destroyNode(initializer);
     }
     
     DataType getDataType() const {
         return typeNode->toDataType();
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -426,10 +640,9 @@ class AssignmentNode : public StmtNode {
         : variableName(name), value(val) {}
     
     ~AssignmentNode() {
-        delete value;
+        destroyNode(value);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -443,12 +656,11 @@ class IfNode : public StmtNode {
         : condition(cond), thenBranch(thenB), elseBranch(elseB) {}
     
     ~IfNode() {
-        delete condition;
-        delete thenBranch;
-        delete elseBranch;
+        destroyNode(condition);
+        destroyNode(thenBranch);
+        destroyNode(elseBranch);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -460,11 +672,10 @@ class WhileNode : public StmtNode {
     WhileNode(ExprNode* cond, StmtNode* b) : condition(cond), body(b) {}
     
     ~WhileNode() {
-        delete condition;
-        delete body;
+        destroyNode(condition);
+        destroyNode(body);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -475,10 +686,9 @@ class ReturnNode : public StmtNode {
     explicit ReturnNode(ExprNode* val = nullptr) : value(val) {}
     
     ~ReturnNode() {
-        delete value;
+        destroyNode(value);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -489,10 +699,9 @@ class PrintNode : public StmtNode {
     explicit PrintNode(ExprNode* expr) : expression(expr) {}
     
     ~PrintNode() {
-        delete expression;
+        destroyNode(expression);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -503,10 +712,9 @@ class ExprStmtNode : public StmtNode {
     explicit ExprStmtNode(ExprNode* expr) : expression(expr) {}
     
     ~ExprStmtNode() {
-        delete expression;
+        destroyNode(expression);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -530,7 +738,7 @@ class FunctionDeclNode : public DeclNode {
         : name(n), returnType(retType->toDataType()) {}
     
     ~FunctionDeclNode() {
-        for (auto item : bodyItems) delete item;
+        for (auto item : bodyItems) destroyNode(item);
     }
     
     void addParameter(ParamNode* param) {
@@ -541,7 +749,6 @@ class FunctionDeclNode : public DeclNode {
         bodyItems.push_back(item);
     }
     
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -554,7 +761,6 @@ class ProgramNode : public ASTNode {
     
     ~ProgramNode();
     void addDecl(DeclNode* decl);
-    void print(int indent = 0) const override;
     void accept(Visitor& v) override;
 };
 
@@ -0,0 +1,204 @@
+// Steady-state heap allocations of semantic analysis. Every program is
+// parsed once; then a reused SemanticAnalyzer analyzes the whole set
+// --warmup times and once more with the allocation counters running. A warm
+// analyzer must check valid programs, calls, scopes and symbol insertion
+// included, without allocating. Prints CSV with the allocations per AST node
+// of each program and exits 1 if any is nonzero.
+//
+//   bench/alloc_check [--warmup N] [generator flags] [file...]
+//
+// Besides the files, the set has generated programs of several shapes and
+// one whose identifiers are too long for the short-string buffer. It runs in
+// two modes:
+//   plain   one analyzer for all programs, in turn
+//   shared  with shareGlobals() on, re-analyzing each program before moving
+//           to the next, like AnalysisContext on an edit loop; the cached
+//           function table must be reused instead of rebuilt
+//
+// Needs the counting allocator: build with `make clean alloc-check`.
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "alloc_stats.hpp"
+#include "astnode.hpp"
+#include "exception.hpp"
+#include "frontend.hpp"
+#include "semantic_analyzer.hpp"
+#include "stats.hpp"
+#include "program_generator.hpp"
+
+namespace {
+
+struct Program {
+    std::string name;
+    ASTNode* root;
+    uint64_t nodes;
+};
+
+// Names past the 15 characters std::string keeps inline, in nested scopes,
+// calls and a nested function
+const char* const kLongNames =
+    "func accumulate_running_total(current_total_value: int, next_increment: int): int {\n"
+    "    func nested_validation_helper(candidate_value: int): bool {\n"
+    "        return candidate_value > 0;\n"
+    "    }\n"
+    "    var intermediate_sum_value: int = current_total_value + next_increment;\n"
+    "    return intermediate_sum_value;\n"
+    "}\n"
+    "func compute_weighted_average(first_sample_value: float, second_sample_value: float): float {\n"
+    "    return (first_sample_value + second_sample_value) / 2.0;\n"
+    "}\n"
+    "func main(): int {\n"
+    "    var loop_iteration_counter: int = 0;\n"
+    "    var accumulated_result_total: int = 0;\n"
+    "    while (loop_iteration_counter < 10) {\n"
+    "        var per_iteration_increment: int = loop_iteration_counter * 2;\n"
+    "        if (per_iteration_increment > 4) {\n"
+    "            var shadowing_inner_value_name: float = compute_weighted_average(1.5, 2.5);\n"
+    "            accumulated_result_total = accumulate_running_total(accumulated_result_total, per_iteration_increment);\n"
+    "        } else {\n"
+    "            accumulated_result_total = accumulated_result_total - 1;\n"
+    "        }\n"
+    "        loop_iteration_counter = loop_iteration_counter + 1;\n"
+    "    }\n"
+    "    return accumulated_result_total;\n"
+    "}\n";
+
+void addProgram(std::vector<Program>& programs, const std::string& name,
+                const std::string& source) {
+    ASTNode* root = parseSource(source);
+    if (!root) {
+        throw std::runtime_error(name + " failed to parse");
+    }
+    NodeCounts counts;
+    countNodes(root, counts);
+    programs.push_back(Program{name, root, counts.total()});
+}
+
+std::string readFile(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::string("cannot read ") + path);
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+void analyzeValid(SemanticAnalyzer& analyzer, const Program& program) {
+    analyzer.reset(program.root);
+    if (std::optional<SemanticError> error = analyzer.tryAnalyze()) {
+        throw std::runtime_error(program.name + " is not valid: " +
+                                 SemanticException(error->type, error->context).what());
+    }
+}
+
+// Counts one analysis of `program`; returns false if it allocated
+bool measure(const char* mode, SemanticAnalyzer& analyzer, const Program& program) {
+    AllocCounters before = threadAllocCounters();
+    analyzeValid(analyzer, program);
+    // A copy, taken before any output: threadAllocCounters() is live
+    AllocCounters after = threadAllocCounters();
+    uint64_t allocations = after.allocations - before.allocations;
+    std::cout << mode << "," << program.name << "," << program.nodes << "," << allocations << ","
+              << after.bytes - before.bytes << ","
+              << static_cast<double>(allocations) / static_cast<double>(program.nodes)
+              << std::endl;
+    if (allocations == 0) {
+        return true;
+    }
+    std::cerr << mode << " " << program.name << ": " << allocations << " allocations by site:";
+    for (size_t site = 0; site < kAllocSiteCount; ++site) {
+        if (uint64_t count = after.siteAllocations[site] - before.siteAllocations[site]) {
+            std::cerr << " " << allocSiteName(static_cast<AllocSite>(site)) << " " << count;
+        }
+    }
+    std::cerr << "\n";
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int warmup = 2;
+    GeneratorConfig config;
+    config.functions = 40;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            files.push_back(argv[i]);
+        } else if (!parseGeneratorFlag(i, argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0] << " [--warmup N] " << kGeneratorFlagsUsage
+                      << " [file...]\n";
+            return 1;
+        }
+    }
+    if (!kAllocStatsEnabled) {
+        std::cerr << "built without -DALLOC_STATS; use `make clean alloc-check`\n";
+        return 1;
+    }
+    if (warmup < 1) {
+        std::cerr << "--warmup must be positive\n";
+        return 1;
+    }
+
+    bool clean = true;
+    try {
+        std::vector<Program> programs;
+        for (const char* file : files) {
+            addProgram(programs, file, readFile(file));
+        }
+        addProgram(programs, "long_names", kLongNames);
+        // The given shape, then deeper/wider and call-heavy variants
+        const GeneratorConfig base = config;
+        for (unsigned seed = 1; seed <= 3; ++seed) {
+            config = base;
+            config.seed = seed;
+            addProgram(programs, "generated_" + std::to_string(seed), generateProgram(config));
+        }
+        config = base;
+        config.nestingDepth = base.nestingDepth * 2;
+        config.scopeWidth = base.scopeWidth * 2;
+        addProgram(programs, "generated_nested", generateProgram(config));
+        config = base;
+        config.callDensity = 0.5;
+        addProgram(programs, "generated_calls", generateProgram(config));
+
+        std::cout << "mode,program,nodes,allocations,bytes,allocs_per_node\n";
+        SemanticAnalyzer plain(nullptr);
+        for (int pass = 0; pass < warmup; ++pass) {
+            for (const Program& program : programs) {
+                analyzeValid(plain, program);
+            }
+        }
+        for (const Program& program : programs) {
+            clean = measure("plain", plain, program) && clean;
+        }
+
+        SemanticAnalyzer shared(nullptr);
+        shared.shareGlobals();
+        for (const Program& program : programs) {
+            for (int pass = 0; pass < warmup; ++pass) {
+                analyzeValid(shared, program);
+            }
+            clean = measure("shared", shared, program) && clean;
+        }
+
+        for (const Program& program : programs) {
+            delete program.root;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return clean ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#ifndef BENCH_UTIL_HPP
+#define BENCH_UTIL_HPP
+
+#include <chrono>
+
+// Timing helpers shared by the best-of-N bench tools
+
+// Milliseconds since `start`
+inline double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Keep the fastest sample; run 0 replaces whatever `best` held
+inline void keepBest(double& best, double sample, int run) {
+    if (run == 0 || sample < best) {
+        best = sample;
+    }
+}
+
+#endif // BENCH_UTIL_HPP
@@ -0,0 +1,159 @@
+// Times analysis, constant folding, AST printing and teardown per node on
+// shallow programs and on very deep ones: left-leaning `+` chains and nested
+// if blocks. All four walk explicit heap stacks, so the deep shapes must
+// finish (no stack overflow) and the shallow one must not get slower per
+// node.
+//
+//   bench/depth_bench [max-depth] [repeats]
+//
+// Trees are built in memory, bypassing the parser's own depth limit. Printing
+// indents two spaces per level, so its output grows with depth squared; it is
+// only timed up to depth 10^4 and reported as empty beyond that. Folding
+// rewrites the tree, so it runs on a second copy after teardown.
+
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include "ast_dump.hpp"
+#include "astnode.hpp"
+#include "bench_util.hpp"
+#include "constant_folder.hpp"
+#include "semantic_analyzer.hpp"
+#include "stats.hpp"
+
+namespace {
+
+constexpr long kMaxPrintDepth = 10000;
+
+FunctionDeclNode* newFunction(const std::string& name) {
+    TypeNode intType("int");
+    return new FunctionDeclNode(name, &intType);
+}
+
+VarDeclNode* newIntVar(const std::string& name, ExprNode* init) {
+    return new VarDeclNode(false, name, new TypeNode("int"), init);
+}
+
+// `functions` functions of `statements` assignments like
+// x = (x + 1) * (x - 2) + x * 3, i.e. expression depth 4
+ProgramNode* buildShallow(long functions, long statements) {
+    ProgramNode* program = new ProgramNode();
+    for (long f = 0; f < functions; ++f) {
+        FunctionDeclNode* fn = newFunction("f" + std::to_string(f));
+        fn->addBodyItem(newIntVar("x", new IntegerNode(1)));
+        for (long s = 0; s < statements; ++s) {
+            ExprNode* product = new BinaryOpNode(
+                new BinaryOpNode(new IdentifierNode("x"), "+", new IntegerNode(1)), "*",
+                new BinaryOpNode(new IdentifierNode("x"), "-", new IntegerNode(2)));
+            ExprNode* value = new BinaryOpNode(
+                product, "+", new BinaryOpNode(new IdentifierNode("x"), "*", new IntegerNode(3)));
+            fn->addBodyItem(new AssignmentStmtNode("x", value));
+        }
+        fn->addBodyItem(new ReturnStmtNode(new IdentifierNode("x")));
+        program->addDecl(fn);
+    }
+    return program;
+}
+
+// var x: int = 1 + 1 + ... + 1 with `depth` operators
+ProgramNode* buildChain(long depth) {
+    ExprNode* chain = new IntegerNode(1);
+    for (long i = 0; i < depth; ++i) {
+        chain = new BinaryOpNode(chain, "+", new IntegerNode(1));
+    }
+    FunctionDeclNode* fn = newFunction("main");
+    fn->addBodyItem(newIntVar("x", chain));
+    fn->addBodyItem(new ReturnStmtNode(new IdentifierNode("x")));
+    ProgramNode* program = new ProgramNode();
+    program->addDecl(fn);
+    return program;
+}
+
+// `depth` nested if (true) { ... } blocks around print(1)
+ProgramNode* buildNested(long depth) {
+    ASTNode* inner = new PrintStmtNode(new IntegerNode(1));
+    for (long i = 0; i < depth; ++i) {
+        IfStmtNode* ifStmt = new IfStmtNode(new BoolNode(true));
+        ifStmt->addThenItem(inner);
+        inner = ifStmt;
+    }
+    FunctionDeclNode* fn = newFunction("main");
+    fn->addBodyItem(inner);
+    fn->addBodyItem(new ReturnStmtNode(new IntegerNode(0)));
+    ProgramNode* program = new ProgramNode();
+    program->addDecl(fn);
+    return program;
+}
+
+// Build a fresh tree per run (teardown consumes it); best of `repeats`
+template <typename Build>
+void measure(const std::string& shape, long depth, int repeats, Build build) {
+    double analyzeMs = 0, foldMs = 0, printMs = 0, teardownMs = 0;
+    uint64_t nodes = 0;
+    bool timePrint = depth <= kMaxPrintDepth;
+    // The text dump print() writes, sent to /dev/null
+    int nullFd = open("/dev/null", O_WRONLY);
+    DumpWriter nullWriter(nullFd);
+
+    for (int run = 0; run < repeats; ++run) {
+        ProgramNode* program = build();
+        if (run == 0) {
+            NodeCounts counts;
+            countNodes(program, counts);
+            nodes = counts.total();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        SemanticAnalyzer(program).analyze();
+        keepBest(analyzeMs, elapsedMs(start), run);
+
+        if (timePrint) {
+            start = std::chrono::steady_clock::now();
+            dumpAST(program, DumpFormat::TEXT, nullWriter);
+            nullWriter.flush();
+            keepBest(printMs, elapsedMs(start), run);
+        }
+
+        start = std::chrono::steady_clock::now();
+        delete program;
+        keepBest(teardownMs, elapsedMs(start), run);
+
+        program = build();
+        SemanticAnalyzer(program).analyze();
+        start = std::chrono::steady_clock::now();
+        ConstantFolder(program).fold();
+        keepBest(foldMs, elapsedMs(start), run);
+        delete program;
+    }
+
+    std::cout << shape << "," << depth << "," << nodes << "," << analyzeMs << ","
+              << foldMs << ",";
+    if (timePrint) std::cout << printMs;
+    std::cout << "," << teardownMs << "," << (analyzeMs * 1e6 / nodes) << ","
+              << (foldMs * 1e6 / nodes) << ",";
+    if (timePrint) std::cout << (printMs * 1e6 / nodes);
+    std::cout << "," << (teardownMs * 1e6 / nodes) << std::endl;
+    close(nullFd);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long maxDepth = argc > 1 ? std::atol(argv[1]) : 1000000;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::cout << "shape,depth,nodes,analyze_ms,fold_ms,print_ms,teardown_ms,"
+                 "analyze_ns_per_node,fold_ns_per_node,print_ns_per_node,"
+                 "teardown_ns_per_node\n";
+    measure("shallow", 4, repeats, [] { return buildShallow(2000, 100); });
+    for (long depth = 1000; depth <= maxDepth; depth *= 10) {
+        measure("chain", depth, repeats, [depth] { return buildChain(depth); });
+    }
+    for (long depth = 1000; depth <= maxDepth; depth *= 10) {
+        measure("nested", depth, repeats, [depth] { return buildNested(depth); });
+    }
+    return 0;
+}
@@ -0,0 +1,285 @@
+// AST dump throughput. Parses and analyzes one generated program, then dumps
+// it the way ASTNode::print used to (an iostream insertion per token and
+// std::endl, i.e. a flush, after every line) and through DumpWriter in each
+// --dump format.
+//
+//   bench/dump_bench [--out PATH] [--repeat N] [generator flags]
+//
+// Output goes to PATH (default /dev/null, which still costs a system call
+// per write). Prints CSV: bytes written, write() calls, best-of-N time and
+// throughput per format.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <unistd.h>
+#include "ast_dump.hpp"
+#include "astnode.hpp"
+#include "data_type.hpp"
+#include "frontend.hpp"
+#include "program_generator.hpp"
+#include "semantic_analyzer.hpp"
+
+namespace {
+
+// An fd-backed streambuf with a BUFSIZ-sized buffer like std::cout's when
+// it is redirected to a file, counting its write() calls
+class FdBuffer : public std::streambuf {
+ private:
+    int fd;
+    char buffer[8192];
+
+    void drain() {
+        const char* data = pbase();
+        size_t size = static_cast<size_t>(pptr() - pbase());
+        while (size > 0) {
+            ++writes;
+            ssize_t written = ::write(fd, data, size);
+            if (written <= 0) {
+                throw std::runtime_error("write failed");
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        setp(buffer, buffer + sizeof(buffer));
+    }
+
+ protected:
+    int overflow(int c) override {
+        drain();
+        if (c != traits_type::eof()) {
+            *pptr() = static_cast<char>(c);
+            pbump(1);
+        }
+        return c;
+    }
+
+    int sync() override {
+        drain();
+        return 0;
+    }
+
+ public:
+    size_t writes = 0;
+
+    explicit FdBuffer(int fd) : fd(fd) { setp(buffer, buffer + sizeof(buffer)); }
+};
+
+void printIndent(std::ostream& out, int indent) {
+    for (int i = 0; i < indent; ++i) out << " ";
+}
+
+template <typename Node>
+void legacyItems(std::ostream& out, const std::vector<Node*>& items, int indent);
+
+// The pre-DumpWriter printer for the node kinds the parser builds
+void legacyPrint(std::ostream& out, const ASTNode* node, int indent) {
+    printIndent(out, indent);
+    if (auto program = dynamic_cast<const ProgramNode*>(node)) {
+        out << "ProgramNode:" << std::endl;
+        legacyItems(out, program->declarations, indent + 2);
+    } else if (auto function = dynamic_cast<const FunctionDeclNode*>(node)) {
+        out << "FunctionDeclNode: " << function->name << "(";
+        for (size_t i = 0; i < function->parameters.size(); ++i) {
+            out << function->parameters[i].name << ":" << function->parameters[i].type;
+            if (i < function->parameters.size() - 1) out << ", ";
+        }
+        out << ") -> " << function->returnType << std::endl;
+        printIndent(out, indent + 2);
+        out << "Body:" << std::endl;
+        legacyItems(out, function->bodyItems, indent + 4);
+    } else if (auto varDecl = dynamic_cast<const VarDeclNode*>(node)) {
+        out << (varDecl->isConstant ? "ConstDeclNode: " : "VarDeclNode: ") << varDecl->name
+            << " : " << varDecl->typeNode->typeName;
+        if (varDecl->initializer) {
+            out << " =" << std::endl;
+            legacyPrint(out, varDecl->initializer, indent + 2);
+        } else {
+            out << std::endl;
+        }
+    } else if (auto ifStmt = dynamic_cast<const IfStmtNode*>(node)) {
+        out << "IfStmtNode:" << std::endl;
+        printIndent(out, indent + 2);
+        out << "Condition:" << std::endl;
+        legacyPrint(out, ifStmt->condition, indent + 4);
+        printIndent(out, indent + 2);
+        out << "Then:" << std::endl;
+        legacyItems(out, ifStmt->thenItems, indent + 4);
+        if (!ifStmt->elseItems.empty()) {
+            printIndent(out, indent + 2);
+            out << "Else:" << std::endl;
+            legacyItems(out, ifStmt->elseItems, indent + 4);
+        }
+    } else if (auto whileStmt = dynamic_cast<const WhileStmtNode*>(node)) {
+        out << "WhileStmtNode:" << std::endl;
+        printIndent(out, indent + 2);
+        out << "Condition:" << std::endl;
+        legacyPrint(out, whileStmt->condition, indent + 4);
+        printIndent(out, indent + 2);
+        out << "Body:" << std::endl;
+        legacyItems(out, whileStmt->bodyItems, indent + 4);
+    } else if (auto assignment = dynamic_cast<const AssignmentStmtNode*>(node)) {
+        out << "AssignmentStmtNode: " << assignment->variableName << " =" << std::endl;
+        legacyPrint(out, assignment->value, indent + 2);
+    } else if (auto returnStmt = dynamic_cast<const ReturnStmtNode*>(node)) {
+        out << "ReturnStmtNode";
+        if (returnStmt->value) {
+            out << ":" << std::endl;
+            legacyPrint(out, returnStmt->value, indent + 2);
+        } else {
+            out << std::endl;
+        }
+    } else if (auto printStmt = dynamic_cast<const PrintStmtNode*>(node)) {
+        out << "PrintStmtNode:" << std::endl;
+        legacyPrint(out, printStmt->expression, indent + 2);
+    } else if (auto binary = dynamic_cast<const BinaryOpNode*>(node)) {
+        out << "BinaryOpNode: " << binary->op << std::endl;
+        legacyPrint(out, binary->left, indent + 2);
+        legacyPrint(out, binary->right, indent + 2);
+    } else if (auto unary = dynamic_cast<const UnaryOpNode*>(node)) {
+        out << "UnaryOpNode: " << unary->op << std::endl;
+        legacyPrint(out, unary->operand, indent + 2);
+    } else if (auto call = dynamic_cast<const FunctionCallNode*>(node)) {
+        out << "FunctionCallNode: " << call->functionName << std::endl;
+        legacyItems(out, call->arguments, indent + 2);
+    } else if (auto identifier = dynamic_cast<const IdentifierNode*>(node)) {
+        out << "IdentifierNode: " << identifier->name << std::endl;
+    } else if (auto integer = dynamic_cast<const IntegerNode*>(node)) {
+        out << "Integer: " << integer->value << std::endl;
+    } else if (auto floating = dynamic_cast<const FloatNode*>(node)) {
+        out << "Float: " << floating->value << std::endl;
+    } else if (auto boolean = dynamic_cast<const BoolNode*>(node)) {
+        out << "Bool: " << (boolean->value ? "true" : "false") << std::endl;
+    } else {
+        throw std::runtime_error("legacy printer: unexpected node");
+    }
+}
+
+template <typename Node>
+void legacyItems(std::ostream& out, const std::vector<Node*>& items, int indent) {
+    for (auto item : items) legacyPrint(out, item, indent);
+}
+
+struct Result {
+    double ms = 0;
+    size_t bytes = 0;
+    size_t writes = 0;
+};
+
+// Best of `repeats` runs of `dump`, which returns its write() count
+template <typename Dump>
+Result measure(int repeats, size_t bytes, Dump dump) {
+    Result best;
+    best.bytes = bytes;
+    for (int run = 0; run < repeats; ++run) {
+        auto begin = std::chrono::steady_clock::now();
+        size_t writes = dump();
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - begin).count();
+        if (run == 0 || ms < best.ms) {
+            best.ms = ms;
+            best.writes = writes;
+        }
+    }
+    return best;
+}
+
+size_t dumpSize(const ASTNode* root, DumpFormat format) {
+    std::ostringstream text;
+    {
+        DumpWriter writer(text);
+        dumpAST(root, format, writer);
+    }
+    return text.str().size();
+}
+
+void report(const char* name, const Result& result, const Result& legacy) {
+    std::cout << name << "," << result.bytes << "," << result.writes << "," << result.ms << ","
+              << (result.bytes / 1e6) / (result.ms / 1e3) << "," << legacy.ms / result.ms
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string outPath = "/dev/null";
+    int repeats = 5;
+    GeneratorConfig config;
+    config.functions = 500;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeats = std::atoi(argv[++i]);
+        } else if (!parseGeneratorFlag(i, argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0] << " [--out PATH] [--repeat N] "
+                      << kGeneratorFlagsUsage << "\n";
+            return 1;
+        }
+    }
+
+    try {
+        ASTNode* root = parseSource(generateProgram(config));
+        if (!root) {
+            throw std::runtime_error("generated program failed to parse");
+        }
+        SemanticAnalyzer(root).analyze();
+
+        int fd = open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + outPath);
+        }
+        // Rewind between runs so a regular file holds only the last dump
+        struct stat info;
+        bool regularFile = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+        auto rewind = [fd, regularFile] {
+            if (regularFile && (lseek(fd, 0, SEEK_SET) != 0 || ftruncate(fd, 0) != 0)) {
+                throw std::runtime_error("cannot rewind the output file");
+            }
+        };
+
+        std::ostringstream legacyText;
+        legacyPrint(legacyText, root, 0);
+        Result legacy = measure(repeats, legacyText.str().size(), [&] {
+            rewind();
+            FdBuffer buffer(fd);
+            std::ostream out(&buffer);
+            legacyPrint(out, root, 0);
+            out.flush();
+            return buffer.writes;
+        });
+
+        DumpWriter writer(fd);
+        auto dumpWith = [&](DumpFormat format) {
+            return measure(repeats, dumpSize(root, format), [&] {
+                rewind();
+                size_t before = writer.writes();
+                dumpAST(root, format, writer);
+                writer.flush();
+                return writer.writes() - before;
+            });
+        };
+
+        std::cout << "format,bytes,writes,best_ms,mb_per_s,speedup_vs_legacy\n";
+        report("legacy_text", legacy, legacy);
+        report("text", dumpWith(DumpFormat::TEXT), legacy);
+        report("json", dumpWith(DumpFormat::JSON), legacy);
+        report("sexpr", dumpWith(DumpFormat::SEXPR), legacy);
+        report("dot", dumpWith(DumpFormat::DOT), legacy);
+
+        close(fd);
+        delete root;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
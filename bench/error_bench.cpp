@@ -0,0 +1,130 @@
+// Invalid-input throughput: how many programs per second the analyzer can
+// reject, through the throwing analyze() and through tryAnalyze(). Each
+// program declares a helper, runs `pad` valid statements and then makes one
+// semantic error inside `depth` nested if/while blocks, like an edit in the
+// middle of a function. A valid program is timed as the reference.
+//
+//   bench/error_bench [depth] [pad] [analyses] [repeats]
+//
+// Programs are parsed once; only analysis is timed. Prints CSV with the
+// best-of-`repeats` cost per analysis in microseconds.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "astnode.hpp"
+#include "exception.hpp"
+#include "frontend.hpp"
+#include "semantic_analyzer.hpp"
+
+namespace {
+
+struct ErrorCase {
+    const char* name;
+    const char* statements;   // placed at the innermost nesting level
+};
+
+const ErrorCase kCases[] = {
+    {"valid",                 "x = x + helper(x, 2.5);"},
+    {"undeclared_identifier", "x = y + 1;"},
+    {"decl_type_mismatch",    "var b: bool = 1.5;"},
+    {"binary_operation",      "x = x + true;"},
+    {"unary_operation",       "x = -(x < 1);"},
+    {"condition_not_bool",    "while (x) { x = 0; }"},
+    {"assign_to_constant",    "let k: int = 1; k = 2;"},
+    {"wrong_arg_count",       "x = helper(x);"},
+    {"invalid_signature",     "x = helper(1.5, 2.5);"},
+    {"undeclared_function",   "x = missing(x);"},
+    {"unreachable_code",      "return x; x = 1;"},
+};
+
+std::string buildSource(const char* statements, int depth, int pad) {
+    std::string source = "func helper(a: int, b: float): int { return a; }\n"
+                         "func main(): int {\nvar x: int = 0;\n";
+    for (int i = 0; i < pad; ++i) {
+        source += "x = (x + " + std::to_string(i) + ") * 2 - helper(x, 1.0);\n";
+    }
+    for (int i = 0; i < depth; ++i) {
+        source += (i % 2 == 0) ? "if (x < 100) {\n" : "while (x > 100) {\n";
+    }
+    source += statements;
+    source += "\n";
+    for (int i = 0; i < depth; ++i) {
+        source += "}\n";
+    }
+    return source + "return x;\n}\n";
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+// Best-of-`repeats` microseconds per analysis; `rejected` counts failures
+template <typename Analyze>
+double measure(ASTNode* root, int analyses, int repeats, Analyze analyze, int& rejected) {
+    double best = 0;
+    for (int run = 0; run < repeats; ++run) {
+        rejected = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < analyses; ++i) {
+            rejected += analyze(root) ? 0 : 1;
+        }
+        double perAnalysis = elapsedUs(start) / analyses;
+        if (run == 0 || perAnalysis < best) {
+            best = perAnalysis;
+        }
+    }
+    return best;
+}
+
+bool analyzeThrowing(ASTNode* root) {
+    try {
+        SemanticAnalyzer(root).analyze();
+        return true;
+    } catch (const SemanticException&) {
+        return false;
+    }
+}
+
+bool analyzeResult(ASTNode* root) {
+    return !SemanticAnalyzer(root).tryAnalyze();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int depth = argc > 1 ? std::atoi(argv[1]) : 4;
+    int pad = argc > 2 ? std::atoi(argv[2]) : 0;
+    int analyses = argc > 3 ? std::atoi(argv[3]) : 20000;
+    int repeats = argc > 4 ? std::atoi(argv[4]) : 5;
+
+    try {
+        std::cout << "case,depth,pad,analyze_us,try_analyze_us,speedup\n";
+        for (const ErrorCase& errorCase : kCases) {
+            ASTNode* root = parseSource(buildSource(errorCase.statements, depth, pad));
+            if (!root) {
+                throw std::runtime_error(std::string(errorCase.name) + " failed to parse");
+            }
+
+            int thrown = 0, returned = 0;
+            double throwingUs = measure(root, analyses, repeats, analyzeThrowing, thrown);
+            double resultUs = measure(root, analyses, repeats, analyzeResult, returned);
+            bool expectValid = std::string(errorCase.name) == "valid";
+            if (thrown != returned || (thrown == 0) != expectValid) {
+                throw std::runtime_error(std::string(errorCase.name) +
+                                         " was not rejected as expected");
+            }
+            delete root;
+
+            std::cout << errorCase.name << "," << depth << "," << pad << "," << throwingUs << ","
+                      << resultUs << "," << (throwingUs / resultUs) << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Front-end benchmark suite. Generates programs of several shapes and times
+// lexing, parsing, semantic analysis and AST teardown separately, printing
+// one JSON document to stdout so runs can be compared across commits.
+//
+//   bench/frontend_bench [--repeat N] [--label TEXT] [generator flags]
+//
+// With generator flags, only that one configuration is measured (named
+// "custom"). Times are the best of N runs. lex_ms is a scan-only pass;
+// parse_ms is yyparse, which drives the scanner itself, so it includes
+// lexing again.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "astnode.hpp"
+#include "bench_util.hpp"
+#include "exception.hpp"
+#include "frontend.hpp"
+#include "json.hpp"
+#include "program_generator.hpp"
+#include "semantic_analyzer.hpp"
+
+namespace {
+
+struct Workload {
+    std::string name;
+    GeneratorConfig config;
+};
+
+struct PhaseTimes {
+    double lexMs = 0;
+    double parseMs = 0;
+    double analyzeMs = 0;
+    double teardownMs = 0;
+};
+
+std::vector<Workload> defaultWorkloads() {
+    std::vector<Workload> workloads;
+    auto add = [&](const std::string& name, int functions, int statements, int depth,
+                   int exprDepth, int scopeWidth, double callDensity) {
+        Workload w;
+        w.name = name;
+        w.config.functions = functions;
+        w.config.statementsPerFunction = statements;
+        w.config.nestingDepth = depth;
+        w.config.exprDepth = exprDepth;
+        w.config.scopeWidth = scopeWidth;
+        w.config.callDensity = callDensity;
+        workloads.push_back(w);
+    };
+    add("baseline",         500,   50,  3,  3,  4, 0.10);
+    add("many_functions", 10000,    5,  1,  2,  1, 0.10);
+    add("long_functions",    10, 5000,  3,  3,  4, 0.10);
+    add("deep_nesting",     200,  200, 40,  2,  2, 0.05);
+    add("deep_expressions", 200,   20,  2, 10,  4, 0.10);
+    add("wide_scopes",      200,  200,  3,  2, 64, 0.10);
+    add("call_heavy",       500,   50,  3,  3,  4, 0.60);
+    return workloads;
+}
+
+PhaseTimes measure(const std::string& source, int repeat, size_t& tokens) {
+    PhaseTimes best;
+    for (int run = 0; run < repeat; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        tokens = lexSource(source);
+        keepBest(best.lexMs, elapsedMs(start), run);
+
+        start = std::chrono::steady_clock::now();
+        ASTNode* root = parseSource(source);
+        keepBest(best.parseMs, elapsedMs(start), run);
+        if (!root) {
+            throw std::runtime_error("Generated program failed to parse");
+        }
+
+        // The analyzer owns the scope chain; destroying it is part of analysis
+        start = std::chrono::steady_clock::now();
+        {
+            SemanticAnalyzer analyzer(root);
+            analyzer.analyze();
+        }
+        keepBest(best.analyzeMs, elapsedMs(start), run);
+
+        start = std::chrono::steady_clock::now();
+        delete root;
+        keepBest(best.teardownMs, elapsedMs(start), run);
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int repeat = 5;
+    std::string label;
+    GeneratorConfig custom;
+    bool useCustom = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+                repeat = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+                label = argv[++i];
+            } else if (parseGeneratorFlag(i, argc, argv, custom)) {
+                useCustom = true;
+            } else {
+                std::cerr << "Usage: " << argv[0] << " [--repeat N] [--label TEXT] [options]\n"
+                          << kGeneratorFlagsUsage;
+                return 1;
+            }
+        }
+        if (repeat < 1) {
+            repeat = 1;
+        }
+
+        std::vector<Workload> workloads;
+        if (useCustom) {
+            workloads.push_back(Workload{"custom", custom});
+        } else {
+            workloads = defaultWorkloads();
+        }
+
+        std::cout << "{\n  \"label\": " << jsonString(label) << ",\n"
+                  << "  \"repeat\": " << repeat << ",\n"
+                  << "  \"results\": [\n";
+        for (size_t w = 0; w < workloads.size(); ++w) {
+            const Workload& workload = workloads[w];
+            const GeneratorConfig& c = workload.config;
+            std::string source = generateProgram(c);
+            size_t tokens = 0;
+            PhaseTimes t = measure(source, repeat, tokens);
+
+            std::cout << "    {\"name\": " << jsonString(workload.name)
+                      << ", \"functions\": " << c.functions
+                      << ", \"statements_per_function\": " << c.statementsPerFunction
+                      << ", \"nesting_depth\": " << c.nestingDepth
+                      << ", \"expr_depth\": " << c.exprDepth
+                      << ", \"scope_width\": " << c.scopeWidth
+                      << ", \"call_density\": " << c.callDensity
+                      << ", \"seed\": " << c.seed
+                      << ",\n     \"bytes\": " << source.size()
+                      << ", \"tokens\": " << tokens
+                      << ", \"lex_ms\": " << t.lexMs
+                      << ", \"parse_ms\": " << t.parseMs
+                      << ", \"analyze_ms\": " << t.analyzeMs
+                      << ", \"teardown_ms\": " << t.teardownMs << "}"
+                      << (w + 1 < workloads.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}\n";
+    } catch (const SemanticException& e) {
+        std::cerr << "Generated program failed analysis: " << e.what() << "\n";
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,25 @@
+// Writes a synthetic program to stdout, for profiling the front end on inputs
+// of a chosen shape.
+//
+//   bench/gen_program [generator flags] > program.txt
+
+#include <iostream>
+#include <stdexcept>
+#include "program_generator.hpp"
+
+int main(int argc, char** argv) {
+    GeneratorConfig config;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (!parseGeneratorFlag(i, argc, argv, config)) {
+                std::cerr << "Usage: " << argv[0] << " [options]\n" << kGeneratorFlagsUsage;
+                return 1;
+            }
+        }
+        std::cout << generateProgram(config);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// File ingestion throughput for many small files: the blocking per-file read
+// semanticdriver does by default (readSourceFile), FileIngestor's pread
+// fallback, and FileIngestor on io_uring with 1..256 reads in flight.
+//
+//   bench/ingest_bench [--files N] [--dir PATH] [--repeat N] [--drop-caches]
+//                      [generator flags]
+//
+// Writes N generated programs (small by default) into PATH, or into a fresh
+// directory under /tmp that is removed afterwards, then reads them all back
+// with each method. --drop-caches empties the page cache before every run
+// (needs root) so reads go to the device; otherwise the files are cached and
+// the numbers show the system call overhead. Prints CSV with the best of N
+// runs.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "frontend.hpp"
+#include "ingest.hpp"
+#include "program_generator.hpp"
+
+namespace {
+
+struct Result {
+    double ms = 0;
+    size_t bytes = 0;
+    size_t failed = 0;
+};
+
+void dropCaches() {
+    sync();
+    std::ofstream control("/proc/sys/vm/drop_caches");
+    if (!(control << "3\n")) {
+        throw std::runtime_error("--drop-caches: cannot write /proc/sys/vm/drop_caches");
+    }
+}
+
+template <typename Read>
+Result measure(int repeats, bool drop, Read read) {
+    Result best;
+    for (int run = 0; run < repeats; ++run) {
+        if (drop) {
+            dropCaches();
+        }
+        Result result;
+        auto begin = std::chrono::steady_clock::now();
+        read(result);
+        result.ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - begin).count();
+        if (run == 0 || result.ms < best.ms) {
+            best = result;
+        }
+    }
+    return best;
+}
+
+void report(const char* method, size_t depth, size_t files, const Result& result) {
+    if (result.failed) {
+        throw std::runtime_error(std::string(method) + ": " + std::to_string(result.failed) +
+                                 " files could not be read");
+    }
+    std::cout << method << "," << depth << "," << files << "," << result.bytes << ","
+              << result.ms << "," << files / (result.ms / 1e3) << ","
+              << (result.bytes / 1e6) / (result.ms / 1e3) << std::endl;
+}
+
+Result ingest(IngestBackend backend, size_t depth, const std::vector<std::string>& paths) {
+    Result result;
+    FileIngestor ingestor(backend, depth);
+    if (ingestor.backend() != backend) {
+        throw std::runtime_error("io_uring unavailable: " + ingestor.fallbackReason());
+    }
+    ingestor.readAll(paths, [&result](IngestedFile& file) {
+        result.bytes += file.contents.size();
+        result.failed += !file.ok;
+    });
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t fileCount = 20000;
+    std::string dir;
+    int repeats = 5;
+    bool drop = false;
+    GeneratorConfig config;
+    config.functions = 2;
+    config.statementsPerFunction = 20;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--files") == 0 && i + 1 < argc) {
+            fileCount = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeats = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--drop-caches") == 0) {
+            drop = true;
+        } else if (!parseGeneratorFlag(i, argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0] << " [--files N] [--dir PATH] [--repeat N] "
+                      << "[--drop-caches] " << kGeneratorFlagsUsage << "\n";
+            return 1;
+        }
+    }
+
+    bool ownDir = dir.empty();
+    std::vector<std::string> paths;
+    auto cleanUp = [&] {
+        if (ownDir) {
+            for (const std::string& path : paths) unlink(path.c_str());
+            rmdir(dir.c_str());
+        }
+    };
+    try {
+        if (ownDir) {
+            char pattern[] = "/tmp/ingest_benchXXXXXX";
+            if (!mkdtemp(pattern)) {
+                throw std::runtime_error("cannot create a directory under /tmp");
+            }
+            dir = pattern;
+        }
+        for (size_t i = 0; i < fileCount; ++i) {
+            config.seed = static_cast<unsigned>(i + 1);
+            paths.push_back(dir + "/p" + std::to_string(i) + ".txt");
+            std::ofstream out(paths.back(), std::ios::binary);
+            if (!(out << generateProgram(config))) {
+                throw std::runtime_error("cannot write " + paths.back());
+            }
+        }
+
+        std::cout << "method,depth,files,bytes,best_ms,files_per_s,mb_per_s\n";
+        report("ifstream", 1, paths.size(), measure(repeats, drop, [&](Result& result) {
+            std::string source;
+            for (const std::string& path : paths) {
+                result.failed += !readSourceFile(path, source);
+                result.bytes += source.size();
+            }
+        }));
+        report("pread", 1, paths.size(), measure(repeats, drop, [&](Result& result) {
+            result = ingest(IngestBackend::PREAD, 1, paths);
+        }));
+        for (size_t depth : {1, 8, 64, 256}) {
+            report("uring", depth, paths.size(), measure(repeats, drop, [&](Result& result) {
+                result = ingest(IngestBackend::IO_URING, depth, paths);
+            }));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        cleanUp();
+        return 1;
+    }
+    cleanUp();
+    return 0;
+}
@@ -0,0 +1,297 @@
+// Identifier interning throughput with 1..64 threads: ConcurrentInterner
+// against one std::unordered_map behind a global mutex, the table parser
+// threads would otherwise share.
+//
+//   bench/intern_bench [--max-threads N] [--tokens N] [--repeat N]
+//                      [--vocabulary N] [generator flags]
+//
+// Two identifier streams per thread:
+//   programs  the identifiers of a generated program (a different seed per
+//             thread), in source order: a few names like a, b and the
+//             function names recur everywhere, locals recur nearby
+//   zipf      --tokens draws from a vocabulary of --vocabulary camelCase and
+//             snake_case names with Zipf(1) frequencies, short names common
+//
+// "cold" starts each run with an empty table, so early tokens insert and
+// later ones mostly hit; "warm" runs the same streams against a table that
+// already holds every name (the wait-free path for ConcurrentInterner).
+// Prints CSV with the best of N runs.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "interner.hpp"
+#include "program_generator.hpp"
+
+namespace {
+
+using Stream = std::vector<std::string_view>;
+
+// The global-lock baseline
+class LockedInterner {
+ private:
+    std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> ids;
+
+ public:
+    uint32_t intern(std::string_view name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto inserted = ids.emplace(std::string(name), static_cast<uint32_t>(ids.size()));
+        return inserted.first->second;
+    }
+};
+
+bool isKeyword(const std::string& word) {
+    static const char* const keywords[] = {"func", "var", "let", "int", "float", "bool", "string",
+                                           "if", "else", "while", "return", "print", "true",
+                                           "false"};
+    for (const char* keyword : keywords) {
+        if (word == keyword) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Identifier tokens of `source`, stored in `storage`
+void identifiersOf(const std::string& source, std::vector<std::string>& storage) {
+    size_t i = 0;
+    while (i < source.size()) {
+        unsigned char c = static_cast<unsigned char>(source[i]);
+        if (std::isalpha(c) || c == '_') {
+            size_t start = i;
+            while (i < source.size() &&
+                   (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) {
+                ++i;
+            }
+            std::string word = source.substr(start, i - start);
+            if (!isKeyword(word)) {
+                storage.push_back(std::move(word));
+            }
+        } else if (std::isdigit(c)) {
+            while (i < source.size() && std::isalnum(static_cast<unsigned char>(source[i]))) {
+                ++i;
+            }
+        } else {
+            ++i;
+        }
+    }
+}
+
+// Names shaped like real ones: i, x, n up to tokenCount, parseExpression,
+// max_depth_limit2
+std::vector<std::string> makeVocabulary(size_t size, std::mt19937& rng) {
+    static const char* const words[] = {
+        "i", "j", "k", "n", "x", "y", "id", "count", "index", "value", "result", "node", "left",
+        "right", "size", "buffer", "offset", "name", "type", "scope", "token", "parse", "expr",
+        "depth", "max", "min", "total", "sum", "list", "item", "key", "map", "state", "next",
+        "prev", "first", "last", "start", "end", "limit", "temp", "flag", "error", "line",
+        "column", "symbol", "table", "entry", "hash", "visit", "check", "build", "make", "get",
+        "set", "is", "has", "to", "from", "with"};
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+    std::unordered_set<std::string> seen;
+    std::vector<std::string> names;
+    std::uniform_int_distribution<size_t> pick(0, wordCount - 1);
+    std::uniform_int_distribution<int> parts(1, 4), style(0, 3), digit(0, 9);
+    while (names.size() < size) {
+        std::string name;
+        int partCount = parts(rng);
+        bool snake = style(rng) == 0;
+        for (int p = 0; p < partCount; ++p) {
+            std::string word = words[pick(rng)];
+            if (p > 0 && snake) {
+                name += '_';
+            } else if (p > 0) {
+                word[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(word[0])));
+            }
+            name += word;
+        }
+        if (style(rng) == 0) {
+            name += static_cast<char>('0' + digit(rng));
+        }
+        if (seen.insert(name).second) {
+            names.push_back(name);
+        }
+    }
+    // Short names first, so they get the high Zipf ranks
+    std::stable_sort(names.begin(), names.end(), [](const std::string& a, const std::string& b) {
+        return a.size() < b.size();
+    });
+    return names;
+}
+
+Stream zipfStream(const std::vector<std::string>& vocabulary, size_t tokens, unsigned seed) {
+    std::vector<double> weights(vocabulary.size());
+    for (size_t r = 0; r < weights.size(); ++r) {
+        weights[r] = 1.0 / static_cast<double>(r + 1);
+    }
+    std::mt19937 rng(seed);
+    std::discrete_distribution<size_t> rank(weights.begin(), weights.end());
+    Stream stream;
+    stream.reserve(tokens);
+    for (size_t t = 0; t < tokens; ++t) {
+        stream.push_back(vocabulary[rank(rng)]);
+    }
+    return stream;
+}
+
+// Runs body(t) on `threads` threads that start together; returns wall ms
+template <typename Body>
+double runThreads(unsigned threads, Body body) {
+    std::mutex mutex;
+    std::condition_variable released;
+    bool go = false;
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                released.wait(lock, [&] { return go; });
+            }
+            body(t);
+        });
+    }
+    auto begin = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        go = true;
+    }
+    released.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+        .count();
+}
+
+template <typename Table>
+void internAll(Table& table, const Stream& stream) {
+    for (std::string_view name : stream) {
+        table.intern(name);
+    }
+}
+
+// Every thread must get one ID per name, and the IDs must map back
+void verify(const ConcurrentInterner& interner, const std::vector<Stream>& streams,
+            size_t distinct) {
+    if (interner.size() != distinct) {
+        throw std::runtime_error("interner holds " + std::to_string(interner.size()) +
+                                 " names, expected " + std::to_string(distinct));
+    }
+    for (const Stream& stream : streams) {
+        for (std::string_view name : stream) {
+            uint32_t id = interner.find(name);
+            if (id == ConcurrentInterner::kNoId || interner.name(id) != name) {
+                throw std::runtime_error("lost or mismatched name " + std::string(name));
+            }
+        }
+    }
+}
+
+void report(const char* workload, const char* table, const char* phase, unsigned threads,
+            uint64_t ops, double ms) {
+    std::cout << workload << "," << table << "," << phase << "," << threads << "," << ops << ","
+              << ms << "," << ops / (ms * 1e3) << std::endl;
+}
+
+void runWorkload(const char* workload, const std::vector<Stream>& allStreams, unsigned maxThreads,
+                 int repeats) {
+    std::unordered_set<std::string_view> names;
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<Stream> streams(allStreams.begin(), allStreams.begin() + threads);
+        uint64_t ops = 0;
+        names.clear();
+        for (const Stream& stream : streams) {
+            ops += stream.size();
+            names.insert(stream.begin(), stream.end());
+        }
+
+        double lockedCold = 0, lockedWarm = 0, shardedCold = 0, shardedWarm = 0;
+        for (int run = 0; run < repeats; ++run) {
+            LockedInterner locked;
+            double ms = runThreads(threads, [&](unsigned t) { internAll(locked, streams[t]); });
+            lockedCold = run == 0 ? ms : std::min(lockedCold, ms);
+            ms = runThreads(threads, [&](unsigned t) { internAll(locked, streams[t]); });
+            lockedWarm = run == 0 ? ms : std::min(lockedWarm, ms);
+
+            ConcurrentInterner sharded;
+            ms = runThreads(threads, [&](unsigned t) { internAll(sharded, streams[t]); });
+            shardedCold = run == 0 ? ms : std::min(shardedCold, ms);
+            verify(sharded, streams, names.size());
+            ms = runThreads(threads, [&](unsigned t) { internAll(sharded, streams[t]); });
+            shardedWarm = run == 0 ? ms : std::min(shardedWarm, ms);
+        }
+        report(workload, "mutex", "cold", threads, ops, lockedCold);
+        report(workload, "mutex", "warm", threads, ops, lockedWarm);
+        report(workload, "sharded", "cold", threads, ops, shardedCold);
+        report(workload, "sharded", "warm", threads, ops, shardedWarm);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    unsigned maxThreads = 64;
+    size_t tokens = 200000;
+    size_t vocabularySize = 50000;
+    int repeats = 3;
+    GeneratorConfig config;
+    config.functions = 200;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc) {
+            maxThreads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--tokens") == 0 && i + 1 < argc) {
+            tokens = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--vocabulary") == 0 && i + 1 < argc) {
+            vocabularySize = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeats = std::atoi(argv[++i]);
+        } else if (!parseGeneratorFlag(i, argc, argv, config)) {
+            std::cerr << "Usage: " << argv[0] << " [--max-threads N] [--tokens N] [--repeat N] "
+                      << "[--vocabulary N] " << kGeneratorFlagsUsage << "\n";
+            return 1;
+        }
+    }
+    if (maxThreads < 1 || repeats < 1 || vocabularySize < 1) {
+        std::cerr << "counts must be positive\n";
+        return 1;
+    }
+
+    try {
+        std::vector<std::vector<std::string>> programNames(maxThreads);
+        std::vector<Stream> programStreams;
+        for (unsigned t = 0; t < maxThreads; ++t) {
+            config.seed = t + 1;
+            identifiersOf(generateProgram(config), programNames[t]);
+            programStreams.emplace_back(programNames[t].begin(), programNames[t].end());
+        }
+
+        std::mt19937 rng(1);
+        std::vector<std::string> vocabulary = makeVocabulary(vocabularySize, rng);
+        std::vector<Stream> zipfStreams;
+        for (unsigned t = 0; t < maxThreads; ++t) {
+            zipfStreams.push_back(zipfStream(vocabulary, tokens, t + 1));
+        }
+
+        std::cout << "workload,table,phase,threads,tokens,best_ms,mtokens_per_s\n";
+        runWorkload("programs", programStreams, maxThreads, repeats);
+        runWorkload("zipf", zipfStreams, maxThreads, repeats);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
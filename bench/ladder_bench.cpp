@@ -0,0 +1,82 @@
+// Times SemanticAnalyzer::analyze on programs made of nested if/else
+// ladders, where every function's return paths run through the whole
+// nesting. The total number of if statements is fixed and the nesting
+// depth varies, so ns_per_if should stay flat.
+//
+//   bench/ladder_bench [total-ifs] [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "astnode.hpp"
+#include "semantic_analyzer.hpp"
+
+namespace {
+
+// if (x < 0) { return 0; } else { if (x < 1) { return 1; } else { ... } }
+// with every other level nesting in the then-branch instead, so both sides
+// of the if are exercised; the innermost else returns `depth`
+IfStmtNode* buildLadder(int level, int depth) {
+    IfStmtNode* ifStmt = new IfStmtNode(
+        new BinaryOpNode(new IdentifierNode("x"), "<", new IntegerNode(level)));
+    ASTNode* leaf = new ReturnStmtNode(new IntegerNode(level));
+    ASTNode* next = (level + 1 < depth)
+        ? static_cast<ASTNode*>(buildLadder(level + 1, depth))
+        : static_cast<ASTNode*>(new ReturnStmtNode(new IntegerNode(depth)));
+
+    if (level % 2 == 0) {
+        ifStmt->addThenItem(leaf);
+        ifStmt->addElseItem(next);
+    } else {
+        ifStmt->addThenItem(next);
+        ifStmt->addElseItem(leaf);
+    }
+    return ifStmt;
+}
+
+ProgramNode* buildProgram(int functions, int depth) {
+    ProgramNode* program = new ProgramNode();
+    for (int f = 0; f < functions; ++f) {
+        TypeNode intType("int");
+        FunctionDeclNode* fn = new FunctionDeclNode("f" + std::to_string(f), &intType);
+        ParamNode param("x", new TypeNode("int"));
+        fn->addParameter(&param);
+        fn->addBodyItem(buildLadder(0, depth));
+        program->addDecl(fn);
+    }
+    return program;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int totalIfs = argc > 1 ? std::atoi(argv[1]) : 1 << 18;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::cout << "depth,functions,ifs,analyze_ms,ns_per_if\n";
+    for (int depth : {4, 32, 256, 2048}) {
+        int functions = std::max(1, totalIfs / depth);
+        ProgramNode* program = buildProgram(functions, depth);
+
+        // Best of `repeats`; analyze() starts from a fresh global scope, so
+        // re-running it on the same tree is safe
+        double best = 0;
+        for (int r = 0; r < repeats; ++r) {
+            auto start = std::chrono::steady_clock::now();
+            SemanticAnalyzer(program).analyze();
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            if (r == 0 || ms < best) {
+                best = ms;
+            }
+        }
+
+        long long ifs = static_cast<long long>(functions) * depth;
+        std::cout << depth << "," << functions << "," << ifs << "," << best << ","
+                  << (best * 1e6 / ifs) << "\n";
+        delete program;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Stress test for deep nesting through the whole front end: generates source
+// text with one construct nested 10^3..max-depth levels and times parsing,
+// analysis and teardown. Per-level times should stay flat as depth grows,
+// i.e. the bison stack grows in amortized linear time instead of failing
+// with "memory exhausted" at YYMAXDEPTH.
+//
+//   bench/nesting_bench [max-depth] [repeats]
+//
+// Shapes: parens ((((1)))), neg - - - 1, and if/while blocks nested
+// directly inside each other. Prints CSV; exits non-zero if any program
+// fails to parse or analyze.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "astnode.hpp"
+#include "bench_util.hpp"
+#include "exception.hpp"
+#include "frontend.hpp"
+#include "semantic_analyzer.hpp"
+
+namespace {
+
+std::string repeat(const char* text, long count) {
+    std::string out;
+    for (long i = 0; i < count; ++i) {
+        out += text;
+    }
+    return out;
+}
+
+std::string wrapMain(const std::string& body) {
+    return "func main(): int {\n" + body + "return 0;\n}\n";
+}
+
+std::string parensProgram(long depth) {
+    return wrapMain("var x: int = " + repeat("(", depth) + "1" + repeat(")", depth) + ";\n");
+}
+
+std::string negProgram(long depth) {
+    // Spaces keep each `-` a token of its own
+    return wrapMain("var x: int = " + repeat("- ", depth) + "1;\n");
+}
+
+std::string ifProgram(long depth) {
+    return wrapMain(repeat("if (true) {\n", depth) + "print(1);\n" + repeat("}\n", depth));
+}
+
+std::string whileProgram(long depth) {
+    return wrapMain(repeat("while (false) {\n", depth) + "print(1);\n" + repeat("}\n", depth));
+}
+
+template <typename Generate>
+void measure(const std::string& shape, long depth, int repeats, Generate generate) {
+    std::string source = generate(depth);
+    double parseMs = 0, analyzeMs = 0, teardownMs = 0;
+
+    for (int run = 0; run < repeats; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        ASTNode* root = parseSource(source);
+        keepBest(parseMs, elapsedMs(start), run);
+        if (!root) {
+            throw std::runtime_error(shape + " at depth " + std::to_string(depth) +
+                                     " failed to parse");
+        }
+
+        start = std::chrono::steady_clock::now();
+        SemanticAnalyzer(root).analyze();
+        keepBest(analyzeMs, elapsedMs(start), run);
+
+        start = std::chrono::steady_clock::now();
+        delete root;
+        keepBest(teardownMs, elapsedMs(start), run);
+    }
+
+    std::cout << shape << "," << depth << "," << source.size() << "," << parseMs << ","
+              << analyzeMs << "," << teardownMs << "," << (parseMs * 1e6 / depth) << ","
+              << (analyzeMs * 1e6 / depth) << "," << (teardownMs * 1e6 / depth) << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long maxDepth = argc > 1 ? std::atol(argv[1]) : 1000000;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+
+    try {
+        std::cout << "shape,depth,bytes,parse_ms,analyze_ms,teardown_ms,"
+                     "parse_ns_per_level,analyze_ns_per_level,teardown_ns_per_level\n";
+        for (long depth = 1000; depth <= maxDepth; depth *= 10) {
+            measure("parens", depth, repeats, parensProgram);
+            measure("neg", depth, repeats, negProgram);
+            measure("if", depth, repeats, ifProgram);
+            measure("while", depth, repeats, whileProgram);
+        }
+    } catch (const SemanticException& e) {
+        std::cerr << "Nested program failed analysis: " << e.what() << "\n";
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
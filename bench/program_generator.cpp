@@ -0,0 +1,227 @@
+#include "program_generator.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+class Generator {
+ private:
+    const GeneratorConfig& config;
+    std::mt19937 rng;
+    std::string out;
+
+    int currentFunction = 0;
+    int nextName = 0;
+    int budget = 0;
+    std::vector<std::string> visible;  // variables in scope, innermost last
+
+    int randomInt(int lo, int hi) {
+        return std::uniform_int_distribution<int>(lo, hi)(rng);
+    }
+
+    bool chance(double p) {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p;
+    }
+
+    void indent(int depth) {
+        out.append(static_cast<size_t>(depth + 1) * 4, ' ');
+    }
+
+    std::string freshName(char prefix) {
+        return prefix + std::to_string(nextName++);
+    }
+
+    void emitLeaf(bool allowCalls) {
+        if (allowCalls && currentFunction > 0 && chance(config.callDensity)) {
+            out += "f" + std::to_string(randomInt(0, currentFunction - 1)) + "(";
+            emitLeaf(false);
+            out += ", ";
+            emitLeaf(false);
+            out += ")";
+        } else if (chance(0.7)) {
+            out += visible[randomInt(0, static_cast<int>(visible.size()) - 1)];
+        } else {
+            out += std::to_string(randomInt(0, 99));
+        }
+    }
+
+    // One side is always `depth - 1` high, so the tree reaches `depth`
+    void emitExpr(int depth) {
+        if (depth <= 0) {
+            emitLeaf(true);
+            return;
+        }
+        static const char* const ops[] = {" + ", " - ", " * "};
+        bool leftDeep = chance(0.5);
+        out += "(";
+        emitExpr(leftDeep ? depth - 1 : randomInt(0, depth - 1));
+        out += ops[randomInt(0, 2)];
+        emitExpr(leftDeep ? randomInt(0, depth - 1) : depth - 1);
+        out += ")";
+    }
+
+    void emitVarDecl(int depth) {
+        std::string name = freshName('v');
+        indent(depth);
+        out += "var " + name + ": int = ";
+        emitExpr(config.exprDepth);
+        out += ";\n";
+        visible.push_back(name);
+        --budget;
+    }
+
+    void emitSimple(int depth) {
+        indent(depth);
+        if (chance(0.75)) {
+            // Loop counters are never in `visible`, so loops stay bounded
+            out += visible[randomInt(0, static_cast<int>(visible.size()) - 1)] + " = ";
+            emitExpr(config.exprDepth);
+        } else {
+            out += "print(";
+            emitExpr(config.exprDepth);
+            out += ")";
+        }
+        out += ";\n";
+        --budget;
+    }
+
+    void emitIf(int depth, int bodyBudget, bool spine) {
+        indent(depth);
+        out += "if (";
+        emitExpr(config.exprDepth > 0 ? config.exprDepth - 1 : 0);
+        out += " < ";
+        emitExpr(config.exprDepth > 0 ? config.exprDepth - 1 : 0);
+        out += ") {\n";
+        --budget;
+        int thenBudget = spine ? bodyBudget - 1 : bodyBudget / 2 + 1;
+        emitBlock(depth + 1, thenBudget, spine);
+        indent(depth);
+        out += "} else {\n";
+        emitBlock(depth + 1, bodyBudget - thenBudget + 1, false);
+        indent(depth);
+        out += "}\n";
+    }
+
+    void emitWhile(int depth, int bodyBudget, bool spine) {
+        std::string counter = freshName('i');
+        indent(depth);
+        out += "var " + counter + ": int = 0;\n";
+        indent(depth);
+        out += "while (" + counter + " < " + std::to_string(randomInt(1, 4)) + ") {\n";
+        budget -= 2;
+        emitBlock(depth + 1, bodyBudget, spine);
+        indent(depth + 1);
+        out += counter + " = " + counter + " + 1;\n";
+        --budget;
+        indent(depth);
+        out += "}\n";
+    }
+
+    // Spend roughly `blockBudget` statements: scopeWidth declarations, then
+    // simple statements with an if or while now and then while depth allows.
+    // A spine block opens its first if/while straight away and hands it most
+    // of the budget, so each body reaches nestingDepth if the budget allows;
+    // random nesting alone halves the budget per level and stays shallow.
+    void emitBlock(int depth, int blockBudget, bool spine) {
+        size_t mark = visible.size();
+        int stop = budget - blockBudget;
+
+        for (int i = 0; i < config.scopeWidth; ++i) {
+            emitVarDecl(depth);
+        }
+        while (budget > stop && budget > 0) {
+            int remaining = budget - stop;
+            bool nest = depth < config.nestingDepth && remaining > 4;
+            if (nest && spine) {
+                int bodyBudget = remaining - 4;
+                if (chance(0.5)) {
+                    emitIf(depth, bodyBudget, true);
+                } else {
+                    emitWhile(depth, bodyBudget, true);
+                }
+                spine = false;
+            } else if (nest && chance(0.3)) {
+                int bodyBudget = randomInt(1, remaining / 2);
+                if (chance(0.5)) {
+                    emitIf(depth, bodyBudget, false);
+                } else {
+                    emitWhile(depth, bodyBudget, false);
+                }
+            } else {
+                emitSimple(depth);
+            }
+        }
+
+        visible.resize(mark);
+    }
+
+ public:
+    explicit Generator(const GeneratorConfig& config) : config(config), rng(config.seed) {}
+
+    std::string run() {
+        if (config.functions < 1 || config.statementsPerFunction < 1 || config.nestingDepth < 0 ||
+            config.exprDepth < 0 || config.scopeWidth < 0) {
+            throw std::runtime_error("Generator sizes must be positive");
+        }
+
+        for (currentFunction = 0; currentFunction < config.functions; ++currentFunction) {
+            nextName = 0;
+            out += "func f" + std::to_string(currentFunction) + "(a: int, b: int): int {\n";
+            visible = {"a", "b"};
+            budget = config.statementsPerFunction;
+            emitBlock(0, budget, true);
+            indent(0);
+            out += "return ";
+            emitExpr(config.exprDepth);
+            out += ";\n}\n\n";
+        }
+
+        out += "func main(): int {\n    print(f" + std::to_string(config.functions - 1) +
+               "(1, 2));\n    return 0;\n}\n";
+        return std::move(out);
+    }
+};
+
+} // namespace
+
+std::string generateProgram(const GeneratorConfig& config) {
+    return Generator(config).run();
+}
+
+const char* const kGeneratorFlagsUsage =
+    "  --functions N      number of functions (default 100)\n"
+    "  --statements N     statements per function, nested ones included (default 50)\n"
+    "  --depth N          maximum if/while nesting depth (default 3)\n"
+    "  --expr-depth N     arithmetic expression tree height (default 3)\n"
+    "  --scope-width N    variables declared at the top of each block (default 4)\n"
+    "  --call-density P   probability an expression leaf is a call (default 0.1)\n"
+    "  --seed N           random seed (default 1)\n";
+
+bool parseGeneratorFlag(int& i, int argc, char** argv, GeneratorConfig& config) {
+    const char* flag = argv[i];
+    int* intTarget = nullptr;
+    if (std::strcmp(flag, "--functions") == 0) intTarget = &config.functions;
+    else if (std::strcmp(flag, "--statements") == 0) intTarget = &config.statementsPerFunction;
+    else if (std::strcmp(flag, "--depth") == 0) intTarget = &config.nestingDepth;
+    else if (std::strcmp(flag, "--expr-depth") == 0) intTarget = &config.exprDepth;
+    else if (std::strcmp(flag, "--scope-width") == 0) intTarget = &config.scopeWidth;
+    else if (std::strcmp(flag, "--call-density") != 0 && std::strcmp(flag, "--seed") != 0) {
+        return false;
+    }
+
+    if (i + 1 >= argc) {
+        throw std::runtime_error(std::string("Missing value for ") + flag);
+    }
+    const char* value = argv[++i];
+    if (intTarget) {
+        *intTarget = std::atoi(value);
+    } else if (std::strcmp(flag, "--call-density") == 0) {
+        config.callDensity = std::atof(value);
+    } else {
+        config.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef PROGRAM_GENERATOR_HPP
+#define PROGRAM_GENERATOR_HPP
+
+#include <string>
+
+// Shape of a synthetic program. Generated programs pass semantic analysis.
+// Calls only go to earlier functions and every loop counts a dedicated
+// counter up to a small bound, so they also terminate when run, although the
+// call fan-out makes that slow for more than a handful of functions.
+struct GeneratorConfig {
+    int functions = 100;
+    int statementsPerFunction = 50;  // all statements in a body, nested ones included
+    int nestingDepth = 3;            // maximum if/while nesting inside a body
+    int exprDepth = 3;               // height of arithmetic expression trees
+    int scopeWidth = 4;              // variables declared at the top of every block
+    double callDensity = 0.1;        // chance that an expression leaf is a call
+    unsigned seed = 1;
+};
+
+std::string generateProgram(const GeneratorConfig& config);
+
+// Parse one generator flag (--functions, --statements, --depth, --expr-depth,
+// --scope-width, --call-density, --seed) at argv[i], consuming its value.
+// Returns false if argv[i] is not a generator flag.
+bool parseGeneratorFlag(int& i, int argc, char** argv, GeneratorConfig& config);
+
+extern const char* const kGeneratorFlagsUsage;
+
+#endif // PROGRAM_GENERATOR_HPP
@@ -0,0 +1,40 @@
+#include "bytecode.hpp"
+#include <sstream>
+
+const char* opCodeName(OpCode op) {
+    static const char* const names[] = {
+#define BYTECODE_NAME(name, hasOperand) #name,
+        BYTECODE_OPCODES(BYTECODE_NAME)
+#undef BYTECODE_NAME
+    };
+    return names[static_cast<uint8_t>(op)];
+}
+
+bool opCodeHasOperand(OpCode op) {
+    static const bool operands[] = {
+#define BYTECODE_OPERAND(name, hasOperand) hasOperand,
+        BYTECODE_OPCODES(BYTECODE_OPERAND)
+#undef BYTECODE_OPERAND
+    };
+    return operands[static_cast<uint8_t>(op)];
+}
+
+std::string BytecodeModule::disassemble() const {
+    std::ostringstream out;
+    for (size_t f = 0; f < functions.size(); ++f) {
+        const BytecodeFunction& fn = functions[f];
+        out << "function " << f << " " << fn.name
+            << " (params=" << fn.numParams
+            << ", locals=" << fn.numLocals
+            << ", stack=" << fn.maxStack << ")\n";
+        for (size_t i = 0; i < fn.code.size(); ++i) {
+            const Instruction& instr = fn.code[i];
+            out << "  " << i << ": " << opCodeName(instr.op);
+            if (opCodeHasOperand(instr.op)) {
+                out << " " << instr.operand;
+            }
+            out << "\n";
+        }
+    }
+    return out.str();
+}
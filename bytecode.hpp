@@ -0,0 +1,109 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "data_type.hpp"
+
+// Opcode list. Kept as an X-macro so the enum, the VM dispatch table and the
+// disassembler names can never drift apart.
+//
+// Operations are specialised by operand type (I = int, F = float) using the
+// types SemanticAnalyzer recorded on the AST, so the VM never inspects a value
+// to decide what to do with it. Bools are ints holding 0 or 1, which lets
+// bool equality reuse IEQ/INE and makes BOOL->INT a no-op.
+//
+//   X(name, hasOperand)
+#define BYTECODE_OPCODES(X)    \
+    X(PUSH_INT, true)          \
+    X(PUSH_FLOAT, true)        \
+    X(POP, false)              \
+    X(LOAD_LOCAL, true)        \
+    X(STORE_LOCAL, true)       \
+    X(LOAD_GLOBAL, true)       \
+    X(STORE_GLOBAL, true)      \
+    X(IADD, false)             \
+    X(ISUB, false)             \
+    X(IMUL, false)             \
+    X(IDIV, false)             \
+    X(INEG, false)             \
+    X(FADD, false)             \
+    X(FSUB, false)             \
+    X(FMUL, false)             \
+    X(FDIV, false)             \
+    X(FNEG, false)             \
+    X(ILT, false)              \
+    X(IGT, false)              \
+    X(ILE, false)              \
+    X(IGE, false)              \
+    X(IEQ, false)              \
+    X(INE, false)              \
+    X(FLT, false)              \
+    X(FGT, false)              \
+    X(FLE, false)              \
+    X(FGE, false)              \
+    X(FEQ, false)              \
+    X(FNE, false)              \
+    X(I2F, false)              \
+    X(I2B, false)              \
+    X(JUMP, true)              \
+    X(JUMP_IF_FALSE, true)     \
+    X(CALL, true)              \
+    X(RETURN, false)           \
+    X(PRINT_INT, false)        \
+    X(PRINT_FLOAT, false)      \
+    X(PRINT_BOOL, false)       \
+    X(MISSING_RETURN, false)   \
+    X(HALT, false)
+
+enum class OpCode : uint8_t {
+#define BYTECODE_ENUM(name, hasOperand) name,
+    BYTECODE_OPCODES(BYTECODE_ENUM)
+#undef BYTECODE_ENUM
+};
+
+const char* opCodeName(OpCode op);
+bool opCodeHasOperand(OpCode op);
+
+// One fixed-width instruction. Jump targets are absolute instruction indices
+// within the owning function; CALL carries the callee's function index and
+// PUSH_FLOAT an index into the module's float constant pool.
+struct Instruction {
+    OpCode op;
+    int32_t operand;
+
+    Instruction(OpCode o, int32_t arg = 0) : op(o), operand(arg) {}
+};
+
+// Runtime value. Untagged: the instruction that reads a slot already knows
+// whether it holds an int (or 0/1 bool) or a float.
+union Value {
+    int64_t i;
+    double f;
+
+    static Value Int(int64_t v) { Value r; r.i = v; return r; }
+    static Value Float(double v) { Value r; r.f = v; return r; }
+};
+
+struct BytecodeFunction {
+    std::string name;
+    uint32_t numParams = 0;
+    uint32_t numLocals = 0;   // parameters included
+    uint32_t maxStack = 0;    // deepest operand stack reached by the body
+    DataType returnType = DataType::IOTA;
+    std::vector<Instruction> code;
+};
+
+struct BytecodeModule {
+    std::vector<BytecodeFunction> functions;
+    std::vector<double> floatConstants;
+    uint32_t numGlobals = 0;
+    int32_t initFunction = -1;   // runs the global initializers in order
+    int32_t mainFunction = -1;   // zero-argument `main`, if the program has one
+
+    // Human-readable listing, one instruction per line
+    std::string disassemble() const;
+};
+
+#endif // BYTECODE_HPP
@@ -0,0 +1,562 @@
+#include "bytecode_compiler.hpp"
+#include <cstring>
+#include <stdexcept>
+
+// Main entry point
+BytecodeModule BytecodeCompiler::compile() {
+    if (!root) {
+        throw std::runtime_error("AST root is null");
+    }
+
+    ProgramNode* program = dynamic_cast<ProgramNode*>(root);
+    if (!program) {
+        throw std::runtime_error("Root is not a ProgramNode");
+    }
+
+    compileProgram(program);
+    return std::move(module);
+}
+
+// Compile program
+void BytecodeCompiler::compileProgram(ProgramNode* node) {
+    // First pass: assign an index to every top-level function so calls can be
+    // emitted before the callee's body has been compiled
+    for (auto decl : node->declarations) {
+        if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(decl)) {
+            functionIndex[funcDecl->name] = static_cast<int32_t>(functionDecls.size());
+            functionDecls.push_back(funcDecl);
+        }
+    }
+
+    // Function slots must not move while we hold pointers into them
+    module.functions.resize(functionDecls.size() + 1);
+    module.initFunction = static_cast<int32_t>(functionDecls.size());
+
+    BytecodeFunction& init = module.functions[module.initFunction];
+    init.name = "<init>";
+    init.returnType = DataType::IOTA;
+
+    // Second pass: globals go into <init> in declaration order, functions are
+    // compiled into their own slot
+    for (auto decl : node->declarations) {
+        if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(decl)) {
+            compileFunctionDecl(funcDecl, module.functions[functionIndex[funcDecl->name]]);
+        } else if (VarDeclNode* varDecl = dynamic_cast<VarDeclNode*>(decl)) {
+            compileGlobalVar(varDecl);
+        }
+    }
+
+    currentFunction = &init;
+    emit(OpCode::HALT);
+    currentFunction = nullptr;
+
+    auto mainIt = functionIndex.find("main");
+    if (mainIt != functionIndex.end() && module.functions[mainIt->second].numParams == 0) {
+        module.mainFunction = mainIt->second;
+    }
+}
+
+// Compile function declaration
+void BytecodeCompiler::compileFunctionDecl(FunctionDeclNode* node, BytecodeFunction& fn) {
+    fn.name = node->name;
+    fn.numParams = static_cast<uint32_t>(node->parameters.size());
+    fn.returnType = node->returnType;
+
+    currentFunction = &fn;
+    localScopes.clear();
+    nextLocalSlot = 0;
+    stackDepth = 0;
+
+    // Parameters occupy the first slots of the frame, in order
+    pushScope();
+    for (const auto& param : node->parameters) {
+        declareLocal(param.name, param.type);
+    }
+
+    compileBlock(node->bodyItems);
+
+    // The analyzer guarantees every path returns; this only guards the VM
+    // against running off the end of the instruction stream
+    emit(OpCode::MISSING_RETURN);
+
+    popScope(0);
+    currentFunction = nullptr;
+}
+
+// Compile global variable into the <init> function
+void BytecodeCompiler::compileGlobalVar(VarDeclNode* node) {
+    currentFunction = &module.functions[module.initFunction];
+    localScopes.clear();
+    stackDepth = 0;
+
+    DataType declaredType = node->getDataType();
+    if (node->initializer) {
+        compileExpr(node->initializer);
+        compileConversion(declaredType, node->initializer->dataType);
+    } else {
+        compileDefault(declaredType);
+    }
+
+    int32_t index = static_cast<int32_t>(module.numGlobals++);
+    globals[node->name] = LocalVar{index, declaredType};
+    emit(OpCode::STORE_GLOBAL, index);
+
+    currentFunction = nullptr;
+}
+
+// Compile a function body. Nested if and while bodies go on `blocks`
+// instead of being lowered by recursion, so nesting depth is bounded by
+// memory; code comes out in the same order a recursive walk would emit it.
+void BytecodeCompiler::compileBlock(const std::vector<ASTNode*>& block) {
+    size_t base = blocks.size();
+    blocks.push_back(BlockFrame{&block, 0, BlockOwner::BODY, nullptr, 0, 0, nextLocalSlot});
+    while (blocks.size() > base) {
+        BlockFrame& frame = blocks.back();
+        if (frame.next == frame.items->size()) {
+            BlockFrame done = frame;
+            blocks.pop_back();
+            leaveBlock(done);
+            continue;
+        }
+
+        // `frame` is invalid once a nested list has been pushed. Most common
+        // item types first, as in SemanticAnalyzer::runBlocks.
+        ASTNode* item = (*frame.items)[frame.next++];
+        if (AssignmentStmtNode* assign = dynamic_cast<AssignmentStmtNode*>(item)) {
+            compileAssignment(assign);
+        } else if (VarDeclNode* varDecl = dynamic_cast<VarDeclNode*>(item)) {
+            compileLocalVar(varDecl);
+        } else if (IfStmtNode* ifStmt = dynamic_cast<IfStmtNode*>(item)) {
+            enterIf(ifStmt);
+        } else if (WhileStmtNode* whileStmt = dynamic_cast<WhileStmtNode*>(item)) {
+            enterWhile(whileStmt);
+        } else if (dynamic_cast<FunctionDeclNode*>(item)) {
+            // Nested functions are never entered into a scope by the analyzer,
+            // so nothing can call them and there is nothing to emit
+            continue;
+        } else if (StmtNode* stmt = dynamic_cast<StmtNode*>(item)) {
+            compileStmt(stmt);
+        }
+    }
+}
+
+// Compile local variable declaration
+void BytecodeCompiler::compileLocalVar(VarDeclNode* node) {
+    DataType declaredType = node->getDataType();
+
+    // The initializer is compiled before the name is bound, matching
+    // analyzeVarDecl, so `var x: int = x;` reads the outer x
+    if (node->initializer) {
+        compileExpr(node->initializer);
+        compileConversion(declaredType, node->initializer->dataType);
+    } else {
+        compileDefault(declaredType);
+    }
+
+    LocalVar local = declareLocal(node->name, declaredType);
+    emit(OpCode::STORE_LOCAL, local.slot);
+}
+
+// Compile a return or print statement
+void BytecodeCompiler::compileStmt(StmtNode* node) {
+    if (ReturnStmtNode* ret = dynamic_cast<ReturnStmtNode*>(node)) {
+        if (ret->value) {
+            compileExpr(ret->value);
+            compileConversion(currentFunction->returnType, ret->value->dataType);
+        } else {
+            compileDefault(currentFunction->returnType);
+        }
+        emit(OpCode::RETURN);
+    } else if (PrintStmtNode* print = dynamic_cast<PrintStmtNode*>(node)) {
+        compileExpr(print->expression);
+        DataType type = print->expression->dataType;
+        if (type == DataType::FLOAT) {
+            emit(OpCode::PRINT_FLOAT);
+        } else if (type == DataType::BOOL) {
+            emit(OpCode::PRINT_BOOL);
+        } else {
+            emit(OpCode::PRINT_INT);
+        }
+    }
+}
+
+// Compile an if statement's condition and queue its then-branch
+void BytecodeCompiler::enterIf(IfStmtNode* node) {
+    compileExpr(node->condition);
+    size_t jumpToElse = emit(OpCode::JUMP_IF_FALSE);
+
+    uint32_t savedSlot = nextLocalSlot;
+    pushScope();
+    blocks.push_back(BlockFrame{&node->thenItems, 0, BlockOwner::IF_THEN, node, jumpToElse, 0,
+                                savedSlot});
+}
+
+// Compile a while statement's condition and queue its body
+void BytecodeCompiler::enterWhile(WhileStmtNode* node) {
+    int32_t loopStart = static_cast<int32_t>(currentFunction->code.size());
+
+    compileExpr(node->condition);
+    size_t jumpToEnd = emit(OpCode::JUMP_IF_FALSE);
+
+    uint32_t savedSlot = nextLocalSlot;
+    pushScope();
+    blocks.push_back(BlockFrame{&node->bodyItems, 0, BlockOwner::WHILE, node, jumpToEnd,
+                                loopStart, savedSlot});
+}
+
+// Close a finished statement list and emit what follows it in its owner
+void BytecodeCompiler::leaveBlock(const BlockFrame& frame) {
+    switch (frame.owner) {
+        case BlockOwner::BODY:
+            break;
+
+        case BlockOwner::IF_THEN: {
+            IfStmtNode* ifStmt = static_cast<IfStmtNode*>(frame.statement);
+            popScope(frame.savedSlot);
+            if (ifStmt->elseItems.empty()) {
+                patchJump(frame.jump);
+                break;
+            }
+
+            size_t jumpToEnd = emit(OpCode::JUMP);
+            patchJump(frame.jump);
+
+            pushScope();
+            blocks.push_back(BlockFrame{&ifStmt->elseItems, 0, BlockOwner::IF_ELSE, ifStmt,
+                                        jumpToEnd, 0, frame.savedSlot});
+            break;
+        }
+
+        case BlockOwner::IF_ELSE:
+            popScope(frame.savedSlot);
+            patchJump(frame.jump);
+            break;
+
+        case BlockOwner::WHILE:
+            popScope(frame.savedSlot);
+            emit(OpCode::JUMP, frame.loopStart);
+            patchJump(frame.jump);
+            break;
+    }
+}
+
+// Compile assignment
+void BytecodeCompiler::compileAssignment(AssignmentStmtNode* node) {
+    compileExpr(node->value);
+
+    const LocalVar* local = resolveLocal(node->variableName);
+    if (local) {
+        compileConversion(local->type, node->value->dataType);
+        emit(OpCode::STORE_LOCAL, local->slot);
+        return;
+    }
+
+    const LocalVar& global = resolveGlobal(node->variableName);
+    compileConversion(global.type, node->value->dataType);
+    emit(OpCode::STORE_GLOBAL, global.slot);
+}
+
+// Compile expression, leaving its value on the stack. Shallow expressions
+// recurse; below kMaxExprRecursion levels, operators and calls wait on
+// exprFrames instead, so a deep `+` chain needs heap, not call stack.
+void BytecodeCompiler::compileExpr(ExprNode* expr, unsigned depth) {
+    ExprFrame frame;
+    if (!openExpr(expr, frame)) return;
+    if (depth >= kMaxExprRecursion) {
+        size_t base = exprFrames.size();
+        exprFrames.push_back(frame);
+        runExprFrames(base);
+        return;
+    }
+
+    while (ExprNode* operand = nextOperand(frame)) {
+        compileExpr(operand, depth + 1);
+    }
+    finishExpr(frame);
+}
+
+// Compile operands of the innermost open frames until exprFrames is back at
+// `depth`
+void BytecodeCompiler::runExprFrames(size_t depth) {
+    while (exprFrames.size() > depth) {
+        ExprFrame& frame = exprFrames.back();
+        ExprNode* operand = nextOperand(frame);
+        if (!operand) {
+            finishExpr(frame);
+            exprFrames.pop_back();
+            continue;
+        }
+
+        ExprFrame child;
+        if (openExpr(operand, child)) {
+            exprFrames.push_back(child);  // invalidates `frame`
+        }
+    }
+}
+
+// Emit a leaf on the spot, or open a frame for an operator or call and
+// return true. One dynamic_cast ladder per node, most common node types first.
+bool BytecodeCompiler::openExpr(ExprNode* expr, ExprFrame& frame) {
+    frame = ExprFrame{expr, ExprKind::BINARY, 0, 0};
+    if (IdentifierNode* idNode = dynamic_cast<IdentifierNode*>(expr)) {
+        const LocalVar* local = resolveLocal(idNode->name);
+        if (local) {
+            emit(OpCode::LOAD_LOCAL, local->slot);
+        } else {
+            emit(OpCode::LOAD_GLOBAL, resolveGlobal(idNode->name).slot);
+        }
+    }
+    else if (IntegerNode* intNode = dynamic_cast<IntegerNode*>(expr)) {
+        emit(OpCode::PUSH_INT, intNode->value);
+    }
+    else if (dynamic_cast<BinaryOpNode*>(expr)) {
+        return true;
+    }
+    else if (FunctionCallNode* callNode = dynamic_cast<FunctionCallNode*>(expr)) {
+        auto it = functionIndex.find(callNode->functionName);
+        if (it == functionIndex.end()) {
+            throw std::runtime_error("Unresolved function: " + callNode->functionName);
+        }
+        frame.kind = ExprKind::CALL;
+        frame.function = it->second;
+        return true;
+    }
+    else if (FloatNode* floatNode = dynamic_cast<FloatNode*>(expr)) {
+        emitFloat(floatNode->value);
+    }
+    else if (BoolNode* boolNode = dynamic_cast<BoolNode*>(expr)) {
+        emit(OpCode::PUSH_INT, boolNode->value ? 1 : 0);
+    }
+    else if (dynamic_cast<UnaryOpNode*>(expr)) {
+        frame.kind = ExprKind::UNARY;
+        return true;
+    }
+    else {
+        throw std::runtime_error("Unsupported expression in bytecode lowering");
+    }
+    return false;
+}
+
+// The operand to compile next, or nullptr once all are done. Called once on
+// entry and once after each operand finishes, which is where a finished
+// operand gets its conversion.
+ExprNode* BytecodeCompiler::nextOperand(ExprFrame& frame) {
+    size_t done = frame.next;
+    ExprNode* operand = nullptr;
+    switch (frame.kind) {
+        case ExprKind::BINARY: {
+            BinaryOpNode* binOp = static_cast<BinaryOpNode*>(frame.node);
+            DataType leftType = binOp->left->dataType;
+            DataType rightType = binOp->right->dataType;
+
+            // Same promotion rule as analyzeExpr: arithmetic and ordering run
+            // in FLOAT if either side is FLOAT; equality operands already agree
+            bool useFloat = (leftType == DataType::FLOAT || rightType == DataType::FLOAT);
+            if (done == 0) {
+                operand = binOp->left;
+            } else if (done == 1) {
+                if (useFloat && leftType != DataType::FLOAT) emit(OpCode::I2F);
+                operand = binOp->right;
+            } else if (useFloat && rightType != DataType::FLOAT) {
+                emit(OpCode::I2F);
+            }
+            break;
+        }
+
+        case ExprKind::UNARY:
+            if (done == 0) operand = static_cast<UnaryOpNode*>(frame.node)->operand;
+            break;
+
+        case ExprKind::CALL: {
+            // Arguments land in the callee's parameter slots, already
+            // converted to the declared parameter types
+            FunctionCallNode* callNode = static_cast<FunctionCallNode*>(frame.node);
+            const FunctionDeclNode* callee = functionDecls[frame.function];
+            if (done > 0) {
+                compileConversion(callee->parameters[done - 1].type,
+                                  callNode->arguments[done - 1]->dataType);
+            }
+            if (done < callNode->arguments.size()) operand = callNode->arguments[done];
+            break;
+        }
+    }
+    if (operand) {
+        ++frame.next;
+    }
+    return operand;
+}
+
+// Emit the instruction of an operator or call whose operands are all on the
+// stack
+void BytecodeCompiler::finishExpr(const ExprFrame& frame) {
+    switch (frame.kind) {
+        case ExprKind::BINARY: {
+            BinaryOpNode* binOp = static_cast<BinaryOpNode*>(frame.node);
+            bool useFloat = (binOp->left->dataType == DataType::FLOAT ||
+                             binOp->right->dataType == DataType::FLOAT);
+
+            if (binOp->op == "+") emit(useFloat ? OpCode::FADD : OpCode::IADD);
+            else if (binOp->op == "-") emit(useFloat ? OpCode::FSUB : OpCode::ISUB);
+            else if (binOp->op == "*") emit(useFloat ? OpCode::FMUL : OpCode::IMUL);
+            else if (binOp->op == "/") emit(useFloat ? OpCode::FDIV : OpCode::IDIV);
+            else if (binOp->op == "<") emit(useFloat ? OpCode::FLT : OpCode::ILT);
+            else if (binOp->op == ">") emit(useFloat ? OpCode::FGT : OpCode::IGT);
+            else if (binOp->op == "<=") emit(useFloat ? OpCode::FLE : OpCode::ILE);
+            else if (binOp->op == ">=") emit(useFloat ? OpCode::FGE : OpCode::IGE);
+            else if (binOp->op == "==") emit(useFloat ? OpCode::FEQ : OpCode::IEQ);
+            else if (binOp->op == "!=") emit(useFloat ? OpCode::FNE : OpCode::INE);
+            else throw std::runtime_error("Unknown binary operator: " + binOp->op);
+            break;
+        }
+
+        case ExprKind::UNARY: {
+            UnaryOpNode* unOp = static_cast<UnaryOpNode*>(frame.node);
+            if (unOp->op == "-") {
+                emit(unOp->operand->dataType == DataType::FLOAT ? OpCode::FNEG : OpCode::INEG);
+            } else {
+                throw std::runtime_error("Unknown unary operator: " + unOp->op);
+            }
+            break;
+        }
+
+        case ExprKind::CALL:
+            emit(OpCode::CALL, frame.function);
+            break;
+    }
+}
+
+// Emit the conversion for an assignment-compatible (target, source) pair.
+// Only the two conversions that change the representation need code:
+// INT->FLOAT (widening) and INT->BOOL (normalise to 0/1). BOOL->INT is free.
+void BytecodeCompiler::compileConversion(DataType target, DataType source) {
+    if (target == DataType::FLOAT && source == DataType::INT) {
+        emit(OpCode::I2F);
+    } else if (target == DataType::BOOL && source == DataType::INT) {
+        emit(OpCode::I2B);
+    }
+}
+
+// Push the zero value of a type
+void BytecodeCompiler::compileDefault(DataType type) {
+    if (type == DataType::FLOAT) {
+        emitFloat(0.0);
+    } else {
+        emit(OpCode::PUSH_INT, 0);
+    }
+}
+
+// Push a float through the constant pool, sharing identical constants.
+// Keyed by bit pattern so 0.0 and -0.0 stay distinct.
+void BytecodeCompiler::emitFloat(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+
+    auto it = floatConstantIndex.find(bits);
+    int32_t index;
+    if (it != floatConstantIndex.end()) {
+        index = it->second;
+    } else {
+        index = static_cast<int32_t>(module.floatConstants.size());
+        module.floatConstants.push_back(value);
+        floatConstantIndex.emplace(bits, index);
+    }
+    emit(OpCode::PUSH_FLOAT, index);
+}
+
+void BytecodeCompiler::pushScope() {
+    localScopes.emplace_back();
+}
+
+// Leave a block scope; its slots are free for reuse by sibling blocks
+void BytecodeCompiler::popScope(uint32_t savedSlot) {
+    localScopes.pop_back();
+    nextLocalSlot = savedSlot;
+}
+
+BytecodeCompiler::LocalVar BytecodeCompiler::declareLocal(const std::string& name, DataType type) {
+    LocalVar local{static_cast<int32_t>(nextLocalSlot++), type};
+    localScopes.back()[name] = local;
+    if (nextLocalSlot > currentFunction->numLocals) {
+        currentFunction->numLocals = nextLocalSlot;
+    }
+    return local;
+}
+
+const BytecodeCompiler::LocalVar* BytecodeCompiler::resolveLocal(const std::string& name) const {
+    for (auto it = localScopes.rbegin(); it != localScopes.rend(); ++it) {
+        auto found = it->find(name);
+        if (found != it->end()) {
+            return &found->second;
+        }
+    }
+    return nullptr;
+}
+
+const BytecodeCompiler::LocalVar& BytecodeCompiler::resolveGlobal(const std::string& name) const {
+    auto it = globals.find(name);
+    if (it == globals.end()) {
+        throw std::runtime_error("Unresolved identifier: " + name);
+    }
+    return it->second;
+}
+
+size_t BytecodeCompiler::emit(OpCode op, int32_t operand) {
+    currentFunction->code.emplace_back(op, operand);
+
+    // Statements always start and end at depth zero, so a straight-line
+    // count is enough to size the operand stack for the VM
+    stackDepth += stackEffect(op, operand);
+    if (stackDepth > static_cast<int32_t>(currentFunction->maxStack)) {
+        currentFunction->maxStack = static_cast<uint32_t>(stackDepth);
+    }
+    return currentFunction->code.size() - 1;
+}
+
+// Net number of values an instruction pushes (negative when it pops)
+int32_t BytecodeCompiler::stackEffect(OpCode op, int32_t operand) const {
+    switch (op) {
+        case OpCode::PUSH_INT:
+        case OpCode::PUSH_FLOAT:
+        case OpCode::LOAD_LOCAL:
+        case OpCode::LOAD_GLOBAL:
+            return 1;
+        case OpCode::POP:
+        case OpCode::STORE_LOCAL:
+        case OpCode::STORE_GLOBAL:
+        case OpCode::IADD:
+        case OpCode::ISUB:
+        case OpCode::IMUL:
+        case OpCode::IDIV:
+        case OpCode::FADD:
+        case OpCode::FSUB:
+        case OpCode::FMUL:
+        case OpCode::FDIV:
+        case OpCode::ILT:
+        case OpCode::IGT:
+        case OpCode::ILE:
+        case OpCode::IGE:
+        case OpCode::IEQ:
+        case OpCode::INE:
+        case OpCode::FLT:
+        case OpCode::FGT:
+        case OpCode::FLE:
+        case OpCode::FGE:
+        case OpCode::FEQ:
+        case OpCode::FNE:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::RETURN:
+        case OpCode::PRINT_INT:
+        case OpCode::PRINT_FLOAT:
+        case OpCode::PRINT_BOOL:
+            return -1;
+        case OpCode::CALL:
+            return 1 - static_cast<int32_t>(functionDecls[operand]->parameters.size());
+        default:
+            return 0;
+    }
+}
+
+// Point a forward jump at the next instruction to be emitted
+void BytecodeCompiler::patchJump(size_t at) {
+    currentFunction->code[at].operand = static_cast<int32_t>(currentFunction->code.size());
+}
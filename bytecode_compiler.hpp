@@ -0,0 +1,103 @@
+#ifndef BYTECODE_COMPILER_HPP
+#define BYTECODE_COMPILER_HPP
+
+#include "astnode.hpp"
+#include "bytecode.hpp"
+#include "data_type.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Lowers an AST that has already passed SemanticAnalyzer into a BytecodeModule.
+// The compiler relies on the analyzer's guarantees (every name resolves, every
+// expression carries its dataType) and only reports internal errors.
+class BytecodeCompiler {
+ private:
+    // A resolved variable: frame slot for locals, global index for globals
+    struct LocalVar {
+        int32_t slot;
+        DataType type;
+    };
+
+    enum class BlockOwner : uint8_t { BODY, IF_THEN, IF_ELSE, WHILE };
+
+    // A statement list being lowered; nested bodies wait on `blocks`
+    // instead of being lowered by recursion
+    struct BlockFrame {
+        const std::vector<ASTNode*>* items;
+        size_t next;             // index of the next item
+        BlockOwner owner;
+        StmtNode* statement;     // the if or while that owns the list
+        size_t jump;             // IF_THEN: jump to else; IF_ELSE, WHILE: jump to end
+        int32_t loopStart;       // WHILE: the condition's first instruction
+        uint32_t savedSlot;      // nextLocalSlot before the list's scope
+    };
+
+    enum class ExprKind : uint8_t { BINARY, UNARY, CALL };
+
+    // An operator or call whose operands are still being lowered
+    struct ExprFrame {
+        ExprNode* node;
+        ExprKind kind;
+        size_t next;             // operands handed out so far
+        int32_t function;        // CALL only: callee index
+    };
+
+    ASTNode* root;
+    BytecodeModule module;
+
+    std::unordered_map<std::string, int32_t> functionIndex;
+    std::vector<FunctionDeclNode*> functionDecls;
+    std::unordered_map<std::string, LocalVar> globals;
+    std::unordered_map<uint64_t, int32_t> floatConstantIndex;
+
+    // Per-function state
+    BytecodeFunction* currentFunction;
+    std::vector<std::unordered_map<std::string, LocalVar>> localScopes;
+    uint32_t nextLocalSlot;
+    int32_t stackDepth;
+    std::vector<BlockFrame> blocks;
+    std::vector<ExprFrame> exprFrames;
+
+    // Expression nesting compileExpr recurses through before it hands the
+    // rest to exprFrames, as in SemanticAnalyzer
+    static constexpr unsigned kMaxExprRecursion = 64;
+
+    void compileProgram(ProgramNode* node);
+    void compileFunctionDecl(FunctionDeclNode* node, BytecodeFunction& fn);
+    void compileGlobalVar(VarDeclNode* node);
+    void compileBlock(const std::vector<ASTNode*>& block);
+    void compileLocalVar(VarDeclNode* node);
+    void compileStmt(StmtNode* node);
+    void enterIf(IfStmtNode* node);
+    void enterWhile(WhileStmtNode* node);
+    void leaveBlock(const BlockFrame& frame);
+    void compileAssignment(AssignmentStmtNode* node);
+    void compileExpr(ExprNode* expr, unsigned depth = 0);
+    void runExprFrames(size_t depth);
+    bool openExpr(ExprNode* expr, ExprFrame& frame);
+    ExprNode* nextOperand(ExprFrame& frame);
+    void finishExpr(const ExprFrame& frame);
+    void compileConversion(DataType target, DataType source);
+    void compileDefault(DataType type);
+    void emitFloat(double value);
+
+    void pushScope();
+    void popScope(uint32_t savedSlot);
+    LocalVar declareLocal(const std::string& name, DataType type);
+    const LocalVar* resolveLocal(const std::string& name) const;
+    const LocalVar& resolveGlobal(const std::string& name) const;
+
+    size_t emit(OpCode op, int32_t operand = 0);
+    int32_t stackEffect(OpCode op, int32_t operand) const;
+    void patchJump(size_t at);
+
+ public:
+    explicit BytecodeCompiler(ASTNode* root)
+        : root(root), currentFunction(nullptr), nextLocalSlot(0), stackDepth(0) {}
+
+    BytecodeModule compile();
+};
+
+#endif // BYTECODE_COMPILER_HPP
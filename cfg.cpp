@@ -0,0 +1,332 @@
+#include "cfg.hpp"
+#include <stdexcept>
+#include <utility>
+
+ControlFlowGraph ControlFlowGraph::build(FunctionDeclNode* function) {
+    if (!function) {
+        throw std::runtime_error("Function node is null");
+    }
+
+    ControlFlowGraph cfg;
+    cfg.entryBlock = cfg.newBlock();
+    cfg.exitBlock = cfg.newBlock();
+
+    cfg.fallthroughBlock = cfg.buildItems(function->bodyItems, cfg.entryBlock);
+    cfg.addEdge(cfg.fallthroughBlock, cfg.exitBlock);
+
+    cfg.computeReversePostorder();
+    cfg.computeDominators();
+    cfg.numberDominatorTree();
+    return cfg;
+}
+
+uint32_t ControlFlowGraph::newBlock() {
+    uint32_t id = static_cast<uint32_t>(blockList.size());
+    blockList.emplace_back(id);
+    return id;
+}
+
+void ControlFlowGraph::addEdge(uint32_t from, uint32_t to) {
+    blockList[from].successors.push_back(to);
+    blockList[to].predecessors.push_back(from);
+}
+
+// Append a statement list starting in block `current`; returns the block that
+// control is in afterwards. Nested bodies go on an explicit stack instead of
+// being built by recursion, so nesting depth is bounded by memory. Blocks are
+// created in the same order a recursive walk would create them, and referred
+// to by index throughout since newBlock() may reallocate the list.
+uint32_t ControlFlowGraph::buildItems(const std::vector<ASTNode*>& items, uint32_t current) {
+    enum class Owner : uint8_t { BODY, IF_THEN, IF_ELSE, WHILE };
+
+    // A statement list being appended
+    struct Frame {
+        const std::vector<ASTNode*>* items;
+        size_t next;          // index of the next item
+        uint32_t current;     // block control is in
+        Owner owner;
+        StmtNode* statement;  // the if or while that owns the list
+        uint32_t split;       // IF_*: the condition's block; WHILE: the header
+        uint32_t join;        // IF_ELSE: where both branches meet
+    };
+
+    std::vector<Frame> stack;
+    stack.push_back(Frame{&items, 0, current, Owner::BODY, nullptr, kNone, kNone});
+    for (;;) {
+        Frame& frame = stack.back();
+        if (frame.next == frame.items->size()) {
+            Frame done = frame;
+            stack.pop_back();
+            if (stack.empty()) {
+                return done.current;
+            }
+
+            // Connect the finished list to what follows its owner
+            uint32_t after = kNone;
+            switch (done.owner) {
+                case Owner::BODY:
+                    break;
+
+                case Owner::IF_THEN: {
+                    IfStmtNode* ifStmt = static_cast<IfStmtNode*>(done.statement);
+                    uint32_t join = newBlock();
+                    addEdge(done.current, join);
+                    if (!ifStmt->elseItems.empty()) {
+                        uint32_t elseEntry = newBlock();
+                        addEdge(done.split, elseEntry);
+                        stack.push_back(Frame{&ifStmt->elseItems, 0, elseEntry, Owner::IF_ELSE,
+                                              ifStmt, done.split, join});
+                        continue;
+                    }
+                    addEdge(done.split, join);
+                    after = join;
+                    break;
+                }
+
+                case Owner::IF_ELSE:
+                    addEdge(done.current, done.join);
+                    after = done.join;
+                    break;
+
+                case Owner::WHILE:
+                    addEdge(done.current, done.split);
+                    after = newBlock();
+                    addEdge(done.split, after);
+                    break;
+            }
+            stack.back().current = after;
+            continue;
+        }
+
+        ASTNode* item = (*frame.items)[frame.next++];
+        if (dynamic_cast<FunctionDeclNode*>(item)) {
+            continue;
+        }
+
+        // `frame` is invalid once a nested list has been pushed
+        if (IfStmtNode* ifStmt = dynamic_cast<IfStmtNode*>(item)) {
+            uint32_t condition = frame.current;
+            blockList[condition].terminator = ifStmt;
+            nodeBlock[ifStmt] = condition;
+
+            uint32_t thenEntry = newBlock();
+            addEdge(condition, thenEntry);
+            stack.push_back(Frame{&ifStmt->thenItems, 0, thenEntry, Owner::IF_THEN, ifStmt,
+                                  condition, kNone});
+        } else if (WhileStmtNode* whileStmt = dynamic_cast<WhileStmtNode*>(item)) {
+            uint32_t header = newBlock();
+            addEdge(frame.current, header);
+            blockList[header].terminator = whileStmt;
+            nodeBlock[whileStmt] = header;
+
+            uint32_t bodyEntry = newBlock();
+            addEdge(header, bodyEntry);
+            stack.push_back(Frame{&whileStmt->bodyItems, 0, bodyEntry, Owner::WHILE, whileStmt,
+                                  header, kNone});
+        } else {
+            blockList[frame.current].items.push_back(item);
+            nodeBlock[item] = frame.current;
+
+            if (dynamic_cast<ReturnStmtNode*>(item)) {
+                addEdge(frame.current, exitBlock);
+                // Anything after a return lands in a block with no predecessors
+                frame.current = newBlock();
+            }
+        }
+    }
+}
+
+// Iterative DFS from entry, so deep nesting cannot overflow the call stack
+void ControlFlowGraph::computeReversePostorder() {
+    size_t n = blockList.size();
+    std::vector<uint32_t> postorder;
+    postorder.reserve(n);
+    std::vector<bool> visited(n, false);
+
+    // (block, index of next successor to visit)
+    std::vector<std::pair<uint32_t, size_t>> stack;
+    stack.emplace_back(entryBlock, 0);
+    visited[entryBlock] = true;
+
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const BasicBlock& b = blockList[top.first];
+        if (top.second < b.successors.size()) {
+            uint32_t next = b.successors[top.second++];
+            if (!visited[next]) {
+                visited[next] = true;
+                stack.emplace_back(next, 0);
+            }
+        } else {
+            postorder.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+
+    rpo.assign(postorder.rbegin(), postorder.rend());
+    rpoIndex.assign(n, kNone);
+    for (size_t i = 0; i < rpo.size(); ++i) {
+        rpoIndex[rpo[i]] = static_cast<uint32_t>(i);
+    }
+}
+
+// Cooper, Harvey & Kennedy, "A Simple, Fast Dominance Algorithm". Visiting in
+// reverse postorder, the structured graphs this language produces settle in
+// two passes. Every join other than exit has two predecessors, so intersect()
+// only walks the chain inside one branch.
+//
+// The exit block is the exception: it has one predecessor per return, and
+// intersecting them one by one walks the whole dominator chain per return,
+// which is quadratic in a long function. Nothing depends on exit's dominator
+// (it has no successors), so it is left out of the iteration and resolved
+// afterwards by nearestCommonDominator(), which is linear.
+void ControlFlowGraph::computeDominators() {
+    size_t n = blockList.size();
+    idom.assign(n, kNone);
+    idom[entryBlock] = entryBlock;
+
+    auto intersect = [this](uint32_t a, uint32_t b) {
+        while (a != b) {
+            while (rpoIndex[a] > rpoIndex[b]) a = idom[a];
+            while (rpoIndex[b] > rpoIndex[a]) b = idom[b];
+        }
+        return a;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < rpo.size(); ++i) {
+            uint32_t b = rpo[i];
+            if (b == exitBlock) {
+                continue;
+            }
+            uint32_t newIdom = kNone;
+            for (uint32_t p : blockList[b].predecessors) {
+                if (idom[p] == kNone) {
+                    continue;  // unreachable, or not yet processed this pass
+                }
+                newIdom = (newIdom == kNone) ? p : intersect(p, newIdom);
+            }
+            if (idom[b] != newIdom) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    if (isReachable(exitBlock) && exitBlock != entryBlock) {
+        std::vector<uint32_t> reachablePreds;
+        for (uint32_t p : blockList[exitBlock].predecessors) {
+            if (isReachable(p)) {
+                reachablePreds.push_back(p);
+            }
+        }
+        idom[exitBlock] = nearestCommonDominator(reachablePreds);
+    }
+
+    domChildren.assign(n, {});
+    for (uint32_t b : rpo) {
+        if (b != entryBlock) {
+            domChildren[idom[b]].push_back(b);
+        }
+    }
+}
+
+// Deepest block dominating every block in `blocks` (all reachable, idom of
+// each already known). The first block's path to entry is marked; every other
+// walk climbs only until it reaches a block some earlier walk has seen, and
+// records where that path meets the marked one, so each block is climbed at
+// most once.
+uint32_t ControlFlowGraph::nearestCommonDominator(const std::vector<uint32_t>& blocks) const {
+    if (blocks.empty()) {
+        return kNone;
+    }
+
+    size_t n = blockList.size();
+    // For blocks on the first path: distance from entry. For other visited
+    // blocks: the block where their path joins the first one.
+    std::vector<uint32_t> pathDepth(n, kNone);
+    std::vector<uint32_t> joinsAt(n, kNone);
+
+    std::vector<uint32_t> path;
+    for (uint32_t b = blocks[0];; b = idom[b]) {
+        path.push_back(b);
+        if (b == entryBlock) break;
+    }
+    for (size_t i = 0; i < path.size(); ++i) {
+        pathDepth[path[i]] = static_cast<uint32_t>(path.size() - 1 - i);
+    }
+
+    uint32_t result = blocks[0];
+    std::vector<uint32_t> walked;
+    for (size_t i = 1; i < blocks.size(); ++i) {
+        walked.clear();
+        uint32_t b = blocks[i];
+        while (pathDepth[b] == kNone && joinsAt[b] == kNone) {
+            walked.push_back(b);
+            b = idom[b];
+        }
+        uint32_t meet = (pathDepth[b] != kNone) ? b : joinsAt[b];
+        for (uint32_t w : walked) {
+            joinsAt[w] = meet;
+        }
+        if (pathDepth[meet] < pathDepth[result]) {
+            result = meet;
+        }
+    }
+    return result;
+}
+
+// Pre/post numbering of the dominator tree: a dominates b iff a's interval
+// encloses b's
+void ControlFlowGraph::numberDominatorTree() {
+    size_t n = blockList.size();
+    domPre.assign(n, kNone);
+    domPost.assign(n, kNone);
+
+    uint32_t counter = 0;
+    std::vector<std::pair<uint32_t, size_t>> stack;
+    stack.emplace_back(entryBlock, 0);
+    domPre[entryBlock] = counter++;
+
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const auto& children = domChildren[top.first];
+        if (top.second < children.size()) {
+            uint32_t child = children[top.second++];
+            domPre[child] = counter++;
+            stack.emplace_back(child, 0);
+        } else {
+            domPost[top.first] = counter++;
+            stack.pop_back();
+        }
+    }
+}
+
+uint32_t ControlFlowGraph::blockOf(const ASTNode* node) const {
+    auto it = nodeBlock.find(node);
+    return it == nodeBlock.end() ? kNone : it->second;
+}
+
+uint32_t ControlFlowGraph::immediateDominator(uint32_t id) const {
+    if (id == entryBlock) {
+        return kNone;
+    }
+    return idom[id];
+}
+
+bool ControlFlowGraph::dominates(uint32_t a, uint32_t b) const {
+    if (!isReachable(a) || !isReachable(b)) {
+        return false;
+    }
+    return domPre[a] <= domPre[b] && domPost[b] <= domPost[a];
+}
+
+size_t ControlFlowGraph::edgeCount() const {
+    size_t count = 0;
+    for (const auto& b : blockList) {
+        count += b.successors.size();
+    }
+    return count;
+}
@@ -0,0 +1,94 @@
+#ifndef CFG_HPP
+#define CFG_HPP
+
+#include "astnode.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// A maximal straight-line run of items in one function body.
+struct BasicBlock {
+    uint32_t id;
+
+    // VarDeclNode, AssignmentStmtNode, PrintStmtNode and ReturnStmtNode items
+    // in execution order
+    std::vector<ASTNode*> items;
+
+    // The IfStmtNode or WhileStmtNode whose condition ends this block, or
+    // nullptr when the block ends in a return or falls through
+    StmtNode* terminator;
+
+    std::vector<uint32_t> successors;
+    std::vector<uint32_t> predecessors;
+
+    explicit BasicBlock(uint32_t id) : id(id), terminator(nullptr) {}
+};
+
+// Control-flow graph of one FunctionDeclNode, with reachability and a
+// dominator tree. Branches are taken structurally: conditions are never
+// evaluated, so `while (true)` still has an exit edge. This is the same view
+// of control flow as SemanticAnalyzer's return and reachability checks, but
+// the analyzer does not build a graph: it tracks those facts as it walks the
+// body. The graph serves --cfg and later passes.
+//
+// Every return edge goes to the synthetic exit block. The block the body
+// falls off the end of also flows to exit; it is reachable exactly when some
+// path finishes the function without returning.
+//
+// Nested FunctionDeclNodes are left out; build a separate graph for them.
+class ControlFlowGraph {
+ public:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    static ControlFlowGraph build(FunctionDeclNode* function);
+
+    const std::vector<BasicBlock>& blocks() const { return blockList; }
+    const BasicBlock& block(uint32_t id) const { return blockList[id]; }
+    uint32_t entry() const { return entryBlock; }
+    uint32_t exit() const { return exitBlock; }
+    uint32_t fallthrough() const { return fallthroughBlock; }
+
+    // Block containing an item or terminator, or kNone
+    uint32_t blockOf(const ASTNode* node) const;
+
+    // Reachable blocks in reverse postorder from entry
+    const std::vector<uint32_t>& reversePostorder() const { return rpo; }
+
+    bool isReachable(uint32_t id) const { return rpoIndex[id] != kNone; }
+
+    // kNone for the entry block and for unreachable blocks
+    uint32_t immediateDominator(uint32_t id) const;
+    const std::vector<uint32_t>& dominatorChildren(uint32_t id) const { return domChildren[id]; }
+
+    // Constant time, using pre/post numbering of the dominator tree
+    bool dominates(uint32_t a, uint32_t b) const;
+
+    // True when no path leaves the body except through a return
+    bool allPathsReturn() const { return !isReachable(fallthroughBlock); }
+
+    size_t edgeCount() const;
+
+ private:
+    std::vector<BasicBlock> blockList;
+    std::unordered_map<const ASTNode*, uint32_t> nodeBlock;
+    uint32_t entryBlock = kNone;
+    uint32_t exitBlock = kNone;
+    uint32_t fallthroughBlock = kNone;
+
+    std::vector<uint32_t> rpo;
+    std::vector<uint32_t> rpoIndex;
+    std::vector<uint32_t> idom;
+    std::vector<std::vector<uint32_t>> domChildren;
+    std::vector<uint32_t> domPre;
+    std::vector<uint32_t> domPost;
+
+    uint32_t newBlock();
+    void addEdge(uint32_t from, uint32_t to);
+    uint32_t buildItems(const std::vector<ASTNode*>& items, uint32_t current);
+    void computeReversePostorder();
+    void computeDominators();
+    uint32_t nearestCommonDominator(const std::vector<uint32_t>& blocks) const;
+    void numberDominatorTree();
+};
+
+#endif // CFG_HPP
@@ -0,0 +1,426 @@
+#include "constant_folder.hpp"
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+
+// Main entry point
+FoldStats ConstantFolder::fold() {
+    if (!root) {
+        throw std::runtime_error("AST root is null");
+    }
+
+    ProgramNode* program = dynamic_cast<ProgramNode*>(root);
+    if (!program) {
+        throw std::runtime_error("Root is not a ProgramNode");
+    }
+
+    foldProgram(program);
+    return stats;
+}
+
+// Fold program
+void ConstantFolder::foldProgram(ProgramNode* node) {
+    scopes.emplace_back();
+
+    // Declarations are visited in source order, the same order in which
+    // analyzeProgram's second pass makes globals visible to later functions
+    for (auto decl : node->declarations) {
+        if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(decl)) {
+            foldFunctionDecl(funcDecl);
+        } else if (VarDeclNode* varDecl = dynamic_cast<VarDeclNode*>(decl)) {
+            foldVarDecl(varDecl);
+        }
+    }
+
+    scopes.pop_back();
+}
+
+// Fold a function body. Nested bodies (if, while, nested functions) go on
+// `blocks` instead of being folded by recursion, so nesting depth is bounded
+// by memory. Every frame owns one scope, pushed with the frame and popped
+// when its list is done.
+void ConstantFolder::foldFunctionDecl(FunctionDeclNode* node) {
+    enterFunction(node);
+    while (!blocks.empty()) {
+        BlockFrame& frame = blocks.back();
+        if (frame.next == frame.items->size()) {
+            IfStmtNode* ifStmt = frame.elseOwner;
+            blocks.pop_back();
+            scopes.pop_back();
+            if (ifStmt && !ifStmt->elseItems.empty()) {
+                scopes.emplace_back();
+                blocks.push_back(BlockFrame{&ifStmt->elseItems, 0, nullptr});
+            }
+            continue;
+        }
+
+        // `frame` is invalid once a nested list has been pushed. Most common
+        // item types first, as in SemanticAnalyzer::runBlocks.
+        ASTNode* item = (*frame.items)[frame.next++];
+        if (AssignmentStmtNode* assign = dynamic_cast<AssignmentStmtNode*>(item)) {
+            foldExpr(assign->value);
+        } else if (VarDeclNode* varDecl = dynamic_cast<VarDeclNode*>(item)) {
+            foldVarDecl(varDecl);
+        } else if (IfStmtNode* ifStmt = dynamic_cast<IfStmtNode*>(item)) {
+            foldExpr(ifStmt->condition);
+            scopes.emplace_back();
+            blocks.push_back(BlockFrame{&ifStmt->thenItems, 0, ifStmt});
+        } else if (WhileStmtNode* whileStmt = dynamic_cast<WhileStmtNode*>(item)) {
+            foldExpr(whileStmt->condition);
+            scopes.emplace_back();
+            blocks.push_back(BlockFrame{&whileStmt->bodyItems, 0, nullptr});
+        } else if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(item)) {
+            enterFunction(funcDecl);
+        } else if (StmtNode* stmt = dynamic_cast<StmtNode*>(item)) {
+            foldStmt(stmt);
+        }
+    }
+}
+
+// Open a function's scope and queue its body
+void ConstantFolder::enterFunction(FunctionDeclNode* node) {
+    scopes.emplace_back();
+
+    // Parameters shadow any outer constant of the same name
+    for (const auto& param : node->parameters) {
+        bind(param.name, nullptr);
+    }
+
+    blocks.push_back(BlockFrame{&node->bodyItems, 0, nullptr});
+}
+
+// Fold variable declaration, recording `let` constants
+void ConstantFolder::foldVarDecl(VarDeclNode* node) {
+    bool global = scopes.size() == 1;
+
+    // The initializer sees the outer binding, as in analyzeVarDecl
+    Constant value;
+    bool isLiteral = false;
+    sawCall = false;
+    if (node->initializer) {
+        foldExpr(node->initializer);
+        isLiteral = asConstant(node->initializer, value);
+    }
+
+    if (node->isConstant && isLiteral) {
+        constants.push_back(std::make_unique<Constant>(convertTo(node->getDataType(), value)));
+        constants.back()->readableUnset = global && globalInitCalls;
+        bind(node->name, constants.back().get());
+    } else {
+        bind(node->name, nullptr);
+    }
+
+    if (global && sawCall) {
+        globalInitCalls = true;
+    }
+}
+
+// Fold a return or print statement
+void ConstantFolder::foldStmt(StmtNode* node) {
+    if (ReturnStmtNode* ret = dynamic_cast<ReturnStmtNode*>(node)) {
+        if (ret->value) {
+            foldExpr(ret->value);
+        }
+    } else if (PrintStmtNode* print = dynamic_cast<PrintStmtNode*>(node)) {
+        foldExpr(print->expression);
+    }
+}
+
+// Fold expression bottom-up, replacing `expr` when it reduces to a literal.
+// Shallow expressions recurse; below kMaxExprRecursion levels, operators and
+// calls wait on exprFrames instead, so a deep `+` chain needs heap, not call
+// stack.
+void ConstantFolder::foldExpr(ExprNode*& expr, unsigned depth) {
+    ExprFrame frame;
+    if (!openExpr(expr, frame)) return;
+    if (depth >= kMaxExprRecursion) {
+        size_t base = exprFrames.size();
+        exprFrames.push_back(frame);
+        runExprFrames(base);
+        return;
+    }
+
+    while (ExprNode** operand = nextOperand(frame)) {
+        foldExpr(*operand, depth + 1);
+    }
+    finishExpr(frame);
+}
+
+// Fold operands of the innermost open frames until exprFrames is back at
+// `depth`
+void ConstantFolder::runExprFrames(size_t depth) {
+    while (exprFrames.size() > depth) {
+        ExprFrame& frame = exprFrames.back();
+        ExprNode** operand = nextOperand(frame);
+        if (!operand) {
+            finishExpr(frame);
+            exprFrames.pop_back();
+            continue;
+        }
+
+        ExprFrame child;
+        if (openExpr(*operand, child)) {
+            exprFrames.push_back(child);  // invalidates `frame`
+        }
+    }
+}
+
+// Classify `expr` for folding, propagating an identifier on the spot. Returns
+// true for an operator or call, whose operands still need folding. One
+// dynamic_cast ladder per node, most common node types first.
+bool ConstantFolder::openExpr(ExprNode*& expr, ExprFrame& frame) {
+    frame = ExprFrame{&expr, ExprKind::LITERAL, 0};
+    if (IdentifierNode* idNode = dynamic_cast<IdentifierNode*>(expr)) {
+        const Constant* value = lookup(idNode->name);
+        if (value) {
+            ++stats.propagatedConstants;
+            replace(expr, *value);
+        }
+        return false;
+    }
+    if (dynamic_cast<IntegerNode*>(expr)) {
+        return false;
+    }
+    if (dynamic_cast<BinaryOpNode*>(expr)) {
+        frame.kind = ExprKind::BINARY;
+    } else if (dynamic_cast<FunctionCallNode*>(expr)) {
+        frame.kind = ExprKind::CALL;
+    } else if (dynamic_cast<UnaryOpNode*>(expr)) {
+        frame.kind = ExprKind::UNARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The slot of the operand to fold next, or nullptr once all are done
+ExprNode** ConstantFolder::nextOperand(ExprFrame& frame) {
+    size_t index = frame.next;
+    ExprNode** operand = nullptr;
+    switch (frame.kind) {
+        case ExprKind::BINARY: {
+            BinaryOpNode* binOp = static_cast<BinaryOpNode*>(*frame.slot);
+            if (index == 0) operand = &binOp->left;
+            else if (index == 1) operand = &binOp->right;
+            break;
+        }
+        case ExprKind::UNARY:
+            if (index == 0) operand = &static_cast<UnaryOpNode*>(*frame.slot)->operand;
+            break;
+        case ExprKind::CALL: {
+            FunctionCallNode* callNode = static_cast<FunctionCallNode*>(*frame.slot);
+            if (index < callNode->arguments.size()) operand = &callNode->arguments[index];
+            break;
+        }
+        default:
+            break;
+    }
+    if (operand) {
+        ++frame.next;
+    }
+    return operand;
+}
+
+// Replace a finished operator whose operands all folded to literals
+void ConstantFolder::finishExpr(const ExprFrame& frame) {
+    ExprNode*& expr = *frame.slot;
+    if (frame.kind == ExprKind::BINARY) {
+        BinaryOpNode* binOp = static_cast<BinaryOpNode*>(expr);
+        Constant left, right, result;
+        if (asConstant(binOp->left, left) && asConstant(binOp->right, right) &&
+            evaluateBinary(binOp->op, left, right, result)) {
+            ++stats.foldedExpressions;
+            replace(expr, result);
+        }
+    } else if (frame.kind == ExprKind::UNARY) {
+        UnaryOpNode* unOp = static_cast<UnaryOpNode*>(expr);
+        Constant operand, result;
+        if (asConstant(unOp->operand, operand) &&
+            evaluateUnary(unOp->op, operand, result)) {
+            ++stats.foldedExpressions;
+            replace(expr, result);
+        }
+    } else if (frame.kind == ExprKind::CALL) {
+        sawCall = true;
+    }
+}
+
+// Read a literal node into a Constant
+bool ConstantFolder::asConstant(const ExprNode* expr, Constant& out) const {
+    out = Constant{DataType::IOTA, 0, 0.0, false};
+    if (const IntegerNode* intNode = dynamic_cast<const IntegerNode*>(expr)) {
+        out.type = DataType::INT;
+        out.intValue = intNode->value;
+        return true;
+    }
+    if (const FloatNode* floatNode = dynamic_cast<const FloatNode*>(expr)) {
+        out.type = DataType::FLOAT;
+        out.floatValue = floatNode->value;
+        return true;
+    }
+    if (const BoolNode* boolNode = dynamic_cast<const BoolNode*>(expr)) {
+        out.type = DataType::BOOL;
+        out.boolValue = boolNode->value;
+        return true;
+    }
+    return false;
+}
+
+// Evaluate a binary operator on two constants. Mirrors analyzeExpr: arithmetic
+// and ordering promote to FLOAT when either side is FLOAT, equality requires
+// matching types (which the analyzer has already checked).
+bool ConstantFolder::evaluateBinary(const std::string& op, const Constant& left,
+                                    const Constant& right, Constant& out) const {
+    out = Constant{DataType::IOTA, 0, 0.0, false};
+    bool bothInt = left.type == DataType::INT && right.type == DataType::INT;
+    double l = left.type == DataType::FLOAT ? left.floatValue : left.intValue;
+    double r = right.type == DataType::FLOAT ? right.floatValue : right.intValue;
+
+    if (op == "+" || op == "-" || op == "*" || op == "/") {
+        if (bothInt) {
+            int64_t a = left.intValue, b = right.intValue, result;
+            if (op == "+") result = a + b;
+            else if (op == "-") result = a - b;
+            else if (op == "*") result = a * b;
+            else {
+                // Division by zero is a runtime error, not a compile-time one
+                if (b == 0) return false;
+                result = a / b;
+            }
+            // Leave anything an IntegerNode cannot hold to the 64-bit runtime
+            if (result < INT_MIN || result > INT_MAX) return false;
+            out.type = DataType::INT;
+            out.intValue = static_cast<int>(result);
+            return true;
+        }
+        out.type = DataType::FLOAT;
+        if (op == "+") out.floatValue = l + r;
+        else if (op == "-") out.floatValue = l - r;
+        else if (op == "*") out.floatValue = l * r;
+        else out.floatValue = l / r;
+        return true;
+    }
+
+    if (op == "<" || op == ">" || op == "<=" || op == ">=") {
+        out.type = DataType::BOOL;
+        if (bothInt) {
+            int a = left.intValue, b = right.intValue;
+            out.boolValue = op == "<" ? a < b : op == ">" ? a > b : op == "<=" ? a <= b : a >= b;
+        } else {
+            out.boolValue = op == "<" ? l < r : op == ">" ? l > r : op == "<=" ? l <= r : l >= r;
+        }
+        return true;
+    }
+
+    if (op == "==" || op == "!=") {
+        if (left.type != right.type) return false;
+        bool equal;
+        if (left.type == DataType::INT) equal = left.intValue == right.intValue;
+        else if (left.type == DataType::FLOAT) equal = left.floatValue == right.floatValue;
+        else equal = left.boolValue == right.boolValue;
+        out.type = DataType::BOOL;
+        out.boolValue = (op == "==") ? equal : !equal;
+        return true;
+    }
+
+    return false;
+}
+
+// Evaluate a unary operator on a constant
+bool ConstantFolder::evaluateUnary(const std::string& op, const Constant& operand,
+                                   Constant& out) const {
+    out = operand;
+    if (op != "-") {
+        return false;
+    }
+    if (operand.type == DataType::INT) {
+        if (operand.intValue == INT_MIN) return false;
+        out.intValue = -operand.intValue;
+        return true;
+    }
+    if (operand.type == DataType::FLOAT) {
+        out.floatValue = -operand.floatValue;
+        return true;
+    }
+    return false;
+}
+
+// Apply the assignment conversions isAssignmentCompatible allows
+ConstantFolder::Constant ConstantFolder::convertTo(DataType target, const Constant& value) const {
+    Constant result = value;
+    if (target == DataType::FLOAT && value.type == DataType::INT) {
+        result.type = DataType::FLOAT;
+        result.floatValue = value.intValue;
+    } else if (target == DataType::BOOL && value.type == DataType::INT) {
+        result.type = DataType::BOOL;
+        result.boolValue = value.intValue != 0;
+    } else if (target == DataType::INT && value.type == DataType::BOOL) {
+        result.type = DataType::INT;
+        result.intValue = value.boolValue ? 1 : 0;
+    }
+    return result;
+}
+
+ExprNode* ConstantFolder::makeLiteral(const Constant& value) const {
+    if (value.type == DataType::FLOAT) {
+        return new FloatNode(value.floatValue);
+    }
+    if (value.type == DataType::BOOL) {
+        return new BoolNode(value.boolValue);
+    }
+    return new IntegerNode(value.intValue);
+}
+
+// Swap a subtree for a literal and account for the nodes that disappear.
+// The literal keeps the subtree's span, so diagnostics and dumps still point
+// at the folded source.
+void ConstantFolder::replace(ExprNode*& expr, const Constant& value) {
+    stats.nodesRemoved += countNodes(expr) - 1;
+    ExprNode* literal = makeLiteral(value);
+    literal->span = expr->span;
+    delete expr;
+    expr = literal;
+}
+
+void ConstantFolder::bind(const std::string& name, const Constant* value) {
+    scopes.back()[name] = value;
+}
+
+const ConstantFolder::Constant* ConstantFolder::lookup(const std::string& name) const {
+    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+        auto found = it->find(name);
+        if (found == it->end()) {
+            continue;
+        }
+        // Only a global can be readableUnset, and only function bodies see
+        // it from an inner scope
+        const Constant* value = found->second;
+        if (value && value->readableUnset && scopes.size() > 1) {
+            return nullptr;
+        }
+        return value;
+    }
+    return nullptr;
+}
+
+// Nodes in the subtree under `expr`, counted from a worklist
+size_t ConstantFolder::countNodes(const ExprNode* expr) {
+    size_t count = 0;
+    countStack.clear();
+    countStack.push_back(expr);
+    while (!countStack.empty()) {
+        const ExprNode* node = countStack.back();
+        countStack.pop_back();
+        ++count;
+        if (const BinaryOpNode* binOp = dynamic_cast<const BinaryOpNode*>(node)) {
+            countStack.push_back(binOp->left);
+            countStack.push_back(binOp->right);
+        } else if (const UnaryOpNode* unOp = dynamic_cast<const UnaryOpNode*>(node)) {
+            countStack.push_back(unOp->operand);
+        } else if (const FunctionCallNode* callNode = dynamic_cast<const FunctionCallNode*>(node)) {
+            countStack.insert(countStack.end(), callNode->arguments.begin(),
+                              callNode->arguments.end());
+        }
+    }
+    return count;
+}
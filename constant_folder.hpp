@@ -0,0 +1,107 @@
+#ifndef CONSTANT_FOLDER_HPP
+#define CONSTANT_FOLDER_HPP
+
+#include "astnode.hpp"
+#include "data_type.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Counters reported by ConstantFolder::fold()
+struct FoldStats {
+    size_t foldedExpressions = 0;    // BinaryOpNode/UnaryOpNode trees replaced by a literal
+    size_t propagatedConstants = 0;  // identifier uses of a `let` replaced by its value
+    size_t nodesRemoved = 0;         // net reduction in AST node count
+};
+
+// Optimization pass that runs after SemanticAnalyzer. It rewrites the AST in
+// place:
+//   - BinaryOpNode/UnaryOpNode with literal operands become a single literal,
+//     using the same INT/FLOAT promotion rules as analyzeExpr
+//   - uses of a `let` whose initializer folds to a literal are replaced by
+//     that literal, converted to the constant's declared type
+//
+// Folding never changes observable behaviour: integer results that would not
+// fit in an IntegerNode and integer division by zero are left for runtime.
+// Global initializers run in <init> in source order, so a function called
+// from one can read a later global `let` while it still holds zero. A global
+// `let` declared after any initializer that calls a function is therefore
+// only propagated into other global initializers, never into function bodies.
+class ConstantFolder {
+ private:
+    // A literal value of one of the three source types
+    struct Constant {
+        DataType type;
+        int intValue;
+        double floatValue;
+        bool boolValue;
+        bool readableUnset = false;  // global a function may read before <init> sets it
+    };
+
+    // nullptr entry = name is bound but not a known constant (shadows outer lets)
+    using ConstantScope = std::unordered_map<std::string, const Constant*>;
+
+    // A statement list being folded; each one owns the innermost scope
+    struct BlockFrame {
+        const std::vector<ASTNode*>* items;
+        size_t next;             // index of the next item
+        IfStmtNode* elseOwner;   // then-branch of this if, whose else comes next
+    };
+
+    enum class ExprKind : uint8_t { IDENTIFIER, LITERAL, BINARY, UNARY, CALL };
+
+    // An operator or call whose operands are still being folded
+    struct ExprFrame {
+        ExprNode** slot;         // where the node hangs, so it can be replaced
+        ExprKind kind;
+        size_t next;             // operands handed out so far
+    };
+
+    ASTNode* root;
+    FoldStats stats;
+    std::vector<ConstantScope> scopes;
+    std::vector<std::unique_ptr<Constant>> constants;
+    std::vector<BlockFrame> blocks;
+    std::vector<ExprFrame> exprFrames;
+    std::vector<const ExprNode*> countStack;
+    bool sawCall = false;            // the current initializer calls a function
+    bool globalInitCalls = false;    // some global initializer so far does
+
+    // Expression nesting foldExpr recurses through before it hands the rest
+    // to exprFrames, as in SemanticAnalyzer
+    static constexpr unsigned kMaxExprRecursion = 64;
+
+    void foldProgram(ProgramNode* node);
+    void foldFunctionDecl(FunctionDeclNode* node);
+    void enterFunction(FunctionDeclNode* node);
+    void foldVarDecl(VarDeclNode* node);
+    void foldStmt(StmtNode* node);
+    void foldExpr(ExprNode*& expr, unsigned depth = 0);
+    void runExprFrames(size_t depth);
+    bool openExpr(ExprNode*& expr, ExprFrame& frame);
+    ExprNode** nextOperand(ExprFrame& frame);
+    void finishExpr(const ExprFrame& frame);
+
+    bool asConstant(const ExprNode* expr, Constant& out) const;
+    bool evaluateBinary(const std::string& op, const Constant& left, const Constant& right,
+                        Constant& out) const;
+    bool evaluateUnary(const std::string& op, const Constant& operand, Constant& out) const;
+    Constant convertTo(DataType target, const Constant& value) const;
+    ExprNode* makeLiteral(const Constant& value) const;
+    void replace(ExprNode*& expr, const Constant& value);
+
+    void bind(const std::string& name, const Constant* value);
+    const Constant* lookup(const std::string& name) const;
+
+    size_t countNodes(const ExprNode* expr);
+
+ public:
+    explicit ConstantFolder(ASTNode* root) : root(root) {}
+
+    FoldStats fold();
+};
+
+#endif // CONSTANT_FOLDER_HPP
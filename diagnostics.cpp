@@ -0,0 +1,237 @@
+#include "diagnostics.hpp"
+#include <cstring>
+#include "json.hpp"
+
+const char* semanticErrorTypeName(SemanticErrorType type) {
+    switch (type) {
+        case SemanticErrorType::REDECLARED_FUNCTION: return "REDECLARED_FUNCTION";
+        case SemanticErrorType::REDECLARED_IDENTIFIER: return "REDECLARED_IDENTIFIER";
+        case SemanticErrorType::UNREACHABLE_CODE: return "UNREACHABLE_CODE";
+        case SemanticErrorType::VAR_DECL_TYPE_MISMATCH: return "VAR_DECL_TYPE_MISMATCH";
+        case SemanticErrorType::UNDECLARED_IDENTIFIER: return "UNDECLARED_IDENTIFIER";
+        case SemanticErrorType::FUNCTION_USED_AS_VARIABLE: return "FUNCTION_USED_AS_VARIABLE";
+        case SemanticErrorType::VAR_ASSIGN_TO_CONSTANT: return "VAR_ASSIGN_TO_CONSTANT";
+        case SemanticErrorType::VAR_ASSIGN_TYPE_MISMATCH: return "VAR_ASSIGN_TYPE_MISMATCH";
+        case SemanticErrorType::RETURN_OUTSIDE_FUNCTION: return "RETURN_OUTSIDE_FUNCTION";
+        case SemanticErrorType::RETURN_TYPE_MISMATCH: return "RETURN_TYPE_MISMATCH";
+        case SemanticErrorType::CONDITION_NOT_BOOL: return "CONDITION_NOT_BOOL";
+        case SemanticErrorType::INVALID_BINARY_OPERATION: return "INVALID_BINARY_OPERATION";
+        case SemanticErrorType::INVALID_UNARY_OPERATION: return "INVALID_UNARY_OPERATION";
+        case SemanticErrorType::UNDECLARED_FUNCTION: return "UNDECLARED_FUNCTION";
+        case SemanticErrorType::NOT_A_FUNCTION: return "NOT_A_FUNCTION";
+        case SemanticErrorType::WRONG_NUMBER_OF_ARGUMENTS: return "WRONG_NUMBER_OF_ARGUMENTS";
+        case SemanticErrorType::INVALID_SIGNATURE: return "INVALID_SIGNATURE";
+        case SemanticErrorType::MISSING_RETURN: return "MISSING_RETURN";
+        default: return "SEMANTIC_ERROR";
+    }
+}
+
+const char* diagnosticKindName(DiagnosticKind kind) {
+    switch (kind) {
+        case DiagnosticKind::SYNTAX: return "syntax";
+        case DiagnosticKind::SEMANTIC: return "semantic";
+        case DiagnosticKind::RUNTIME: return "runtime";
+        case DiagnosticKind::INPUT: return "input";
+    }
+    return "unknown";
+}
+
+Diagnostic syntaxDiagnostic(const SyntaxError& error) {
+    Diagnostic diagnostic = messageDiagnostic(
+        DiagnosticKind::SYNTAX, "syntax error at line " + std::to_string(error.line) +
+                                ", column " + std::to_string(error.column));
+    diagnostic.span = SourceSpan{error.line, error.column, error.line, error.column};
+    return diagnostic;
+}
+
+Diagnostic semanticDiagnostic(const SemanticError& error) {
+    // Only SemanticException knows how to word the error
+    Diagnostic diagnostic = messageDiagnostic(
+        DiagnosticKind::SEMANTIC, SemanticException(error.type, error.context).what());
+    diagnostic.semanticType = error.type;
+    if (error.node) {
+        diagnostic.span = error.node->span;
+    }
+    diagnostic.detail = error.detail;
+    return diagnostic;
+}
+
+Diagnostic messageDiagnostic(DiagnosticKind kind, const std::string& message) {
+    Diagnostic diagnostic;
+    diagnostic.kind = kind;
+    diagnostic.semanticType = SemanticErrorType();
+    diagnostic.message = message;
+    return diagnostic;
+}
+
+bool parseDiagnosticsFormat(const char* name, DiagnosticsFormat& format) {
+    if (std::strcmp(name, "text") == 0) {
+        format = DiagnosticsFormat::TEXT;
+    } else if (std::strcmp(name, "jsonl") == 0) {
+        format = DiagnosticsFormat::JSONL;
+    } else if (std::strcmp(name, "sarif") == 0) {
+        format = DiagnosticsFormat::SARIF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+// Rule ids for the kinds that have no SemanticErrorType
+const char* ruleId(const Diagnostic& diagnostic) {
+    switch (diagnostic.kind) {
+        case DiagnosticKind::SYNTAX: return "SYNTAX_ERROR";
+        case DiagnosticKind::SEMANTIC: return semanticErrorTypeName(diagnostic.semanticType);
+        case DiagnosticKind::RUNTIME: return "RUNTIME_ERROR";
+        case DiagnosticKind::INPUT: return "INPUT_ERROR";
+    }
+    return "ERROR";
+}
+
+const SemanticErrorType kSemanticErrorTypes[] = {
+    SemanticErrorType::REDECLARED_FUNCTION,
+    SemanticErrorType::REDECLARED_IDENTIFIER,
+    SemanticErrorType::UNREACHABLE_CODE,
+    SemanticErrorType::VAR_DECL_TYPE_MISMATCH,
+    SemanticErrorType::UNDECLARED_IDENTIFIER,
+    SemanticErrorType::FUNCTION_USED_AS_VARIABLE,
+    SemanticErrorType::VAR_ASSIGN_TO_CONSTANT,
+    SemanticErrorType::VAR_ASSIGN_TYPE_MISMATCH,
+    SemanticErrorType::RETURN_OUTSIDE_FUNCTION,
+    SemanticErrorType::RETURN_TYPE_MISMATCH,
+    SemanticErrorType::CONDITION_NOT_BOOL,
+    SemanticErrorType::INVALID_BINARY_OPERATION,
+    SemanticErrorType::INVALID_UNARY_OPERATION,
+    SemanticErrorType::UNDECLARED_FUNCTION,
+    SemanticErrorType::NOT_A_FUNCTION,
+    SemanticErrorType::WRONG_NUMBER_OF_ARGUMENTS,
+    SemanticErrorType::INVALID_SIGNATURE,
+    SemanticErrorType::MISSING_RETURN,
+};
+
+bool hasSpan(const Diagnostic& diagnostic) {
+    return diagnostic.span.firstLine > 0;
+}
+
+void writeTypes(std::ostream& out, const std::vector<DataType>& types) {
+    out << "[";
+    for (size_t i = 0; i < types.size(); ++i) {
+        out << (i ? "," : "") << "\"" << dataTypeName(types[i]) << "\"";
+    }
+    out << "]";
+}
+
+// The SemanticErrorDetail fields that are set, as JSON members after `{`
+void writeDetailMembers(std::ostream& out, const SemanticErrorDetail& detail, bool first) {
+    auto separator = [&first, &out] {
+        if (!first) out << ",";
+        first = false;
+    };
+    if (!detail.name.empty()) {
+        separator();
+        out << "\"name\":" << jsonString(detail.name);
+    }
+    if (!detail.expected.empty()) {
+        separator();
+        out << "\"expected\":";
+        writeTypes(out, detail.expected);
+    }
+    if (!detail.found.empty()) {
+        separator();
+        out << "\"found\":";
+        writeTypes(out, detail.found);
+    }
+    if (detail.expectedCount >= 0) {
+        separator();
+        out << "\"expectedCount\":" << detail.expectedCount;
+    }
+    if (detail.foundCount >= 0) {
+        separator();
+        out << "\"foundCount\":" << detail.foundCount;
+    }
+}
+
+} // namespace
+
+void DiagnosticWriter::begin() {
+    if (format != DiagnosticsFormat::SARIF) {
+        return;
+    }
+    out << "{\"version\":\"2.1.0\","
+           "\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\","
+           "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"semanticdriver\",\"rules\":["
+           "{\"id\":\"SYNTAX_ERROR\"},{\"id\":\"RUNTIME_ERROR\"},{\"id\":\"INPUT_ERROR\"}";
+    for (SemanticErrorType type : kSemanticErrorTypes) {
+        out << ",{\"id\":\"" << semanticErrorTypeName(type) << "\"}";
+    }
+    out << "]}},\"results\":[";
+    out.flush();
+}
+
+void DiagnosticWriter::file(const std::string& path, const std::vector<Diagnostic>& diagnostics) {
+    for (const Diagnostic& diagnostic : diagnostics) {
+        if (format == DiagnosticsFormat::SARIF) {
+            writeSarifResult(path, diagnostic);
+        } else {
+            writeJsonLine(path, diagnostic);
+        }
+    }
+    out.flush();
+}
+
+void DiagnosticWriter::end() {
+    if (format == DiagnosticsFormat::SARIF) {
+        out << "\n]}]}\n";
+        out.flush();
+    }
+}
+
+// {"file":..,"kind":"semantic","type":"UNDECLARED_IDENTIFIER","message":..,
+//  "span":{"firstLine":..,..}|null,"context":{"name":"y",..}}
+void DiagnosticWriter::writeJsonLine(const std::string& path, const Diagnostic& diagnostic) {
+    out << "{\"file\":" << jsonString(path) << ",\"kind\":\""
+        << diagnosticKindName(diagnostic.kind) << "\",\"type\":";
+    if (diagnostic.kind == DiagnosticKind::SEMANTIC) {
+        out << "\"" << semanticErrorTypeName(diagnostic.semanticType) << "\"";
+    } else {
+        out << "null";
+    }
+    out << ",\"message\":" << jsonString(diagnostic.message) << ",\"span\":";
+    if (hasSpan(diagnostic)) {
+        const SourceSpan& span = diagnostic.span;
+        out << "{\"firstLine\":" << span.firstLine << ",\"firstColumn\":" << span.firstColumn
+            << ",\"lastLine\":" << span.lastLine << ",\"lastColumn\":" << span.lastColumn << "}";
+    } else {
+        out << "null";
+    }
+    out << ",\"context\":{";
+    writeDetailMembers(out, diagnostic.detail, true);
+    out << "}}\n";
+}
+
+void DiagnosticWriter::writeSarifResult(const std::string& path, const Diagnostic& diagnostic) {
+    out << (firstResult ? "\n" : ",\n");
+    firstResult = false;
+    out << "{\"ruleId\":\"" << ruleId(diagnostic) << "\",\"level\":\"error\","
+        << "\"message\":{\"text\":" << jsonString(diagnostic.message) << "},"
+        << "\"locations\":[{\"physicalLocation\":{\"artifactLocation\":{\"uri\":"
+        << jsonString(path) << "}";
+    if (hasSpan(diagnostic)) {
+        // SARIF's endColumn is one past the last character
+        const SourceSpan& span = diagnostic.span;
+        out << ",\"region\":{\"startLine\":" << span.firstLine;
+        if (span.firstColumn > 0) {
+            out << ",\"startColumn\":" << span.firstColumn;
+        }
+        out << ",\"endLine\":" << span.lastLine;
+        if (span.lastColumn > 0) {
+            out << ",\"endColumn\":" << span.lastColumn + 1;
+        }
+        out << "}";
+    }
+    out << "}}],\"properties\":{\"kind\":\"" << diagnosticKindName(diagnostic.kind) << "\"";
+    writeDetailMembers(out, diagnostic.detail, false);
+    out << "}}";
+}
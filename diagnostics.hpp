@@ -0,0 +1,72 @@
+#ifndef DIAGNOSTICS_HPP
+#define DIAGNOSTICS_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "astnode.hpp"
+#include "exception.hpp"
+#include "frontend.hpp"
+#include "semantic_analyzer.hpp"
+
+// Structured diagnostics: what AnalysisContext hands back, and what
+// semanticdriver --diagnostics streams as JSON Lines or SARIF instead of
+// free-form stderr text.
+
+enum class DiagnosticKind {
+    SYNTAX,
+    SEMANTIC,
+    RUNTIME,    // semanticdriver --run only
+    INPUT       // unreadable file; semanticdriver only
+};
+
+struct Diagnostic {
+    DiagnosticKind kind;
+    SemanticErrorType semanticType;     // SEMANTIC only
+    SourceSpan span;                    // all zero when unknown
+    std::string message;
+    SemanticErrorDetail detail;         // SEMANTIC only
+};
+
+// The name of a SemanticErrorType's enumerator, e.g. "UNDECLARED_IDENTIFIER"
+const char* semanticErrorTypeName(SemanticErrorType type);
+
+// "syntax", "semantic", "runtime" or "input"
+const char* diagnosticKindName(DiagnosticKind kind);
+
+Diagnostic syntaxDiagnostic(const SyntaxError& error);
+Diagnostic semanticDiagnostic(const SemanticError& error);
+Diagnostic messageDiagnostic(DiagnosticKind kind, const std::string& message);
+
+enum class DiagnosticsFormat {
+    TEXT,       // plain stderr messages; no DiagnosticWriter
+    JSONL,      // one JSON object per diagnostic and line
+    SARIF       // one SARIF 2.1.0 log for the whole run
+};
+
+// "text", "jsonl" or "sarif"; returns false for anything else
+bool parseDiagnosticsFormat(const char* name, DiagnosticsFormat& format);
+
+// Writes JSONL or SARIF diagnostics one file at a time and flushes after
+// each file, so a consumer sees them as soon as the file is done. SARIF
+// output is a single JSON document: begin() opens it and end() closes it.
+// Not thread-safe; callers serialize file() calls.
+class DiagnosticWriter {
+ private:
+    std::ostream& out;
+    DiagnosticsFormat format;
+    bool firstResult;
+
+    void writeJsonLine(const std::string& path, const Diagnostic& diagnostic);
+    void writeSarifResult(const std::string& path, const Diagnostic& diagnostic);
+
+ public:
+    DiagnosticWriter(std::ostream& out, DiagnosticsFormat format)
+        : out(out), format(format), firstResult(true) {}
+
+    void begin();
+    void file(const std::string& path, const std::vector<Diagnostic>& diagnostics);
+    void end();
+};
+
+#endif // DIAGNOSTICS_HPP
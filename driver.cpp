@@ -0,0 +1,1052 @@
+// semanticdriver: analyze programs and optionally execute them on the
+// bytecode VM.
+//
+//   semanticdriver [--fold] [--cfg] [--run] [--time] [--stats[=json]] [--perf]
+//                  [--disassemble] [--dump[=FMT]] [--diagnostics=FMT]
+//                  [--diagnostics-file FILE]
+//                  [--jobs N | --processes N | --pipeline[=R,S,P,A]]
+//                  [--ingest[=uring|pread]] [--trace FILE] <file>...
+//   semanticdriver --watch <file or directory>...
+//
+// Exit status is 0 when every file passes, 1 on a syntax error, 2 on a
+// semantic error, 3 on a runtime error and 4 when a file crashed every
+// worker process that tried it, or the workers were lost (--processes).
+//
+// With --jobs, files are handed to N worker threads from a shared queue.
+// The scanner and parser keep their state in globals, so scanning and
+// parsing are serialized behind one lock; everything after parsing runs in
+// parallel. Each file's output is buffered and written as one piece when the
+// file finishes.
+//
+// With --processes, ShardCoordinator forks N worker processes and hands
+// them shards of the file list over socketpairs; output is merged in file
+// order, and the work of a worker that crashes is given to a new one.
+//
+// With --pipeline, reading, scanning, parsing and analysis are stages with
+// their own threads, handing files on through bounded queues; see
+// FilePipeline. --stats then also reports each stage's utilization and each
+// queue's occupancy.
+//
+// With --ingest, one thread reads all files ahead of the workers through
+// FileIngestor (io_uring, or pread where that is unavailable) and the
+// workers take complete buffers in the order the reads finish.
+//
+// With --diagnostics=jsonl or =sarif, errors are collected per file as
+// Diagnostic values and streamed in that format (to stderr unless
+// --diagnostics-file is given) as each file finishes, instead of as text.
+// While that stream has stderr to itself, the text reports that normally go
+// there (--time, --stats, --fold and the driver's own notes) go to stdout.
+//
+// --watch checks the files (and every *.txt file in the directories) once,
+// then stays running: whenever inotify reports a save it re-checks just the
+// changed files against the results kept for the rest, and prints a fresh
+// summary.
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "astnode.hpp"
+#include "ast_dump.hpp"
+#include "bytecode.hpp"
+#include "bytecode_compiler.hpp"
+#include "cfg.hpp"
+#include "constant_folder.hpp"
+#include "diagnostics.hpp"
+#include "exception.hpp"
+#include "frontend.hpp"
+#include "ingest.hpp"
+#include "perf_counters.hpp"
+#include "pipeline.hpp"
+#include "semantic_analyzer.hpp"
+#include "shard_coordinator.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "vm.hpp"
+#include "watch.hpp"
+
+namespace {
+
+enum class StatsFormat { NONE, TEXT, JSON };
+
+struct DriverOptions {
+    bool fold = false;
+    bool cfg = false;
+    bool run = false;
+    bool time = false;
+    bool disassemble = false;
+    bool dump = false;
+    DumpFormat dumpFormat = DumpFormat::TEXT;
+    DiagnosticsFormat diagnostics = DiagnosticsFormat::TEXT;
+    std::string diagnosticsPath;
+    StatsFormat stats = StatsFormat::NONE;
+    bool perf = false;
+    unsigned jobs = 1;
+    unsigned processes = 1;
+    bool ingest = false;
+    IngestBackend ingestBackend = IngestBackend::IO_URING;
+    bool pipeline = false;
+    unsigned pipelineThreads[4] = {1, 1, 1, 2};  // read, scan, parse, analyze
+    std::string tracePath;
+    bool watch = false;
+    std::vector<std::string> files;
+};
+
+// Where one file's work writes its output and trace events
+struct FileContext {
+    uint32_t index;
+    std::ostream& out;
+    std::ostream& err;
+    TraceBuffer* trace;  // nullptr unless --trace
+    std::vector<Diagnostic>* diagnostics;  // nullptr unless --diagnostics
+    IngestedFile* ingested;  // the file already read, with --ingest
+    bool buffered;           // out/err are this file's own buffers
+};
+
+// Hands files to the workers. Without --ingest a worker takes the next index
+// and reads the file itself. With it, the ingestion thread pushes complete
+// buffers and workers take them in that order; push() blocks while
+// `capacity` buffers are waiting, so reading cannot run far ahead of
+// analysis.
+class FileQueue {
+ private:
+    std::mutex mutex;
+    std::condition_variable filled, drained;
+    size_t nextFile;
+    size_t fileCount;
+    bool ingest;
+    std::deque<IngestedFile> ready;
+    size_t capacity;
+    bool finished;
+
+ public:
+    FileQueue(size_t fileCount, bool ingest, size_t capacity)
+        : nextFile(0), fileCount(fileCount), ingest(ingest), capacity(capacity), finished(false) {}
+
+    // The next file to process; false once every file has been handed out
+    bool pop(size_t& index, IngestedFile& file) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!ingest) {
+            if (nextFile >= fileCount) {
+                return false;
+            }
+            index = nextFile++;
+            return true;
+        }
+        filled.wait(lock, [this] { return !ready.empty() || finished; });
+        if (ready.empty()) {
+            return false;
+        }
+        file = std::move(ready.front());
+        ready.pop_front();
+        index = file.index;
+        drained.notify_one();
+        return true;
+    }
+
+    void push(IngestedFile& file) {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] { return ready.size() < capacity; });
+        ready.push_back(std::move(file));
+        filled.notify_one();
+    }
+
+    // The ingestion thread has pushed every file
+    void finish() {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished = true;
+        filled.notify_all();
+    }
+};
+
+void printUsage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--fold] [--cfg] [--run] [--time] [--stats[=json]] [--perf]\n"
+              << "       [--disassemble] [--dump[=FMT]] [--diagnostics=FMT] [--diagnostics-file FILE]\n"
+              << "       [--jobs N | --processes N | --pipeline[=R,S,P,A]] [--ingest[=uring|pread]]\n"
+              << "       [--trace FILE] <file>...\n"
+              << "       " << argv0 << " --watch <file or directory>...\n"
+              << "  --fold         fold constant expressions and propagate let constants\n"
+              << "  --cfg          print each function's control-flow graph and dominators\n"
+              << "  --run          compile to bytecode and execute main()\n"
+              << "  --time         report per-phase wall time on stderr\n"
+              << "  --stats        report per-phase wall/CPU time, AST node counts and\n"
+              << "                 symbol-table counters on stderr (=json: one JSON line per file)\n"
+              << "  --perf         add hardware counters (cycles, IPC, branch/cache misses) to\n"
+              << "                 --stats; implies --stats when it is not given\n"
+              << "  --disassemble  print the bytecode listing\n"
+              << "  --dump[=FMT]   print the analyzed AST as text (default), json, sexpr or dot\n"
+              << "  --diagnostics=FMT  report errors as jsonl (one JSON object per line) or\n"
+              << "                 sarif (a SARIF 2.1.0 log), flushed after every file\n"
+              << "  --diagnostics-file FILE  write them to FILE instead of stderr (without\n"
+              << "                 it, reports that would share stderr go to stdout)\n"
+              << "  --jobs N       process files on N worker threads\n"
+              << "  --processes N  process shards of the file list in N worker processes;\n"
+              << "                 output stays in file order\n"
+              << "  --ingest[=uring|pread]  read all files ahead of the workers, many at a\n"
+              << "                 time on io_uring (default) or one by one with pread\n"
+              << "  --pipeline[=R,S,P,A]  read, scan, parse and analyze files as four stages\n"
+              << "                 with R, S, P and A threads (default 1,1,1,2) and bounded\n"
+              << "                 queues between them; --stats adds queue occupancy\n"
+              << "  --trace FILE   write a Chrome trace-event timeline of every file's phases\n"
+              << "  --watch        check the files and directories, then re-check whatever\n"
+              << "                 changes until interrupted; takes no other options\n";
+}
+
+bool parseArgs(int argc, char** argv, DriverOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--fold") == 0) {
+            options.fold = true;
+        } else if (std::strcmp(argv[i], "--cfg") == 0) {
+            options.cfg = true;
+        } else if (std::strcmp(argv[i], "--run") == 0) {
+            options.run = true;
+        } else if (std::strcmp(argv[i], "--time") == 0) {
+            options.time = true;
+        } else if (std::strcmp(argv[i], "--stats") == 0 || std::strcmp(argv[i], "--stats=text") == 0) {
+            options.stats = StatsFormat::TEXT;
+        } else if (std::strcmp(argv[i], "--stats=json") == 0) {
+            options.stats = StatsFormat::JSON;
+        } else if (std::strcmp(argv[i], "--perf") == 0) {
+            options.perf = true;
+        } else if (std::strcmp(argv[i], "--dump") == 0) {
+            options.dump = true;
+        } else if (std::strncmp(argv[i], "--dump=", 7) == 0) {
+            if (!parseDumpFormat(argv[i] + 7, options.dumpFormat)) {
+                std::cerr << "--dump: unknown format " << (argv[i] + 7) << "\n";
+                return false;
+            }
+            options.dump = true;
+        } else if (std::strncmp(argv[i], "--diagnostics=", 14) == 0) {
+            if (!parseDiagnosticsFormat(argv[i] + 14, options.diagnostics)) {
+                std::cerr << "--diagnostics: unknown format " << (argv[i] + 14) << "\n";
+                return false;
+            }
+        } else if (std::strcmp(argv[i], "--diagnostics-file") == 0 && i + 1 < argc) {
+            options.diagnosticsPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--disassemble") == 0) {
+            options.disassemble = true;
+        } else if (std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            int jobs = std::atoi(argv[++i]);
+            if (jobs < 1) {
+                std::cerr << "--jobs needs a positive count\n";
+                return false;
+            }
+            options.jobs = static_cast<unsigned>(jobs);
+        } else if (std::strcmp(argv[i], "--processes") == 0 && i + 1 < argc) {
+            int processes = std::atoi(argv[++i]);
+            if (processes < 1) {
+                std::cerr << "--processes needs a positive count\n";
+                return false;
+            }
+            options.processes = static_cast<unsigned>(processes);
+        } else if (std::strcmp(argv[i], "--ingest") == 0) {
+            options.ingest = true;
+        } else if (std::strncmp(argv[i], "--ingest=", 9) == 0) {
+            if (!parseIngestBackend(argv[i] + 9, options.ingestBackend)) {
+                std::cerr << "--ingest: unknown backend " << (argv[i] + 9) << "\n";
+                return false;
+            }
+            options.ingest = true;
+        } else if (std::strcmp(argv[i], "--pipeline") == 0) {
+            options.pipeline = true;
+        } else if (std::strncmp(argv[i], "--pipeline=", 11) == 0) {
+            unsigned* threads = options.pipelineThreads;
+            char end;
+            if (std::sscanf(argv[i] + 11, "%u,%u,%u,%u%c", &threads[0], &threads[1], &threads[2],
+                            &threads[3], &end) != 4 ||
+                !threads[0] || !threads[1] || !threads[2] || !threads[3]) {
+                std::cerr << "--pipeline needs four positive thread counts: READ,SCAN,PARSE,ANALYZE\n";
+                return false;
+            }
+            options.pipeline = true;
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.tracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--watch") == 0) {
+            options.watch = true;
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Unknown option: " << argv[i] << "\n";
+            return false;
+        } else {
+            options.files.push_back(argv[i]);
+        }
+    }
+    if (options.watch && (options.fold || options.cfg || options.run || options.time ||
+                          options.disassemble || options.dump || options.perf ||
+                          options.stats != StatsFormat::NONE || options.jobs != 1 || options.ingest ||
+                          options.processes != 1 || options.pipeline ||
+                          options.diagnostics != DiagnosticsFormat::TEXT ||
+                          !options.tracePath.empty())) {
+        std::cerr << "--watch cannot be combined with other options\n";
+        return false;
+    }
+    if (options.processes > 1 && (options.jobs != 1 || options.ingest || options.perf ||
+                                  !options.tracePath.empty())) {
+        // Counters and trace buffers are per thread of one process
+        std::cerr << "--processes cannot be combined with --jobs, --ingest, --perf or --trace\n";
+        return false;
+    }
+    if (options.pipeline && (options.jobs != 1 || options.processes != 1 || options.ingest)) {
+        std::cerr << "--pipeline cannot be combined with --jobs, --processes or --ingest\n";
+        return false;
+    }
+    if (options.perf && options.stats == StatsFormat::NONE) {
+        options.stats = StatsFormat::TEXT;
+    }
+    return !options.files.empty();
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void printBlockList(std::ostream& out, const std::vector<uint32_t>& ids) {
+    out << "[";
+    for (size_t i = 0; i < ids.size(); ++i) {
+        out << (i ? " " : "") << "B" << ids[i];
+    }
+    out << "]";
+}
+
+void printControlFlowGraphs(std::ostream& out, ProgramNode* program) {
+    for (auto decl : program->declarations) {
+        FunctionDeclNode* function = dynamic_cast<FunctionDeclNode*>(decl);
+        if (!function) {
+            continue;
+        }
+
+        ControlFlowGraph cfg = ControlFlowGraph::build(function);
+        out << "cfg " << function->name << ": " << cfg.blocks().size() << " blocks, "
+                  << cfg.edgeCount() << " edges, " << cfg.reversePostorder().size()
+                  << " reachable, all paths return: "
+                  << (cfg.allPathsReturn() ? "yes" : "no") << "\n";
+
+        for (const auto& block : cfg.blocks()) {
+            out << "  B" << block.id;
+            if (block.id == cfg.entry()) out << " (entry)";
+            if (block.id == cfg.exit()) out << " (exit)";
+            if (!cfg.isReachable(block.id)) out << " (unreachable)";
+            out << " items=" << block.items.size();
+            if (block.terminator) out << " branch";
+            out << " succ=";
+            printBlockList(out, block.successors);
+            uint32_t idom = cfg.immediateDominator(block.id);
+            if (idom != ControlFlowGraph::kNone) out << " idom=B" << idom;
+            out << "\n";
+        }
+    }
+}
+
+// `error` is the errno of the failed open or read, or 0 if unknown
+void reportUnreadable(const std::string& path, const FileContext& ctx, int error) {
+    std::string message = "cannot read file";
+    if (error != 0) {
+        message += std::string(": ") + std::strerror(error);
+    }
+    if (ctx.diagnostics) {
+        ctx.diagnostics->push_back(messageDiagnostic(DiagnosticKind::INPUT, message));
+    } else {
+        ctx.err << path << ": " << message << "\n";
+    }
+}
+
+// A syntax error from the quiet parser. Without --diagnostics the message
+// goes into the file's own error buffer, as yyerror would have printed it.
+void reportSyntaxError(const FileContext& ctx, const SyntaxError& error) {
+    if (ctx.diagnostics) {
+        ctx.diagnostics->push_back(syntaxDiagnostic(error));
+    } else {
+        ctx.err << "Parser error at line " << error.line << ", column " << error.column << "\n";
+    }
+}
+
+// Everything after parsing: analysis and whatever else the options ask for,
+// --time and --stats output, then freeing `root`. `stats` holds the earlier
+// phases.
+int analyzeFile(const std::string& path, const DriverOptions& options, const FileContext& ctx,
+                ASTNode* root, RunStats& stats, double parseMs) {
+    bool collectStats = options.stats != StatsFormat::NONE;
+    PhaseClock clock;
+    int status = 0;
+    double analyzeMs = 0, foldMs = 0, compileMs = 0, runMs = 0;
+    SemanticAnalyzer analyzer(root);
+    try {
+        TraceSpan analyzeSpan(ctx.trace, "analyze", ctx.index);
+        auto start = std::chrono::steady_clock::now();
+        if (collectStats) {
+            analyzer.collectStats(&stats);
+        }
+        analyzer.analyze();
+        analyzeMs = elapsedMs(start);
+        analyzeSpan.end();
+
+        if (options.fold) {
+            TraceSpan foldSpan(ctx.trace, "fold", ctx.index);
+            start = std::chrono::steady_clock::now();
+            clock.restart();
+            FoldStats foldStats = ConstantFolder(root).fold();
+            foldMs = elapsedMs(start);
+            if (collectStats) {
+                stats.addPhase("fold", clock);
+            }
+            ctx.err << path << ": folded " << foldStats.foldedExpressions
+                    << " expressions, propagated " << foldStats.propagatedConstants
+                    << " constants, removed " << foldStats.nodesRemoved << " nodes\n";
+        }
+
+        if (options.dump) {
+            DumpWriter out(ctx.out);
+            dumpAST(root, options.dumpFormat, out);
+        }
+
+        if (options.cfg) {
+            printControlFlowGraphs(ctx.out, static_cast<ProgramNode*>(root));
+        }
+
+        if (options.run || options.disassemble) {
+            TraceSpan compileSpan(ctx.trace, "compile", ctx.index);
+            start = std::chrono::steady_clock::now();
+            clock.restart();
+            BytecodeModule module = BytecodeCompiler(root).compile();
+            compileMs = elapsedMs(start);
+            if (collectStats) {
+                stats.addPhase("compile", clock);
+            }
+            compileSpan.end();
+
+            if (options.disassemble) {
+                ctx.out << module.disassemble();
+            }
+            if (options.run) {
+                TraceSpan runSpan(ctx.trace, "run", ctx.index);
+                start = std::chrono::steady_clock::now();
+                clock.restart();
+                VirtualMachine vm(module, ctx.out);
+                vm.run();
+                ctx.out.flush();
+                runMs = elapsedMs(start);
+                if (collectStats) {
+                    stats.addPhase("run", clock);
+                }
+            }
+        }
+    } catch (const SemanticException& e) {
+        if (ctx.diagnostics) {
+            ctx.diagnostics->push_back(semanticDiagnostic(analyzer.lastError()));
+        } else {
+            ctx.err << path << ": " << e.what() << "\n";
+        }
+        status = 2;
+    } catch (const std::runtime_error& e) {
+        if (ctx.diagnostics) {
+            ctx.diagnostics->push_back(messageDiagnostic(DiagnosticKind::RUNTIME, e.what()));
+        } else {
+            ctx.err << path << ": " << e.what() << "\n";
+        }
+        status = 3;
+    }
+
+    if (options.time) {
+        ctx.err << path << ": parse " << parseMs << " ms, analyze " << analyzeMs
+                << " ms, fold " << foldMs << " ms, compile " << compileMs
+                << " ms, run " << runMs << " ms\n";
+    }
+
+    TraceSpan teardownSpan(ctx.trace, "teardown", ctx.index);
+    clock.restart();
+    delete root;
+    teardownSpan.end();
+    if (collectStats) {
+        stats.addPhase("teardown", clock);
+        stats.finishAllocationCount();
+        if (options.stats == StatsFormat::JSON) {
+            stats.printJson(ctx.err, path);
+        } else {
+            stats.print(ctx.err, path);
+        }
+    }
+    return status;
+}
+
+int processFile(const std::string& path, const DriverOptions& options, const FileContext& ctx) {
+    bool collectStats = options.stats != StatsFormat::NONE;
+    bool separateScan = collectStats || ctx.trace;
+    RunStats stats;
+    stats.startAllocationCount();
+    PhaseClock clock;
+
+    std::string source;
+    TraceSpan readSpan(ctx.trace, "read", ctx.index);
+    bool readable;
+    int readError;
+    if (ctx.ingested) {
+        readable = ctx.ingested->ok;
+        readError = ctx.ingested->error;
+        source.swap(ctx.ingested->contents);
+    } else {
+        readable = readSourceFile(path, source);
+        readError = errno;
+    }
+    if (!readable) {
+        reportUnreadable(path, ctx, readError);
+        return 1;
+    }
+    readSpan.end();
+    if (collectStats) {
+        stats.addPhase("read", clock);
+    }
+
+    ASTNode* root;
+    double parseMs;
+    {
+        TraceSpan waitSpan(ctx.trace, "parser wait", ctx.index);
+        std::scoped_lock lock(scannerMutex, parserMutex);
+        waitSpan.end();
+
+        if (separateScan) {
+            // yyparse pulls tokens as it goes, so the scanner is timed with a
+            // separate scan-only pass; "parse" below includes scanning again
+            TraceSpan scanSpan(ctx.trace, "scan", ctx.index);
+            clock.restart();
+            lexSource(source);
+            if (collectStats) {
+                stats.addPhase("scan", clock);
+            }
+        }
+
+        TraceSpan parseSpan(ctx.trace, "parse", ctx.index);
+        auto start = std::chrono::steady_clock::now();
+        clock.restart();
+        ALLOC_SITE(PARSE);
+        if (ctx.diagnostics || ctx.buffered) {
+            SyntaxError syntaxError;
+            root = parseSource(source.data(), source.size(), syntaxError);
+            if (!root) {
+                reportSyntaxError(ctx, syntaxError);
+            }
+        } else {
+            root = parseSource(source);
+        }
+        parseMs = elapsedMs(start);
+    }
+    if (!root) {
+        return 1;
+    }
+    if (collectStats) {
+        stats.addPhase("parse", clock);
+        countNodes(root, stats.nodes);
+    }
+    return analyzeFile(path, options, ctx, root, stats, parseMs);
+}
+
+// Worker loop for --jobs and --ingest: take the next file from the shared
+// queue, process it into private buffers, then write them out (the error
+// text to `report`) under the output lock
+void runWorker(const DriverOptions& options, TraceBuffer* trace, DiagnosticWriter* diagnosticWriter,
+               std::ostream& report, FileQueue& queue, std::mutex& outputMutex, int& status) {
+    if (options.perf) {
+        // main() already reported whether counters work at all
+        std::string error;
+        openThreadPerfCounters(error);
+    }
+    for (;;) {
+        size_t index;
+        IngestedFile file;
+        {
+            TraceSpan waitSpan(trace, "queue wait");
+            if (!queue.pop(index, file)) {
+                return;
+            }
+        }
+
+        std::ostringstream out, err;
+        std::vector<Diagnostic> diagnostics;
+        FileContext ctx{static_cast<uint32_t>(index), out, err, trace,
+                        diagnosticWriter ? &diagnostics : nullptr,
+                        options.ingest ? &file : nullptr, true};
+        int fileStatus = processFile(options.files[index], options, ctx);
+
+        TraceSpan waitSpan(trace, "output wait", static_cast<uint32_t>(index));
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << out.str() << std::flush;
+        report << err.str() << std::flush;
+        if (diagnosticWriter) {
+            diagnosticWriter->file(options.files[index], diagnostics);
+        }
+        if (fileStatus > status) {
+            status = fileStatus;
+        }
+    }
+}
+
+// One file on its way through --pipeline. Each stage fills in its part and
+// frees what the later ones do not need.
+struct PipelineFile {
+    size_t index = 0;
+    bool readable = false;
+    bool scanned = false;
+    std::string source;
+    TokenBuffer tokens;
+    ASTNode* root = nullptr;
+    RunStats stats;
+    double parseMs = 0;        // scanning and parsing, for --time
+    std::ostringstream out, err;
+    std::vector<Diagnostic> diagnostics;
+
+    ~PipelineFile() { delete root; }
+};
+
+// --pipeline: reading, scanning, parsing and analysis run as four stages,
+// each on its own threads, joined by bounded StageQueues. Scanning and
+// parsing still go through the flex and bison globals, but they take
+// separate locks (scanTokens() and parseTokens() share no state), so one
+// file is scanned while the previous one is parsed; more than one thread in
+// either stage only overlaps the queue handoffs. Files come out of the last
+// stage, in the order they finish, under the output lock.
+class FilePipeline {
+ private:
+    using Item = std::unique_ptr<PipelineFile>;
+    using Work = void (FilePipeline::*)(PipelineFile&, TraceBuffer*);
+
+    static constexpr size_t kQueueCapacity = 16;
+
+    const DriverOptions& options;
+    DiagnosticWriter* diagnosticWriter;
+    std::ostream& report;                   // error text and --stats tables
+    bool collectStats;
+    std::atomic<size_t> nextFile;
+    StageQueue<Item> scanQueue, parseQueue, analyzeQueue;
+    std::vector<StageStats> stages;
+    std::mutex statsMutex, outputMutex;
+    int status;
+
+    FileContext context(PipelineFile& file, TraceBuffer* trace) {
+        return FileContext{static_cast<uint32_t>(file.index), file.out, file.err, trace,
+                           diagnosticWriter ? &file.diagnostics : nullptr, nullptr, true};
+    }
+
+    void read(PipelineFile& file, TraceBuffer* trace) {
+        const std::string& path = options.files[file.index];
+        TraceSpan readSpan(trace, "read", static_cast<uint32_t>(file.index));
+        PhaseClock clock;
+        file.readable = readSourceFile(path, file.source);
+        if (!file.readable) {
+            reportUnreadable(path, context(file, trace), errno);
+        } else if (collectStats) {
+            file.stats.addPhase("read", clock);
+        }
+    }
+
+    void scan(PipelineFile& file, TraceBuffer* trace) {
+        if (!file.readable) {
+            return;
+        }
+        uint32_t index = static_cast<uint32_t>(file.index);
+        TraceSpan waitSpan(trace, "scanner wait", index);
+        std::lock_guard<std::mutex> lock(scannerMutex);
+        waitSpan.end();
+
+        TraceSpan scanSpan(trace, "scan", index);
+        auto start = std::chrono::steady_clock::now();
+        PhaseClock clock;
+        ALLOC_SITE(PARSE);
+        try {
+            scanTokens(file.source.data(), file.source.size(), file.tokens);
+            file.scanned = true;
+        } catch (const std::exception& e) {
+            // The scanner rejects some input by throwing
+            if (diagnosticWriter) {
+                file.diagnostics.push_back(messageDiagnostic(DiagnosticKind::SYNTAX, e.what()));
+            } else {
+                file.err << options.files[file.index] << ": " << e.what() << "\n";
+            }
+            file.tokens.clear();
+        }
+        file.parseMs = elapsedMs(start);
+        if (collectStats && file.scanned) {
+            file.stats.addPhase("scan", clock);
+        }
+        std::string().swap(file.source);
+    }
+
+    void parse(PipelineFile& file, TraceBuffer* trace) {
+        if (!file.scanned) {
+            return;
+        }
+        uint32_t index = static_cast<uint32_t>(file.index);
+        SyntaxError syntaxError;
+        PhaseClock clock;
+        {
+            TraceSpan waitSpan(trace, "parser wait", index);
+            std::lock_guard<std::mutex> lock(parserMutex);
+            waitSpan.end();
+
+            TraceSpan parseSpan(trace, "parse", index);
+            auto start = std::chrono::steady_clock::now();
+            clock.restart();
+            ALLOC_SITE(PARSE);
+            file.root = parseTokens(file.tokens, syntaxError);
+            file.parseMs += elapsedMs(start);
+        }
+        file.tokens.clear();
+        if (!file.root) {
+            reportSyntaxError(context(file, trace), syntaxError);
+        } else if (collectStats) {
+            file.stats.addPhase("parse", clock);
+            countNodes(file.root, file.stats.nodes);
+        }
+    }
+
+    void analyze(PipelineFile& file, TraceBuffer* trace) {
+        const std::string& path = options.files[file.index];
+        int fileStatus = 1;
+        if (file.root) {
+            // Allocation totals cover this stage only; the earlier phases
+            // counted theirs on their own threads
+            file.stats.startAllocationCount();
+            ASTNode* root = file.root;
+            file.root = nullptr;
+            fileStatus = analyzeFile(path, options, context(file, trace), root, file.stats,
+                                     file.parseMs);
+        }
+
+        TraceSpan waitSpan(trace, "output wait", static_cast<uint32_t>(file.index));
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << file.out.str() << std::flush;
+        report << file.err.str() << std::flush;
+        if (diagnosticWriter) {
+            diagnosticWriter->file(path, file.diagnostics);
+        }
+        if (fileStatus > status) {
+            status = fileStatus;
+        }
+    }
+
+    // Thread body: take files from `in` (or, for the first stage, the next
+    // index), do this stage's work and pass them on to `out`
+    void runStage(size_t stage, Work work, StageQueue<Item>* in, StageQueue<Item>* out,
+                  TraceBuffer* trace) {
+        if (options.perf) {
+            // main() already reported whether counters work at all
+            std::string error;
+            openThreadPerfCounters(error);
+        }
+        uint64_t items = 0;
+        double busyMs = 0;
+        for (;;) {
+            Item file;
+            if (in) {
+                TraceSpan waitSpan(trace, "queue wait");
+                if (!in->pop(file)) {
+                    break;
+                }
+            } else {
+                size_t index = nextFile++;
+                if (index >= options.files.size()) {
+                    break;
+                }
+                file = std::make_unique<PipelineFile>();
+                file->index = index;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            (this->*work)(*file, trace);
+            busyMs += elapsedMs(start);
+            ++items;
+
+            if (out) {
+                TraceSpan waitSpan(trace, "queue full wait", static_cast<uint32_t>(file->index));
+                out->push(std::move(file));
+            }
+        }
+        if (out) {
+            out->producerDone();
+        }
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stages[stage].items += items;
+        stages[stage].busyMs += busyMs;
+    }
+
+ public:
+    FilePipeline(const DriverOptions& options, DiagnosticWriter* diagnosticWriter,
+                 std::ostream& report)
+        : options(options), diagnosticWriter(diagnosticWriter), report(report),
+          collectStats(options.stats != StatsFormat::NONE), nextFile(0),
+          scanQueue("read>scan", kQueueCapacity, options.pipelineThreads[0]),
+          parseQueue("scan>parse", kQueueCapacity, options.pipelineThreads[1]),
+          analyzeQueue("parse>analyze", kQueueCapacity, options.pipelineThreads[2]),
+          stages(4), status(0) {
+        const char* names[] = {"read", "scan", "parse", "analyze"};
+        for (size_t s = 0; s < stages.size(); ++s) {
+            stages[s].name = names[s];
+            stages[s].threads = options.pipelineThreads[s];
+        }
+    }
+
+    // Process every file and return the worst status. `tracer` has a buffer
+    // per thread of every stage, in stage order.
+    int run(Tracer* tracer) {
+        const Work work[] = {&FilePipeline::read, &FilePipeline::scan, &FilePipeline::parse,
+                             &FilePipeline::analyze};
+        StageQueue<Item>* queues[] = {nullptr, &scanQueue, &parseQueue, &analyzeQueue, nullptr};
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t s = 0; s < stages.size(); ++s) {
+            for (unsigned t = 0; t < stages[s].threads; ++t) {
+                TraceBuffer* trace = tracer ? tracer->buffer(threads.size()) : nullptr;
+                threads.emplace_back(&FilePipeline::runStage, this, s, work[s], queues[s],
+                                     queues[s + 1], trace);
+            }
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        double wallMs = elapsedMs(start);
+
+        if (collectStats) {
+            std::vector<QueueStats> queueStats = {scanQueue.stats(), parseQueue.stats(),
+                                                  analyzeQueue.stats()};
+            if (options.stats == StatsFormat::JSON) {
+                printPipelineStatsJson(report, wallMs, stages, queueStats);
+            } else {
+                printPipelineStats(report, wallMs, stages, queueStats);
+            }
+        }
+        return status;
+    }
+};
+
+// --watch: check everything once, then re-check changed files as inotify
+// reports them. Only returns on an error.
+int runWatch(const DriverOptions& options) {
+    // A save is usually one IN_CLOSE_WRITE, but editors that write a temp
+    // file and rename it produce a few events in quick succession
+    const int kSettleMs = 5;
+
+    WatchSession session;
+    FileWatcher watcher;
+    std::string error;
+    if (!watcher.open(error)) {
+        std::cerr << "--watch: " << error << "\n";
+        return 1;
+    }
+    for (const std::string& path : options.files) {
+        if (!session.add(path, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+    for (const std::string& directory : session.watchDirectories()) {
+        if (!watcher.watchDirectory(directory, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t checked = session.checkAll();
+    session.printSummary(std::cout, checked, elapsedMs(start));
+
+    std::vector<std::string> changed;
+    bool overflow;
+    while (watcher.wait(kSettleMs, changed, overflow)) {
+        start = std::chrono::steady_clock::now();
+        if (overflow) {
+            checked = session.checkAll();
+        } else {
+            checked = 0;
+            for (const std::string& path : changed) {
+                checked += session.update(path);
+            }
+        }
+        if (checked) {
+            session.printSummary(std::cout, checked, elapsedMs(start));
+        }
+    }
+    std::cerr << "--watch: reading inotify events failed: " << std::strerror(errno) << "\n";
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    DriverOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (options.watch) {
+        return runWatch(options);
+    }
+
+    unsigned threads = options.jobs;
+    if (threads > options.files.size()) {
+        threads = static_cast<unsigned>(options.files.size());
+    }
+
+    // A JSON Lines or SARIF stream on stderr must not be interleaved with
+    // text, so the reports and notes that would go there use stdout instead
+    bool structuredOnStderr =
+        options.diagnostics != DiagnosticsFormat::TEXT && options.diagnosticsPath.empty();
+    std::ostream& report = structuredOnStderr ? std::cout : std::cerr;
+
+    if (options.perf) {
+        // Counters are per thread; opening them here also checks they work
+        // before any worker starts
+        std::string error;
+        uint32_t events = openThreadPerfCounters(error);
+        if (!events) {
+            report << "--perf: hardware counters unavailable: " << error << "\n";
+            options.perf = false;
+        } else if (events != (uint32_t(1) << kPerfEventCount) - 1) {
+            report << "--perf: not available:";
+            for (size_t i = 0; i < kPerfEventCount; ++i) {
+                if (!(events & perfEventBit(static_cast<PerfEvent>(i)))) {
+                    report << " " << perfEventName(static_cast<PerfEvent>(i));
+                }
+            }
+            report << "\n";
+        }
+    }
+
+    if (options.pipeline) {
+        const unsigned* stageThreads = options.pipelineThreads;
+        threads = stageThreads[0] + stageThreads[1] + stageThreads[2] + stageThreads[3];
+    }
+
+    std::unique_ptr<Tracer> tracer;
+    if (!options.tracePath.empty()) {
+        tracer = std::make_unique<Tracer>(threads);
+    }
+
+    std::ofstream diagnosticsFile;
+    std::unique_ptr<DiagnosticWriter> diagnosticWriter;
+    if (options.diagnostics != DiagnosticsFormat::TEXT) {
+        std::ostream* diagnosticsOut = &std::cerr;
+        if (!options.diagnosticsPath.empty()) {
+            diagnosticsFile.open(options.diagnosticsPath);
+            if (!diagnosticsFile) {
+                std::cerr << options.diagnosticsPath << ": cannot write diagnostics\n";
+                return 1;
+            }
+            diagnosticsOut = &diagnosticsFile;
+        }
+        diagnosticWriter = std::make_unique<DiagnosticWriter>(*diagnosticsOut, options.diagnostics);
+        diagnosticWriter->begin();
+    }
+
+    std::unique_ptr<FileIngestor> ingestor;
+    if (options.ingest) {
+        ingestor = std::make_unique<FileIngestor>(options.ingestBackend);
+        if (!ingestor->fallbackReason().empty()) {
+            report << "--ingest: reading with pread: " << ingestor->fallbackReason() << "\n";
+        }
+    }
+
+    int status = 0;
+    if (options.processes > 1) {
+        bool structured = diagnosticWriter != nullptr;
+        ShardCoordinator coordinator(options.files.size(), options.processes);
+        bool completed = coordinator.run(
+            [&options, structured](ShardResult& result) {
+                std::ostringstream out, err;
+                FileContext ctx{result.index, out, err, nullptr,
+                                structured ? &result.diagnostics : nullptr, nullptr, true};
+                result.status = processFile(options.files[result.index], options, ctx);
+                result.out = out.str();
+                result.err = err.str();
+            },
+            [&](ShardResult& result) {
+                const std::string& path = options.files[result.index];
+                int fileStatus = result.status;
+                if (!result.crash.empty()) {
+                    fileStatus = 4;
+                    if (diagnosticWriter) {
+                        result.diagnostics.push_back(
+                            messageDiagnostic(DiagnosticKind::RUNTIME, result.crash));
+                    } else {
+                        result.err += path + ": " + result.crash + "\n";
+                    }
+                }
+                std::cout << result.out << std::flush;
+                report << result.err << std::flush;
+                if (diagnosticWriter) {
+                    diagnosticWriter->file(path, result.diagnostics);
+                }
+                if (fileStatus > status) {
+                    status = fileStatus;
+                }
+            });
+        if (coordinator.crashes()) {
+            report << "--processes: " << coordinator.crashes()
+                   << " worker crash(es), their files were reassigned\n";
+        }
+        if (!completed) {
+            // The files left were emitted as crashed; say why the run stopped
+            report << "--processes: lost the worker processes, the remaining files were not "
+                      "analyzed\n";
+            if (status < 4) {
+                status = 4;
+            }
+        }
+    } else if (options.pipeline) {
+        status = FilePipeline(options, diagnosticWriter.get(), report).run(tracer.get());
+    } else if (threads == 1 && !ingestor) {
+        TraceBuffer* trace = tracer ? tracer->buffer(0) : nullptr;
+        std::vector<Diagnostic> diagnostics;
+        for (size_t i = 0; i < options.files.size(); ++i) {
+            diagnostics.clear();
+            FileContext ctx{static_cast<uint32_t>(i), std::cout, report, trace,
+                            diagnosticWriter ? &diagnostics : nullptr, nullptr, false};
+            int fileStatus = processFile(options.files[i], options, ctx);
+            if (diagnosticWriter) {
+                diagnosticWriter->file(options.files[i], diagnostics);
+            }
+            if (fileStatus > status) {
+                status = fileStatus;
+            }
+        }
+    } else {
+        FileQueue queue(options.files.size(), options.ingest, 2 * FileIngestor::kDefaultDepth);
+        std::mutex outputMutex;
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            TraceBuffer* trace = tracer ? tracer->buffer(t) : nullptr;
+            workers.emplace_back(runWorker, std::cref(options), trace, diagnosticWriter.get(),
+                                 std::ref(report), std::ref(queue), std::ref(outputMutex),
+                                 std::ref(status));
+        }
+        if (ingestor) {
+            ingestor->readAll(options.files, [&queue](IngestedFile& file) { queue.push(file); });
+            queue.finish();
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    if (diagnosticWriter) {
+        diagnosticWriter->end();
+    }
+
+    if (tracer && !tracer->write(options.tracePath, options.files)) {
+        report << options.tracePath << ": cannot write trace\n";
+        if (status == 0) {
+            status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,197 @@
+#include "frontend.hpp"
+#include "parser.tab.hpp"
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+
+// Flex buffer API (defined in lex.yy.c)
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_bytes(const char* bytes, int len);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
+extern int yylineno;
+extern int yylex();
+
+// Syntax error reporting in parser.y
+extern int syntax_error_line;
+extern int syntax_error_column;
+extern bool report_syntax_errors;
+
+// Token replay in parser.y
+extern bool replay_tokens;
+extern const ScannedToken* replay_next;
+extern const ScannedToken* replay_end;
+
+std::mutex scannerMutex;
+std::mutex parserMutex;
+
+bool readSourceFile(const std::string& path, std::string& out) {
+    errno = 0;
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    out = contents.str();
+    return true;
+}
+
+size_t lexSource(const std::string& source) {
+    YY_BUFFER_STATE buffer = yy_scan_bytes(source.data(), static_cast<int>(source.size()));
+    yylineno = 1;
+
+    // The parser consumes END_OF_FILE and then the scanner's 0, so drain to
+    // the same point to leave the scanner ready for the next buffer
+    size_t tokens = 0;
+    int token;
+    while ((token = yylex()) != 0) {
+        if (token == IDENTIFIER) {
+            delete yylval.text;
+        }
+        ++tokens;
+    }
+    yy_delete_buffer(buffer);
+    return tokens;
+}
+
+ASTNode* parseSource(const std::string& source) {
+    YY_BUFFER_STATE buffer = yy_scan_bytes(source.data(), static_cast<int>(source.size()));
+    yylineno = 1;
+
+    ASTNode* root = nullptr;
+    int status = yyparse(&root);
+    yy_delete_buffer(buffer);
+
+    if (status != 0) {
+        delete root;
+        return nullptr;
+    }
+    return root;
+}
+
+namespace {
+
+// Releases the scanner buffer and turns stderr reporting back on, also when
+// the scanner throws
+struct QuietParse {
+    YY_BUFFER_STATE buffer;
+
+    QuietParse(const char* data, size_t size)
+        : buffer(yy_scan_bytes(data, static_cast<int>(size))) {
+        report_syntax_errors = false;
+    }
+
+    ~QuietParse() {
+        yy_delete_buffer(buffer);
+        report_syntax_errors = true;
+    }
+};
+
+} // namespace
+
+ASTNode* parseSource(const char* data, size_t size, SyntaxError& error) {
+    QuietParse parse(data, size);
+    yylineno = 1;
+    syntax_error_line = 0;
+    syntax_error_column = 0;
+
+    ASTNode* root = nullptr;
+    int status = yyparse(&root);
+
+    error.line = syntax_error_line;
+    error.column = syntax_error_column;
+    if (status != 0) {
+        delete root;
+        return nullptr;
+    }
+    return root;
+}
+
+TokenBuffer::TokenBuffer() : consumed(0) {}
+
+TokenBuffer::~TokenBuffer() {
+    clear();
+}
+
+size_t TokenBuffer::size() const {
+    return tokens.size();
+}
+
+void TokenBuffer::clear() {
+    // The parser deletes the strings of the identifiers it reduced
+    for (size_t i = consumed; i < tokens.size(); ++i) {
+        if (tokens[i].kind == IDENTIFIER) {
+            delete tokens[i].value.text;
+        }
+    }
+    tokens.clear();
+    consumed = 0;
+}
+
+namespace {
+
+// Releases the scanner buffer, also when the scanner throws
+struct ScanBuffer {
+    YY_BUFFER_STATE buffer;
+
+    ScanBuffer(const char* data, size_t size)
+        : buffer(yy_scan_bytes(data, static_cast<int>(size))) {}
+
+    ~ScanBuffer() { yy_delete_buffer(buffer); }
+};
+
+// Points yyparse at a TokenBuffer instead of the scanner for one parse
+struct ReplayParse {
+    const ScannedToken* begin;
+
+    ReplayParse(const ScannedToken* begin, const ScannedToken* end) : begin(begin) {
+        replay_tokens = true;
+        replay_next = begin;
+        replay_end = end;
+        report_syntax_errors = false;
+    }
+
+    // Everything handed to the parser is its to free; a lookahead it
+    // discarded on an error leaks, as it does when parsing from flex
+    size_t handedOut() const { return static_cast<size_t>(replay_next - begin); }
+
+    ~ReplayParse() {
+        replay_tokens = false;
+        replay_next = replay_end = nullptr;
+        report_syntax_errors = true;
+    }
+};
+
+} // namespace
+
+size_t scanTokens(const char* data, size_t size, TokenBuffer& buffer) {
+    buffer.clear();
+    ScanBuffer scan(data, size);
+    yylineno = 1;
+
+    // Up to and including the 0 after END_OF_FILE, like yyparse reads
+    int token;
+    do {
+        token = yylex();
+        buffer.tokens.push_back(ScannedToken{token, yylval, yylloc});
+    } while (token != 0);
+    return buffer.tokens.size();
+}
+
+ASTNode* parseTokens(TokenBuffer& buffer, SyntaxError& error) {
+    ReplayParse replay(buffer.tokens.data(), buffer.tokens.data() + buffer.tokens.size());
+    syntax_error_line = 0;
+    syntax_error_column = 0;
+
+    ASTNode* root = nullptr;
+    int status = yyparse(&root);
+    buffer.consumed = replay.handedOut();
+
+    error.line = syntax_error_line;
+    error.column = syntax_error_column;
+    if (status != 0) {
+        delete root;
+        return nullptr;
+    }
+    return root;
+}
@@ -0,0 +1,81 @@
+#ifndef FRONTEND_HPP
+#define FRONTEND_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "astnode.hpp"
+
+// Thin wrappers around the flex/bison entry points so tools other than the
+// main executable can turn source text into an AST.
+//
+// The generated scanner and parser keep their state in globals. Any thread
+// that may run alongside another parse holds the lock for each set of
+// globals a function uses: scannerMutex for lexSource() and scanTokens(),
+// parserMutex for parseTokens(), and both for parseSource(). AnalysisContext
+// and semanticdriver take these same locks.
+
+// Guards the flex globals
+extern std::mutex scannerMutex;
+
+// Guards the bison globals
+extern std::mutex parserMutex;
+
+// Read a whole file into `out`. Returns false if the file cannot be opened,
+// with errno saying why (or 0 if the stream did not record it).
+bool readSourceFile(const std::string& path, std::string& out);
+
+// Run only the scanner over a source buffer and return the number of tokens,
+// so tools can time lexing separately from parsing.
+size_t lexSource(const std::string& source);
+
+// Parse a source buffer. Returns the ProgramNode, or nullptr after a syntax
+// error (which yyerror has already reported).
+ASTNode* parseSource(const std::string& source);
+
+// Where parsing stopped; line 0 means there was no syntax error
+struct SyntaxError {
+    int line = 0;
+    int column = 0;
+};
+
+// Parse `size` bytes at `data`. A syntax error is stored in `error` instead
+// of being reported on stderr.
+ASTNode* parseSource(const char* data, size_t size, SyntaxError& error);
+
+// Defined with the token types in parser.tab.hpp
+struct ScannedToken;
+
+// The tokens of one source buffer, scanned ahead of parsing so that the
+// scanner can move on to the next file while this one is parsed
+// (semanticdriver --pipeline). Owns the identifier strings of the tokens the
+// parser has not taken.
+class TokenBuffer {
+ private:
+    std::vector<ScannedToken> tokens;
+    size_t consumed;
+
+    friend size_t scanTokens(const char* data, size_t size, TokenBuffer& tokens);
+    friend ASTNode* parseTokens(TokenBuffer& tokens, SyntaxError& error);
+
+ public:
+    TokenBuffer();
+    ~TokenBuffer();
+
+    TokenBuffer(const TokenBuffer&) = delete;
+    TokenBuffer& operator=(const TokenBuffer&) = delete;
+
+    size_t size() const;
+    void clear();
+};
+
+// Scan `size` bytes at `data` into `tokens`, replacing what it held, and
+// return the number of tokens. Uses the flex globals only.
+size_t scanTokens(const char* data, size_t size, TokenBuffer& tokens);
+
+// Parse tokens from scanTokens(); a syntax error is stored in `error`. Uses
+// the bison globals only, so it may run while another thread scans.
+ASTNode* parseTokens(TokenBuffer& tokens, SyntaxError& error);
+
+#endif // FRONTEND_HPP
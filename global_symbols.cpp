@@ -0,0 +1,147 @@
+#include "global_symbols.hpp"
+#include <algorithm>
+#include <cstring>
+
+// splitmix64's finalizer over the name's hash and the bucket's displacement
+size_t GlobalSymbolTable::slotHash(size_t hash, uint32_t displacement) {
+    uint64_t x = static_cast<uint64_t>(hash) + (uint64_t(displacement) + 1) * 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<size_t>(x ^ (x >> 31));
+}
+
+// The name hash index() falls back to when std::hash collides: splitmix64
+// over each 8-byte word of the name, starting from the seed and length
+size_t GlobalSymbolTable::seededHash(const std::string& name, uint64_t seed) {
+    uint64_t hash = seed * 0x9e3779b97f4a7c15ULL ^ name.size();
+    for (size_t i = 0; i < name.size(); i += 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, name.data() + i, std::min<size_t>(8, name.size() - i));
+        hash = slotHash(hash ^ word, 0);
+    }
+    return static_cast<size_t>(hash);
+}
+
+std::shared_ptr<const GlobalSymbolTable> GlobalSymbolTable::build(const Scope& globals,
+                                                                  const SignaturePool& signatures) {
+    std::shared_ptr<GlobalSymbolTable> table(new GlobalSymbolTable());
+    table->signaturePool = signatures;
+    globals.forEachSymbol([&table](const SymbolInfo& symbol) {
+        if (symbol.kind == SymbolKind::FUNCTION) {
+            table->symbols.push_back(symbol);
+        }
+    });
+    table->index();
+    return table;
+}
+
+// Place the largest buckets first, while most slots are free. A bucket that
+// finds no displacement within kMaxAttempts restarts the whole build with
+// twice the slots, which is rare at 80% load.
+//
+// That only converges if no two names hash alike: equal hashes share a
+// bucket and land in the same slot for every displacement, so no table is
+// large enough. Such names are found up front and the hash is re-seeded
+// until all of them differ. Each seed is an independent hash function, so
+// a second seed is needed about as often as a 64-bit collision.
+void GlobalSymbolTable::index() {
+    const uint32_t kMaxAttempts = 1u << 16;
+    size_t n = symbols.size();
+    if (n == 0) {
+        return;
+    }
+    std::vector<size_t> hashes(n);
+    std::vector<size_t> sorted;
+    for (seed = 0;; ++seed) {
+        for (size_t i = 0; i < n; ++i) {
+            hashes[i] = hashName(symbols[i].name);
+        }
+        sorted = hashes;
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end()) {
+            break;
+        }
+    }
+
+    size_t slotCount = 1;
+    while (slotCount < n + n / 4) {
+        slotCount *= 2;
+    }
+    displacements.assign((n + 1) / 2, 0);
+    std::vector<std::vector<uint32_t>> buckets(displacements.size());
+    for (size_t i = 0; i < n; ++i) {
+        buckets[bucketOf(hashes[i])].push_back(static_cast<uint32_t>(i));
+    }
+    std::vector<uint32_t> order(buckets.size());
+    for (size_t b = 0; b < order.size(); ++b) {
+        order[b] = static_cast<uint32_t>(b);
+    }
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    for (;;) {
+        slotMask = slotCount - 1;
+        slots.assign(slotCount, kEmpty);
+        bool placedAll = true;
+        std::vector<size_t> taken;
+        for (uint32_t b : order) {
+            const std::vector<uint32_t>& bucket = buckets[b];
+            if (bucket.empty()) {
+                break;
+            }
+            uint32_t displacement = 0;
+            for (; displacement < kMaxAttempts; ++displacement) {
+                taken.clear();
+                for (uint32_t symbol : bucket) {
+                    size_t slot = slotHash(hashes[symbol], displacement) & slotMask;
+                    if (slots[slot] != kEmpty ||
+                        std::find(taken.begin(), taken.end(), slot) != taken.end()) {
+                        break;
+                    }
+                    taken.push_back(slot);
+                }
+                if (taken.size() == bucket.size()) {
+                    break;
+                }
+            }
+            if (displacement == kMaxAttempts) {
+                placedAll = false;
+                break;
+            }
+            displacements[b] = displacement;
+            for (size_t k = 0; k < bucket.size(); ++k) {
+                slots[taken[k]] = bucket[k];
+            }
+        }
+        if (placedAll) {
+            return;
+        }
+        slotCount *= 2;
+    }
+}
+
+bool GlobalSymbolTable::matches(const ProgramNode* program) const {
+    size_t next = 0;
+    for (auto decl : program->declarations) {
+        const FunctionDeclNode* function = dynamic_cast<const FunctionDeclNode*>(decl);
+        if (!function) {
+            continue;
+        }
+        if (next == symbols.size()) {
+            return false;
+        }
+        const SymbolInfo& symbol = symbols[next++];
+        FunctionSignature signature = signaturePool.get(symbol.signature);
+        if (symbol.name != function->name || signature.returnType != function->returnType ||
+            signature.paramCount != function->parameters.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < signature.paramCount; ++i) {
+            if (signature.paramTypes[i] != function->parameters[i].type) {
+                return false;
+            }
+        }
+    }
+    return next == symbols.size();
+}
@@ -0,0 +1,82 @@
+#ifndef GLOBAL_SYMBOLS_HPP
+#define GLOBAL_SYMBOLS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "astnode.hpp"
+#include "signature_pool.hpp"
+
+// A program's function signatures, frozen once analyzeProgram's first pass
+// has declared them. The table never changes after build(), so any number of
+// threads can look names up in it without locking, and a caller can keep it
+// across runs: matches() says whether a program still declares exactly these
+// functions, in which case the analyzer skips the first pass and uses the
+// table as is (see SemanticAnalyzer::shareGlobals).
+//
+// Lookups go through a perfect hash built with hash-and-displace: names hash
+// into buckets of about two, and each bucket stores the displacement that
+// sends all of its names to distinct free slots. find() therefore reads one
+// displacement, one slot and compares one name.
+
+class GlobalSymbolTable {
+ private:
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    std::vector<SymbolInfo> symbols;        // declaration order
+    SignaturePool signaturePool;            // what symbols[i].signature refers to
+    std::vector<uint32_t> displacements;    // per bucket
+    std::vector<uint32_t> slots;            // index into symbols, or kEmpty
+    size_t slotMask;
+    uint64_t seed;                          // 0 = std::hash; see index()
+
+    size_t hashName(const std::string& name) const {
+        return seed == 0 ? std::hash<std::string>()(name) : seededHash(name, seed);
+    }
+    static size_t seededHash(const std::string& name, uint64_t seed);
+    static size_t slotHash(size_t hash, uint32_t displacement);
+    size_t bucketOf(size_t hash) const { return hash % displacements.size(); }
+
+    GlobalSymbolTable() : slotMask(0), seed(0) {}
+    void index();
+
+ public:
+    // Freeze the FUNCTION symbols of `globals`, which must be unique, as
+    // they are after a successful first pass, and the pool their
+    // signatures are in
+    static std::shared_ptr<const GlobalSymbolTable> build(const Scope& globals,
+                                                          const SignaturePool& signatures);
+
+    // The function called `name`, or nullptr
+    const SymbolInfo* find(const std::string& name) const {
+        if (symbols.empty()) {
+            return nullptr;
+        }
+        size_t hash = hashName(name);
+        uint32_t slot = slots[slotHash(hash, displacements[bucketOf(hash)]) & slotMask];
+        if (slot == kEmpty || symbols[slot].name != name) {
+            return nullptr;
+        }
+        return &symbols[slot];
+    }
+
+    // Whether `program` declares these functions, with the same signatures,
+    // in the same order; allocates nothing
+    bool matches(const ProgramNode* program) const;
+
+    size_t size() const { return symbols.size(); }
+
+    const SignaturePool& signatures() const { return signaturePool; }
+
+    // Call visit(const SymbolInfo&) for each function in declaration order
+    template <typename Visit>
+    void forEachSymbol(Visit visit) const {
+        for (const SymbolInfo& symbol : symbols) {
+            visit(symbol);
+        }
+    }
+};
+
+#endif // GLOBAL_SYMBOLS_HPP
@@ -0,0 +1,462 @@
+#include "ingest.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define INGEST_IO_URING 1
+#endif
+#endif
+
+const char* ingestBackendName(IngestBackend backend) {
+    return backend == IngestBackend::IO_URING ? "uring" : "pread";
+}
+
+bool parseIngestBackend(const char* name, IngestBackend& backend) {
+    if (std::strcmp(name, "uring") == 0) {
+        backend = IngestBackend::IO_URING;
+    } else if (std::strcmp(name, "pread") == 0) {
+        backend = IngestBackend::PREAD;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+// Files that report size 0 (procfs and the like) are read in chunks of this
+constexpr size_t kMinReadSize = 4096;
+
+} // namespace
+
+#ifdef INGEST_IO_URING
+
+// The mapped submission and completion rings of one io_uring instance
+struct FileIngestor::Ring {
+    int fd = -1;
+
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned unsubmitted = 0;
+    unsigned inFlight = 0;      // taken by the kernel, not yet reaped
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (fd >= 0) close(fd);
+    }
+
+    bool setup(unsigned entries, std::string& error);
+    bool supports(std::string& error) const;
+
+    // The next free submission entry, zeroed; queued by the next enter().
+    // Never null: each file has at most one operation outstanding and the
+    // ring has an entry per file in flight.
+    io_uring_sqe* nextEntry() {
+        unsigned tail = *sqTail;
+        unsigned index = tail & sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        ++unsubmitted;
+        return sqe;
+    }
+
+    // Make the entry from nextEntry() visible to the kernel
+    void publish() {
+        __atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+    }
+
+    // Submit everything queued and wait for at least one completion
+    bool enter() {
+        for (;;) {
+            long submitted = syscall(__NR_io_uring_enter, fd, unsubmitted, 1,
+                                     IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted >= 0) {
+                unsubmitted -= static_cast<unsigned>(submitted);
+                inFlight += static_cast<unsigned>(submitted);
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    template <typename Handle>
+    void reap(Handle handle) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes[head & cqMask];
+            handle(cqe.user_data, cqe.res);
+            ++head;
+            --inFlight;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    // Wait, without submitting anything more, until every operation the
+    // kernel has taken has completed; false if waiting fails
+    template <typename Handle>
+    bool drain(Handle handle) {
+        for (;;) {
+            reap(handle);
+            if (inFlight == 0) {
+                return true;
+            }
+            if (syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                errno != EINTR) {
+                return false;
+            }
+        }
+    }
+};
+
+bool FileIngestor::Ring::setup(unsigned entries, std::string& error) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) {
+        error = std::string("io_uring_setup: ") + std::strerror(errno);
+        return false;
+    }
+
+    sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+    }
+    sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                 IORING_OFF_SQ_RING);
+    if (sqMap == MAP_FAILED) {
+        error = std::string("mmap: ") + std::strerror(errno);
+        return false;
+    }
+    cqMap = singleMap ? sqMap
+                      : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             fd, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (cqMap == MAP_FAILED || sqes == MAP_FAILED) {
+        error = std::string("mmap: ") + std::strerror(errno);
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sqMap);
+    sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cqMap);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+// OPENAT and CLOSE arrived in Linux 5.6; older kernels accept the ring but
+// fail those requests, so ask before relying on them
+bool FileIngestor::Ring::supports(std::string& error) const {
+    const unsigned kOps = 256;
+    std::vector<char> memory(sizeof(io_uring_probe) + kOps * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(memory.data());
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, kOps) < 0) {
+        error = std::string("io_uring probe: ") + std::strerror(errno);
+        return false;
+    }
+    for (unsigned op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            error = "io_uring lacks openat/read/close";
+            return false;
+        }
+    }
+    return true;
+}
+
+// One file in flight: its single outstanding operation is identified by the
+// slot number in the completion's user_data
+struct FileIngestor::Slot {
+    enum Stage { FREE, OPEN, READ, CLOSE };
+
+    Stage stage = FREE;
+    int fd = -1;            // open until its CLOSE completes
+    size_t expected = 0;    // st_size when the file was opened
+    size_t filled = 0;
+    IngestedFile file;
+};
+
+// The ring broke (io_uring_enter failed). Reads the kernel already took may
+// still be writing into the slots' buffers, so wait for them before touching
+// any slot, then tear the ring down. Descriptors whose CLOSE never reached
+// the kernel are closed here. The files in flight and the ones not started
+// yet are read with pread instead.
+void FileIngestor::readRestWithPread(const std::vector<std::string>& paths, size_t nextPath,
+                                     std::vector<Slot>& slots,
+                                     const std::function<void(IngestedFile&)>& deliver) {
+    fallback = std::string("io_uring_enter: ") + std::strerror(errno);
+    bool drained = ring->drain([&slots](uint64_t id, int result) {
+        Slot& slot = slots[id];
+        if (slot.stage == Slot::OPEN && result >= 0) {
+            slot.fd = result;   // opened after all; closed below
+        } else if (slot.stage == Slot::CLOSE) {
+            slot.fd = -1;
+        }
+    });
+    ring.reset();
+
+    std::vector<size_t> indices;
+    for (Slot& slot : slots) {
+        if (slot.stage == Slot::OPEN || slot.stage == Slot::READ) {
+            indices.push_back(slot.file.index);
+        }
+        if (drained && slot.fd >= 0) {
+            close(slot.fd);
+            slot.fd = -1;
+        }
+    }
+    if (!drained) {
+        // Nothing says when the kernel is done with the buffers and
+        // descriptors of reads still in flight, so they are never released
+        new std::vector<Slot>(std::move(slots));
+    }
+    for (size_t i = nextPath; i < paths.size(); ++i) {
+        indices.push_back(i);
+    }
+    std::vector<std::string> rest;
+    rest.reserve(indices.size());
+    for (size_t index : indices) {
+        rest.push_back(paths[index]);
+    }
+    readWithPread(rest, [&](IngestedFile& file) {
+        file.index = indices[file.index];
+        deliver(file);
+    });
+}
+
+void FileIngestor::readWithRing(const std::vector<std::string>& paths,
+                                const std::function<void(IngestedFile&)>& deliver) {
+    std::vector<Slot> slots(std::min(depth, paths.size()));
+    size_t nextPath = 0;
+    size_t active = 0;
+
+    auto submitRead = [this](Slot& slot, uint64_t id) {
+        io_uring_sqe* sqe = ring->nextEntry();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = slot.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&slot.file.contents[slot.filled]);
+        sqe->len = static_cast<uint32_t>(slot.file.contents.size() - slot.filled);
+        sqe->off = slot.filled;
+        sqe->user_data = id;
+        ring->publish();
+        slot.stage = Slot::READ;
+    };
+    auto submitClose = [this](Slot& slot, uint64_t id) {
+        io_uring_sqe* sqe = ring->nextEntry();
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = slot.fd;
+        sqe->user_data = id;
+        ring->publish();
+        slot.stage = Slot::CLOSE;
+    };
+    // The file is complete (or failed after opening): hand it over and
+    // close the descriptor; the slot is free once the close completes
+    auto finish = [&](Slot& slot, uint64_t id, int error) {
+        slot.file.ok = error == 0;
+        slot.file.error = error;
+        slot.file.contents.resize(error == 0 ? slot.filled : 0);
+        deliver(slot.file);
+        submitClose(slot, id);
+    };
+
+    while (nextPath < paths.size() || active > 0) {
+        for (size_t id = 0; id < slots.size() && nextPath < paths.size(); ++id) {
+            Slot& slot = slots[id];
+            if (slot.stage != Slot::FREE) {
+                continue;
+            }
+            slot.file = IngestedFile();
+            slot.file.index = nextPath;
+            slot.filled = 0;
+            io_uring_sqe* sqe = ring->nextEntry();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uint64_t>(paths[nextPath].c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = id;
+            ring->publish();
+            slot.stage = Slot::OPEN;
+            ++nextPath;
+            ++active;
+        }
+
+        if (!ring->enter()) {
+            readRestWithPread(paths, nextPath, slots, deliver);
+            return;
+        }
+
+        ring->reap([&](uint64_t id, int result) {
+            Slot& slot = slots[id];
+            switch (slot.stage) {
+                case Slot::OPEN: {
+                    if (result < 0) {
+                        slot.file.ok = false;
+                        slot.file.error = -result;
+                        deliver(slot.file);
+                        slot.stage = Slot::FREE;
+                        --active;
+                        return;
+                    }
+                    slot.fd = result;
+                    struct stat info;
+                    if (fstat(slot.fd, &info) != 0) {
+                        finish(slot, id, errno);
+                        return;
+                    }
+                    // One byte of slack, so a file that has not grown is
+                    // complete after a single short read
+                    slot.expected = static_cast<size_t>(info.st_size);
+                    slot.file.contents.resize(std::max(slot.expected + 1, kMinReadSize));
+                    submitRead(slot, id);
+                    return;
+                }
+                case Slot::READ: {
+                    if (result == -EINTR || result == -EAGAIN) {
+                        submitRead(slot, id);
+                        return;
+                    }
+                    if (result < 0) {
+                        finish(slot, id, -result);
+                        return;
+                    }
+                    slot.filled += static_cast<size_t>(result);
+                    if (result == 0 || (slot.filled >= slot.expected && slot.expected > 0 &&
+                                        slot.filled < slot.file.contents.size())) {
+                        finish(slot, id, 0);
+                        return;
+                    }
+                    if (slot.filled == slot.file.contents.size()) {
+                        slot.file.contents.resize(slot.file.contents.size() * 2);
+                    }
+                    submitRead(slot, id);
+                    return;
+                }
+                case Slot::CLOSE:
+                    slot.stage = Slot::FREE;
+                    slot.fd = -1;
+                    --active;
+                    return;
+                case Slot::FREE:
+                    return;
+            }
+        });
+    }
+}
+
+#else
+
+struct FileIngestor::Ring {};
+
+void FileIngestor::readWithRing(const std::vector<std::string>& paths,
+                                const std::function<void(IngestedFile&)>& deliver) {
+    readWithPread(paths, deliver);
+}
+
+#endif // INGEST_IO_URING
+
+FileIngestor::FileIngestor(IngestBackend requested, size_t depth) : depth(depth ? depth : 1) {
+    if (requested != IngestBackend::IO_URING) {
+        return;
+    }
+#ifdef INGEST_IO_URING
+    std::unique_ptr<Ring> candidate(new Ring());
+    if (candidate->setup(static_cast<unsigned>(this->depth), fallback) &&
+        candidate->supports(fallback)) {
+        ring = std::move(candidate);
+    }
+#else
+    fallback = "io_uring is only available on Linux";
+#endif
+}
+
+FileIngestor::~FileIngestor() = default;
+
+void FileIngestor::readAll(const std::vector<std::string>& paths,
+                           const std::function<void(IngestedFile&)>& deliver) {
+    if (ring) {
+        readWithRing(paths, deliver);
+    } else {
+        readWithPread(paths, deliver);
+    }
+}
+
+void FileIngestor::readWithPread(const std::vector<std::string>& paths,
+                                 const std::function<void(IngestedFile&)>& deliver) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+        IngestedFile file;
+        file.index = i;
+        int fd = open(paths[i].c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            file.error = errno;
+            deliver(file);
+            continue;
+        }
+        struct stat info;
+        size_t filled = 0;
+        if (fstat(fd, &info) != 0) {
+            file.error = errno;
+        } else {
+            size_t expected = static_cast<size_t>(info.st_size);
+            file.contents.resize(std::max(expected + 1, kMinReadSize));
+            for (;;) {
+                ssize_t result = pread(fd, &file.contents[filled], file.contents.size() - filled,
+                                       static_cast<off_t>(filled));
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    file.error = errno;
+                    break;
+                }
+                filled += static_cast<size_t>(result);
+                if (result == 0 || (filled >= expected && expected > 0 &&
+                                    filled < file.contents.size())) {
+                    break;
+                }
+                if (filled == file.contents.size()) {
+                    file.contents.resize(file.contents.size() * 2);
+                }
+            }
+        }
+        close(fd);
+        file.ok = file.error == 0;
+        file.contents.resize(file.ok ? filled : 0);
+        deliver(file);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef INGEST_HPP
+#define INGEST_HPP
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Batch file ingestion for semanticdriver --ingest. Reading 100k small files
+// with a blocking open/read/close each leaves the driver waiting on the disk
+// one file at a time; FileIngestor keeps up to `depth` files in flight on an
+// io_uring instead (open, read and close are all asynchronous, set up with
+// raw io_uring_setup/io_uring_enter system calls, no liburing) and hands each
+// buffer over as soon as it is complete.
+//
+// When the kernel has no io_uring, refuses it (seccomp, io_uring_disabled)
+// or lacks the OPENAT/READ/CLOSE operations, or on non-Linux builds, it reads
+// the files one after another with open/fstat/pread/close. If io_uring_enter
+// fails partway through, the files it had in flight and the rest are read
+// that way too, once the reads the kernel had taken have completed.
+
+enum class IngestBackend {
+    IO_URING,
+    PREAD
+};
+
+// "uring" or "pread"
+const char* ingestBackendName(IngestBackend backend);
+
+// "uring" or "pread"; returns false for anything else
+bool parseIngestBackend(const char* name, IngestBackend& backend);
+
+struct IngestedFile {
+    size_t index = 0;       // position in the path list
+    bool ok = false;
+    int error = 0;          // errno when !ok
+    std::string contents;
+};
+
+class FileIngestor {
+ private:
+    struct Ring;
+    struct Slot;
+
+    std::unique_ptr<Ring> ring;  // null when reading with pread
+    size_t depth;
+    std::string fallback;
+
+    void readWithRing(const std::vector<std::string>& paths,
+                      const std::function<void(IngestedFile&)>& deliver);
+    void readRestWithPread(const std::vector<std::string>& paths, size_t nextPath,
+                           std::vector<Slot>& slots,
+                           const std::function<void(IngestedFile&)>& deliver);
+    void readWithPread(const std::vector<std::string>& paths,
+                       const std::function<void(IngestedFile&)>& deliver);
+
+ public:
+    static constexpr size_t kDefaultDepth = 64;
+
+    // Sets up an io_uring with `depth` entries unless `requested` is PREAD
+    explicit FileIngestor(IngestBackend requested, size_t depth = kDefaultDepth);
+    ~FileIngestor();
+
+    FileIngestor(const FileIngestor&) = delete;
+    FileIngestor& operator=(const FileIngestor&) = delete;
+
+    IngestBackend backend() const { return ring ? IngestBackend::IO_URING : IngestBackend::PREAD; }
+
+    // Why io_uring was requested but not used, or why readAll() gave up on
+    // it partway; empty otherwise
+    const std::string& fallbackReason() const { return fallback; }
+
+    // Read every file and call `deliver` once per path, on this thread, in
+    // completion order. `deliver` may take the contents and may block; reads
+    // already in flight carry on meanwhile, but no new ones start, so a slow
+    // consumer bounds the memory held in buffers.
+    void readAll(const std::vector<std::string>& paths,
+                 const std::function<void(IngestedFile&)>& deliver);
+};
+
+#endif // INGEST_HPP
@@ -0,0 +1,132 @@
+#include "interner.hpp"
+#include <stdexcept>
+
+ConcurrentInterner::Table::Table(size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<const Entry*>[capacity]) {
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentInterner::ConcurrentInterner() {}
+
+ConcurrentInterner::~ConcurrentInterner() {
+    for (Shard& shard : shards) {
+        for (auto& chunk : shard.chunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// The table is at most half full, so the probe reaches an empty slot
+const ConcurrentInterner::Entry* ConcurrentInterner::probe(const Table& table,
+                                                           std::string_view name, size_t hash) {
+    for (size_t i = hash & table.mask;; i = (i + 1) & table.mask) {
+        const Entry* entry = table.slots[i].load(std::memory_order_acquire);
+        if (!entry) {
+            return nullptr;
+        }
+        if (entry->hash == hash && entry->text == name) {
+            return entry;
+        }
+    }
+}
+
+void ConcurrentInterner::chunkOf(uint32_t local, uint32_t& chunk, uint32_t& offset) {
+    // Chunks 0..k-1 hold kFirstChunk * (2^k - 1) entries
+    uint32_t n = local / kFirstChunk + 1;
+    chunk = 31 - static_cast<uint32_t>(__builtin_clz(n));
+    offset = local - kFirstChunk * ((1u << chunk) - 1);
+}
+
+uint32_t ConcurrentInterner::intern(std::string_view name) {
+    size_t hash = hashName(name);
+    Shard& shard = shards[shardOf(hash)];
+    if (const Table* table = shard.table.load(std::memory_order_acquire)) {
+        if (const Entry* entry = probe(*table, name, hash)) {
+            return entry->id;
+        }
+    }
+    return insert(shard, name, hash);
+}
+
+uint32_t ConcurrentInterner::insert(Shard& shard, std::string_view name, size_t hash) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Table* table = shard.tables.empty() ? nullptr : shard.tables.back().get();
+    if (table) {
+        // Another thread may have added it since the lock-free probe
+        if (const Entry* entry = probe(*table, name, hash)) {
+            return entry->id;
+        }
+    }
+
+    uint32_t count = shard.count.load(std::memory_order_relaxed);
+    if (!table || 2 * (count + 1) > table->mask + 1) {
+        // Readers still probing the old table find every name it had
+        auto grown = std::make_unique<Table>(table ? 2 * (table->mask + 1) : 16);
+        if (table) {
+            for (size_t i = 0; i <= table->mask; ++i) {
+                const Entry* entry = table->slots[i].load(std::memory_order_relaxed);
+                if (!entry) {
+                    continue;
+                }
+                size_t j = entry->hash & grown->mask;
+                while (grown->slots[j].load(std::memory_order_relaxed)) {
+                    j = (j + 1) & grown->mask;
+                }
+                grown->slots[j].store(entry, std::memory_order_relaxed);
+            }
+        }
+        table = grown.get();
+        shard.tables.push_back(std::move(grown));
+        shard.table.store(table, std::memory_order_release);
+    }
+
+    if (count == kFirstChunk * ((1u << kChunks) - 1)) {
+        throw std::length_error("ConcurrentInterner: too many names");
+    }
+    uint32_t chunkIndex, offset;
+    chunkOf(count, chunkIndex, offset);
+    Entry* chunk = shard.chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new Entry[kFirstChunk << chunkIndex];
+        shard.chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+    Entry& entry = chunk[offset];
+    entry.text.assign(name.data(), name.size());
+    entry.hash = hash;
+    entry.id = count << kShardBits | static_cast<uint32_t>(&shard - shards);
+    shard.count.store(count + 1, std::memory_order_relaxed);
+
+    size_t i = hash & table->mask;
+    while (table->slots[i].load(std::memory_order_relaxed)) {
+        i = (i + 1) & table->mask;
+    }
+    table->slots[i].store(&entry, std::memory_order_release);
+    return entry.id;
+}
+
+uint32_t ConcurrentInterner::find(std::string_view name) const {
+    size_t hash = hashName(name);
+    const Table* table = shards[shardOf(hash)].table.load(std::memory_order_acquire);
+    if (!table) {
+        return kNoId;
+    }
+    const Entry* entry = probe(*table, name, hash);
+    return entry ? entry->id : kNoId;
+}
+
+std::string_view ConcurrentInterner::name(uint32_t id) const {
+    uint32_t chunk, offset;
+    chunkOf(id >> kShardBits, chunk, offset);
+    const Entry* entries = shards[id & (kShards - 1)].chunks[chunk].load(std::memory_order_acquire);
+    return entries[offset].text;
+}
+
+size_t ConcurrentInterner::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards) {
+        total += shard.count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
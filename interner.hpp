@@ -0,0 +1,98 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Identifier table shared by parser threads: intern() gives every distinct
+// name one stable 32-bit ID, whichever thread sees it first.
+//
+// Names are spread over kShards shards by hash. Each shard is an
+// open-addressing table of atomic pointers to immutable entries. Readers
+// never lock. find(), and intern() of a name that is already there, load the
+// shard's current table and probe it, which takes a bounded number of steps
+// whatever other threads are doing (wait-free). Only inserting a new name
+// takes the shard's mutex, so two threads adding different names mostly
+// touch different shards. A full table is copied into one twice the size
+// and the new one published. The old table stays readable until the
+// interner is destroyed, because a reader may still be probing it. Entries
+// live in chunks that never move, so name() is wait-free too.
+//
+// The low kShardBits bits of an ID are its shard and the rest count the
+// names inserted into that shard, so IDs are small but not dense.
+
+class ConcurrentInterner {
+ public:
+    static constexpr uint32_t kShardBits = 6;
+    static constexpr uint32_t kShards = 1u << kShardBits;
+    static constexpr uint32_t kNoId = UINT32_MAX;
+
+ private:
+    struct Entry {
+        std::string text;
+        size_t hash;
+        uint32_t id;
+    };
+
+    struct Table {
+        size_t mask;
+        std::unique_ptr<std::atomic<const Entry*>[]> slots;
+
+        explicit Table(size_t capacity);
+    };
+
+    // Entry storage: chunk k holds kFirstChunk << k entries
+    static constexpr uint32_t kFirstChunk = 64;
+    static constexpr uint32_t kChunks = 32 - kShardBits - 6;
+
+    struct alignas(64) Shard {
+        std::atomic<Table*> table{nullptr};
+        std::atomic<Entry*> chunks[kChunks] = {};
+        std::atomic<uint32_t> count{0};
+
+        // Writers only
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Table>> tables;  // the current one last
+    };
+
+    Shard shards[kShards];
+
+    static size_t hashName(std::string_view name) { return std::hash<std::string_view>()(name); }
+    // Tables index with the low bits of the hash, shards with the high ones
+    static uint32_t shardOf(size_t hash) {
+        return static_cast<uint32_t>(hash >> (8 * sizeof(size_t) - kShardBits));
+    }
+    static const Entry* probe(const Table& table, std::string_view name, size_t hash);
+    static void chunkOf(uint32_t local, uint32_t& chunk, uint32_t& offset);
+
+    uint32_t insert(Shard& shard, std::string_view name, size_t hash);
+
+ public:
+    ConcurrentInterner();
+    ~ConcurrentInterner();
+
+    ConcurrentInterner(const ConcurrentInterner&) = delete;
+    ConcurrentInterner& operator=(const ConcurrentInterner&) = delete;
+
+    // The ID of `name`, adding it if this is the first time it is seen
+    uint32_t intern(std::string_view name);
+
+    // The ID of an interned name, or kNoId; never blocks. A name another
+    // thread is interning at the same moment may not be found yet.
+    uint32_t find(std::string_view name) const;
+
+    // The text of an ID that intern() returned; valid for the interner's
+    // lifetime
+    std::string_view name(uint32_t id) const;
+
+    // Names interned so far; exact only when no thread is interning
+    size_t size() const;
+};
+
+#endif // INTERNER_HPP
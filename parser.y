@@ -25,7 +25,21 @@ extern int yylex();
 extern int yylineno;
 extern char* yytext;
 
+// Bison doubles its state/value/location stacks from YYINITDEPTH up to
+// YYMAXDEPTH entries. Its default maximum of 10000 fails deeply nested
+// parentheses or blocks with "memory exhausted"; each level costs a few
+// entries of about 26 bytes, so the cap only bounds runaway input. Set it
+// with `make PARSER_MAX_DEPTH=...`.
+#ifndef YYMAXDEPTH
+#define YYMAXDEPTH 100000000
+#endif
+
 int error_count = 0;
+// Position of the last syntax error. parseSource() clears
+// report_syntax_errors for callers that want it back instead of on stderr.
+int syntax_error_line = 0;
+int syntax_error_column = 0;
+bool report_syntax_errors = true;
 int yydebug = 0;
 static int last_token_line = 1;
 static int last_token_column = 1;
@@ -34,6 +48,63 @@ static int last_token_column = 1;
 %parse-param { ASTNode** root }
 %locations
 
+%code provides {
+    // One token as the scanner returned it, for parsing a file that was
+    // scanned earlier (and maybe on another thread); see parseTokens()
+    struct ScannedToken {
+        int kind;
+        YYSTYPE value;
+        YYLTYPE location;
+    };
+}
+
+%code {
+// The scanner returns each token's value and location in yylval/yylloc.
+// yyparse works on its own copies, parser_lval/parser_lloc (the defines
+// below rename them), so that with token replay the parser never touches
+// the variables the scanner is writing on another thread.
+YYSTYPE yylval;
+YYLTYPE yylloc;
+extern YYSTYPE parser_lval;
+extern YYLTYPE parser_lloc;
+
+// Tokens to replay instead of calling the scanner, set by parseTokens().
+// Without replay_tokens, yyparse reads straight from flex.
+bool replay_tokens = false;
+const ScannedToken* replay_next = nullptr;
+const ScannedToken* replay_end = nullptr;
+static bool replay_at_eof = false;
+
+static int next_token() {
+    if (!replay_tokens) {
+        int kind = yylex();
+        parser_lval = yylval;
+        parser_lloc = yylloc;
+        return kind;
+    }
+    if (replay_next == replay_end) {
+        replay_at_eof = true;
+        return 0;
+    }
+    const ScannedToken& token = *replay_next++;
+    parser_lval = token.value;
+    parser_lloc = token.location;
+    replay_at_eof = token.kind == END_OF_FILE || token.kind == 0;
+    return token.kind;
+}
+#define yylex next_token
+#define yylval parser_lval
+#define yylloc parser_lloc
+
+// Record the source span of the rule that built `node`
+template <typename Node>
+static Node* located(Node* node, const YYLTYPE& location) {
+    node->span = SourceSpan{location.first_line, location.first_column,
+                            location.last_line, location.last_column};
+    return node;
+}
+}
+
 %union {
     ProgramNode* program;
     DeclNode* decl;
@@ -77,7 +148,7 @@ static int last_token_column = 1;
 %start program
 %%
 
-program : decl_list END_OF_FILE { ProgramNode* ast = new ProgramNode(); for (auto& decl : *$1) ast->addDecl(decl); *root = ast; delete $1; };
+program : decl_list END_OF_FILE { ProgramNode* ast = located(new ProgramNode(), @$); for (auto& decl : *$1) ast->addDecl(decl); *root = ast; delete $1; };
 
 decl_list : decl_list decl { $$ = $1; if ($2 != nullptr) $$->push_back($2); }
           | decl { $$ = new std::vector<DeclNode*>; if ($1 != nullptr) $$->push_back($1); };
@@ -85,7 +156,7 @@ decl_list : decl_list decl { $$ = $1; if ($2 != nullptr) $$->push_back($2); }
 decl : func_decl { $$ = $1; } | var_decl { $$ = $1; };
 
 func_decl : FUNC_KEYWORD IDENTIFIER LPAREN_DELIMITER param_list RPAREN_DELIMITER COLON_DELIMITER type LBRACE_DELIMITER block RBRACE_DELIMITER {
-    FunctionDeclNode* func = new FunctionDeclNode(*$2, $7);
+    FunctionDeclNode* func = located(new FunctionDeclNode(*$2, $7), @$);
     for (auto param : *$4) func->addParameter(param);
     for (auto item : *$9) func->addBodyItem(item);
     $$ = func;
@@ -100,10 +171,10 @@ param_list_nonempty : param_list_nonempty COMMA_DELIMITER param { $$ = $1; $$->p
 param : IDENTIFIER COLON_DELIMITER type { $$ = new ParamNode(*$1, $3); delete $1; };
 
 var_decl : VAR_KEYWORD IDENTIFIER COLON_DELIMITER type ASSIGN_OP expr SEMI_DELIMITER {
-    $$ = new VarDeclNode(false, *$2, $4, $6); delete $2;
+    $$ = located(new VarDeclNode(false, *$2, $4, $6), @$); delete $2;
 }
 | LET_KEYWORD IDENTIFIER COLON_DELIMITER type ASSIGN_OP expr SEMI_DELIMITER {
-    $$ = new VarDeclNode(true, *$2, $4, $6); delete $2;
+    $$ = located(new VarDeclNode(true, *$2, $4, $6), @$); delete $2;
 };
 
 type : INT_KEYWORD { $$ = new TypeNode("int"); }
@@ -119,55 +190,55 @@ block_items : block_items var_decl { $$ = $1; if ($2 != nullptr) $$->push_back($
             | func_decl { $$ = new std::vector<ASTNode*>; if ($1 != nullptr) $$->push_back($1); }
             | stmt { $$ = new std::vector<ASTNode*>; if ($1 != nullptr) $$->push_back($1); };
 
-stmt : PRINT_KEYWORD LPAREN_DELIMITER expr RPAREN_DELIMITER SEMI_DELIMITER { $$ = new PrintStmtNode($3); }
+stmt : PRINT_KEYWORD LPAREN_DELIMITER expr RPAREN_DELIMITER SEMI_DELIMITER { $$ = located(new PrintStmtNode($3), @$); }
      | IF_KEYWORD LPAREN_DELIMITER expr RPAREN_DELIMITER LBRACE_DELIMITER block RBRACE_DELIMITER {
-         IfStmtNode* ifStmt = new IfStmtNode($3);
+         IfStmtNode* ifStmt = located(new IfStmtNode($3), @$);
          for (auto item : *$6) ifStmt->addThenItem(item);
          $$ = ifStmt; delete $6;
      }
      | IF_KEYWORD LPAREN_DELIMITER expr RPAREN_DELIMITER LBRACE_DELIMITER block RBRACE_DELIMITER ELSE_KEYWORD LBRACE_DELIMITER block RBRACE_DELIMITER {
-         IfStmtNode* ifStmt = new IfStmtNode($3);
+         IfStmtNode* ifStmt = located(new IfStmtNode($3), @$);
          for (auto item : *$6) ifStmt->addThenItem(item);
          for (auto item : *$10) ifStmt->addElseItem(item);
          $$ = ifStmt; delete $6; delete $10;
      }
      | WHILE_KEYWORD LPAREN_DELIMITER expr RPAREN_DELIMITER LBRACE_DELIMITER block RBRACE_DELIMITER {
-         WhileStmtNode* whileStmt = new WhileStmtNode($3);
+         WhileStmtNode* whileStmt = located(new WhileStmtNode($3), @$);
          for (auto item : *$6) whileStmt->addBodyItem(item);
          $$ = whileStmt; delete $6;
      }
-     | IDENTIFIER ASSIGN_OP expr SEMI_DELIMITER { $$ = new AssignmentStmtNode(*$1, $3); delete $1; }
-     | RETURN_KEYWORD expr SEMI_DELIMITER { $$ = new ReturnStmtNode($2); };
+     | IDENTIFIER ASSIGN_OP expr SEMI_DELIMITER { $$ = located(new AssignmentStmtNode(*$1, $3), @$); delete $1; }
+     | RETURN_KEYWORD expr SEMI_DELIMITER { $$ = located(new ReturnStmtNode($2), @$); };
 
 expr : equality_expr;
 
 equality_expr : comparison_expr
-              | equality_expr EQUAL_OP comparison_expr { $$ = new BinaryOpNode($1, "==", $3); }
-              | equality_expr NEQ_OP comparison_expr { $$ = new BinaryOpNode($1, "!=", $3); };
+              | equality_expr EQUAL_OP comparison_expr { $$ = located(new BinaryOpNode($1, "==", $3), @$); }
+              | equality_expr NEQ_OP comparison_expr { $$ = located(new BinaryOpNode($1, "!=", $3), @$); };
 
 comparison_expr : additive_expr
-                | comparison_expr LT_OP additive_expr { $$ = new BinaryOpNode($1, "<", $3); }
-                | comparison_expr GT_OP additive_expr { $$ = new BinaryOpNode($1, ">", $3); }
-                | comparison_expr LEQ_OP additive_expr { $$ = new BinaryOpNode($1, "<=", $3); }
-                | comparison_expr GEQ_OP additive_expr { $$ = new BinaryOpNode($1, ">=", $3); };
+                | comparison_expr LT_OP additive_expr { $$ = located(new BinaryOpNode($1, "<", $3), @$); }
+                | comparison_expr GT_OP additive_expr { $$ = located(new BinaryOpNode($1, ">", $3), @$); }
+                | comparison_expr LEQ_OP additive_expr { $$ = located(new BinaryOpNode($1, "<=", $3), @$); }
+                | comparison_expr GEQ_OP additive_expr { $$ = located(new BinaryOpNode($1, ">=", $3), @$); };
 
 additive_expr : multiplicative_expr
-              | additive_expr PLUS_OP multiplicative_expr { $$ = new BinaryOpNode($1, "+", $3); }
-              | additive_expr MINUS_OP multiplicative_expr { $$ = new BinaryOpNode($1, "-", $3); };
+              | additive_expr PLUS_OP multiplicative_expr { $$ = located(new BinaryOpNode($1, "+", $3), @$); }
+              | additive_expr MINUS_OP multiplicative_expr { $$ = located(new BinaryOpNode($1, "-", $3), @$); };
 
 multiplicative_expr : unary_expr
-                    | multiplicative_expr MULTIPLY_OP unary_expr { $$ = new BinaryOpNode($1, "*", $3); }
-                    | multiplicative_expr DIVIDE_OP unary_expr { $$ = new BinaryOpNode($1, "/", $3); };
+                    | multiplicative_expr MULTIPLY_OP unary_expr { $$ = located(new BinaryOpNode($1, "*", $3), @$); }
+                    | multiplicative_expr DIVIDE_OP unary_expr { $$ = located(new BinaryOpNode($1, "/", $3), @$); };
 
-unary_expr : primary_expr | MINUS_OP unary_expr { $$ = new UnaryOpNode("-", $2); };
+unary_expr : primary_expr | MINUS_OP unary_expr { $$ = located(new UnaryOpNode("-", $2), @$); };
 
-primary_expr : INTEGER_LITERAL { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = new IntegerNode($1); }
-             | FLOAT_LITERAL { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = new FloatNode($1); }
-             | BOOL_LITERAL { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = new BoolNode($1); }
-             | IDENTIFIER { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = new IdentifierNode(*$1); delete $1; }
+primary_expr : INTEGER_LITERAL { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = located(new IntegerNode($1), @$); }
+             | FLOAT_LITERAL { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = located(new FloatNode($1), @$); }
+             | BOOL_LITERAL { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = located(new BoolNode($1), @$); }
+             | IDENTIFIER { last_token_line = yylloc.last_line; last_token_column = yylloc.last_column; $$ = located(new IdentifierNode(*$1), @$); delete $1; }
              | IDENTIFIER LPAREN_DELIMITER arg_list RPAREN_DELIMITER {
                  last_token_line = yylloc.last_line; last_token_column = yylloc.last_column;
-                 FunctionCallNode* call = new FunctionCallNode(*$1);
+                 FunctionCallNode* call = located(new FunctionCallNode(*$1), @$);
                  for (auto arg : *$3) call->addArgument(arg);
                  $$ = call; delete $1; delete $3;
              }
@@ -183,12 +254,18 @@ arg_list_nonempty : arg_list_nonempty COMMA_DELIMITER expr { $$ = $1; $$->push_b
 void yyerror(ASTNode** root, const char* s) {
     (void)root; (void)s;
     error_count++;
-    bool at_eof = (yytext == NULL || yytext[0] == '\0');
+    // yytext belongs to the scanner, which may be busy with another file
+    // while replayed tokens are parsed
+    bool at_eof = replay_tokens ? replay_at_eof : (yytext == NULL || yytext[0] == '\0');
     int error_line = yylloc.first_line;
     int error_column = yylloc.first_column;
     if (at_eof && last_token_line > 0) {
         error_line = last_token_line;
         error_column = last_token_column + 1;
     }
-    fprintf(stderr, "Parser error at line %d, column %d\n", error_line, error_column);
+    syntax_error_line = error_line;
+    syntax_error_column = error_column;
+    if (report_syntax_errors) {
+        fprintf(stderr, "Parser error at line %d, column %d\n", error_line, error_column);
+    }
 }
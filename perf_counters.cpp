@@ -0,0 +1,182 @@
+#include "perf_counters.hpp"
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Closes this thread's counters when it exits. The first event that
+// opened leads the group; a group read returns the members in the order
+// they joined, which `order` records.
+struct ThreadCounters {
+    int fd[kPerfEventCount];
+    int leader = -1;
+    PerfEvent order[kPerfEventCount];
+    size_t members = 0;
+    uint32_t events = 0;
+
+    ThreadCounters() {
+        for (int& f : fd) {
+            f = -1;
+        }
+    }
+
+    ~ThreadCounters() {
+#ifdef __linux__
+        for (int f : fd) {
+            if (f >= 0) {
+                close(f);
+            }
+        }
+#endif
+    }
+};
+
+thread_local ThreadCounters counters;
+
+#ifdef __linux__
+
+constexpr uint64_t cacheReadMisses(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+void setEventType(PerfEvent event, perf_event_attr& attr) {
+    switch (event) {
+        case PerfEvent::CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            return;
+        case PerfEvent::INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            return;
+        case PerfEvent::BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            return;
+        case PerfEvent::L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cacheReadMisses(PERF_COUNT_HW_CACHE_L1D);
+            return;
+        case PerfEvent::LLC_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cacheReadMisses(PERF_COUNT_HW_CACHE_LL);
+            return;
+        case PerfEvent::Count:
+            break;
+    }
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CPU_CYCLES;
+}
+
+// Opens `event` as the group leader when `leader` is -1, else as a member of
+// its group
+int openEvent(PerfEvent event, int leader) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    setEventType(event, attr);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // pid 0, cpu -1: the calling thread on whichever CPU it runs
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+}
+
+#endif // __linux__
+
+} // namespace
+
+const char* perfEventName(PerfEvent event) {
+    switch (event) {
+#define X(name, label) case PerfEvent::name: return label;
+        PERF_EVENTS(X)
+#undef X
+        case PerfEvent::Count: break;
+    }
+    return "?";
+}
+
+uint32_t openThreadPerfCounters(std::string& error) {
+    if (counters.events) {
+        return counters.events;
+    }
+#ifdef __linux__
+    int firstErrno = 0;
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        // An event that cannot join the group (e.g. more than the PMU can
+        // count at once) is left out rather than multiplexed on its own
+        int fd = openEvent(static_cast<PerfEvent>(i), counters.leader);
+        if (fd < 0) {
+            if (!firstErrno) {
+                firstErrno = errno;
+            }
+            continue;
+        }
+        counters.fd[i] = fd;
+        if (counters.leader < 0) {
+            counters.leader = fd;
+        }
+        counters.order[counters.members++] = static_cast<PerfEvent>(i);
+        counters.events |= perfEventBit(static_cast<PerfEvent>(i));
+    }
+    if (!counters.events) {
+        error = std::string("perf_event_open: ") + std::strerror(firstErrno);
+        if (firstErrno == EACCES || firstErrno == EPERM) {
+            error += " (see /proc/sys/kernel/perf_event_paranoid)";
+        } else if (firstErrno == ENOENT || firstErrno == EOPNOTSUPP) {
+            error += " (no hardware PMU, e.g. inside a VM)";
+        }
+    }
+#else
+    error = "hardware counters need Linux perf_event_open";
+#endif
+    return counters.events;
+}
+
+uint32_t threadPerfEvents() {
+    return counters.events;
+}
+
+void readThreadPerfCounters(PerfReading& reading) {
+    reading = PerfReading();
+#ifdef __linux__
+    if (counters.leader < 0) {
+        return;
+    }
+    // nr, time enabled, time running, then one value per member
+    uint64_t data[3 + kPerfEventCount];
+    ssize_t size = static_cast<ssize_t>((3 + counters.members) * sizeof(uint64_t));
+    if (read(counters.leader, data, sizeof(data)) != size || data[0] != counters.members) {
+        return;
+    }
+    reading.enabled = data[1];
+    reading.running = data[2];
+    for (size_t i = 0; i < counters.members; ++i) {
+        reading.value[static_cast<size_t>(counters.order[i])] = data[3 + i];
+    }
+#endif
+}
+
+PerfSample perfDelta(const PerfReading& start, const PerfReading& end) {
+    PerfSample sample;
+    uint64_t enabled = end.enabled > start.enabled ? end.enabled - start.enabled : 0;
+    uint64_t running = end.running > start.running ? end.running - start.running : 0;
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        if (end.value[i] <= start.value[i]) {
+            continue;
+        }
+        uint64_t delta = end.value[i] - start.value[i];
+        if (running && running < enabled) {
+            delta = static_cast<uint64_t>(static_cast<double>(delta) * enabled / running);
+        }
+        sample.value[i] = delta;
+    }
+    return sample;
+}
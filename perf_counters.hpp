@@ -0,0 +1,69 @@
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Hardware performance counters for semanticdriver --perf, read with
+// perf_event_open(2) around each --stats phase. Counters are opened per
+// thread as one group, so they are scheduled together and share one
+// enabled/running time; they count user space only. A phase's counts are the
+// raw deltas between two readings, scaled by the share of that interval the
+// group actually ran when the kernel multiplexes it.
+//
+// Any event the kernel or CPU refuses (no PMU in a VM, perf_event_paranoid,
+// seccomp, non-Linux builds) is simply left out; when none open, --perf
+// reports why and --stats carries on with times only.
+
+#define PERF_EVENTS(X)                     \
+    X(CYCLES, "cycles")                    \
+    X(INSTRUCTIONS, "instructions")        \
+    X(BRANCH_MISSES, "branch-misses")      \
+    X(L1D_MISSES, "L1d-misses")            \
+    X(LLC_MISSES, "LLC-misses")
+
+enum class PerfEvent : uint8_t {
+#define X(name, label) name,
+    PERF_EVENTS(X)
+#undef X
+    Count
+};
+
+constexpr size_t kPerfEventCount = static_cast<size_t>(PerfEvent::Count);
+
+const char* perfEventName(PerfEvent event);
+
+constexpr uint32_t perfEventBit(PerfEvent event) {
+    return uint32_t(1) << static_cast<unsigned>(event);
+}
+
+struct PerfSample {
+    uint64_t value[kPerfEventCount] = {};
+
+    uint64_t operator[](PerfEvent event) const { return value[static_cast<size_t>(event)]; }
+};
+
+// Open the counters for the calling thread. Returns the set of events that
+// opened as perfEventBit() flags; when that is 0, `error` says why.
+uint32_t openThreadPerfCounters(std::string& error);
+
+// Events open on the calling thread; 0 unless openThreadPerfCounters succeeded
+uint32_t threadPerfEvents();
+
+// Raw counts of the calling thread's group; only meaningful as the start or
+// end of a perfDelta()
+struct PerfReading {
+    uint64_t value[kPerfEventCount] = {};
+    uint64_t enabled = 0;   // ns the group was enabled
+    uint64_t running = 0;   // ns it was actually on the PMU
+};
+
+// Current raw counts on the calling thread; unopened events read 0
+void readThreadPerfCounters(PerfReading& reading);
+
+// Counts between two readings, scaled up for the time the group was
+// multiplexed out in between. Never negative.
+PerfSample perfDelta(const PerfReading& start, const PerfReading& end);
+
+#endif // PERF_COUNTERS_HPP
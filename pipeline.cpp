@@ -0,0 +1,60 @@
+#include "pipeline.hpp"
+#include <iomanip>
+#include "json.hpp"
+
+namespace {
+
+double utilization(const StageStats& stage, double wallMs) {
+    return stage.threads && wallMs > 0 ? stage.busyMs / (stage.threads * wallMs) : 0;
+}
+
+} // namespace
+
+void printPipelineStats(std::ostream& out, double wallMs, const std::vector<StageStats>& stages,
+                        const std::vector<QueueStats>& queues) {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "pipeline: wall " << wallMs << " ms\n";
+    out << "pipeline: stage       threads     files     busy ms  utilization\n";
+    for (const auto& stage : stages) {
+        out << "pipeline:   " << std::left << std::setw(10) << stage.name << std::right
+            << std::setw(8) << stage.threads << std::setw(10) << stage.items
+            << std::setw(12) << stage.busyMs << std::setw(12) << 100 * utilization(stage, wallMs)
+            << "%\n";
+    }
+    out << "pipeline: queue          capacity     files   mean len   max len  full wait ms"
+           "  empty wait ms\n";
+    for (const auto& queue : queues) {
+        out << "pipeline:   " << std::left << std::setw(14) << queue.name << std::right
+            << std::setw(7) << queue.capacity << std::setw(10) << queue.items
+            << std::setw(11) << queue.meanLength << std::setw(10) << queue.maxLength
+            << std::setw(14) << queue.fullWaitMs << std::setw(15) << queue.emptyWaitMs << "\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void printPipelineStatsJson(std::ostream& out, double wallMs,
+                            const std::vector<StageStats>& stages,
+                            const std::vector<QueueStats>& queues) {
+    out << "{\"pipeline\": {\"wall_ms\": " << wallMs << ", \"stages\": [";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        out << (i ? ", " : "") << "{\"name\": " << jsonString(stages[i].name)
+            << ", \"threads\": " << stages[i].threads << ", \"files\": " << stages[i].items
+            << ", \"busy_ms\": " << stages[i].busyMs
+            << ", \"utilization\": " << utilization(stages[i], wallMs) << "}";
+    }
+    out << "], \"queues\": [";
+    for (size_t i = 0; i < queues.size(); ++i) {
+        out << (i ? ", " : "") << "{\"name\": " << jsonString(queues[i].name)
+            << ", \"capacity\": " << queues[i].capacity << ", \"files\": " << queues[i].items
+            << ", \"mean_length\": " << queues[i].meanLength
+            << ", \"max_length\": " << queues[i].maxLength
+            << ", \"full_wait_ms\": " << queues[i].fullWaitMs
+            << ", \"empty_wait_ms\": " << queues[i].emptyWaitMs << "}";
+    }
+    out << "]}}\n";
+}
@@ -0,0 +1,143 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Stage queues for semanticdriver --pipeline, which reads, scans, parses and
+// analyzes different files at the same time: each stage has its own threads
+// and hands files to the next through a StageQueue. A queue holds at most
+// `capacity` files and push() blocks while it is full, so a stage that runs
+// ahead waits for the slower one after it (backpressure) instead of piling
+// up sources, token buffers or ASTs in memory.
+//
+// Each queue keeps the numbers --stats reports: its time-weighted mean and
+// peak length, and how long producers spent blocked because it was full and
+// consumers because it was empty. A queue that is usually full sits in front
+// of the bottleneck stage; one that is usually empty comes after it.
+
+struct QueueStats {
+    std::string name;
+    size_t capacity = 0;
+    uint64_t items = 0;
+    double meanLength = 0;
+    size_t maxLength = 0;
+    double fullWaitMs = 0;     // producers blocked on a full queue, summed over threads
+    double emptyWaitMs = 0;    // consumers blocked on an empty one, summed over threads
+};
+
+// Filled in by the driver's stage threads
+struct StageStats {
+    std::string name;
+    unsigned threads = 0;
+    uint64_t items = 0;
+    double busyMs = 0;         // summed over the stage's threads
+};
+
+template <typename T>
+class StageQueue {
+ private:
+    using Clock = std::chrono::steady_clock;
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty, notFull;
+    std::deque<T> items;
+    unsigned producers;
+    Clock::time_point created, changed;
+    double lengthTimesMs;      // integral of the length over time
+    QueueStats totals;
+
+    static double ms(Clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    // Account for the time the queue spent at its current length
+    void lengthChanging(Clock::time_point now) {
+        lengthTimesMs += items.size() * ms(now - changed);
+        changed = now;
+    }
+
+ public:
+    // pop() reports the end once `producers` threads have called
+    // producerDone() and the queue is empty
+    StageQueue(const std::string& name, size_t capacity, unsigned producers)
+        : producers(producers), created(Clock::now()), changed(created), lengthTimesMs(0) {
+        totals.name = name;
+        totals.capacity = capacity;
+    }
+
+    StageQueue(const StageQueue&) = delete;
+    StageQueue& operator=(const StageQueue&) = delete;
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.size() >= totals.capacity) {
+            Clock::time_point start = Clock::now();
+            notFull.wait(lock, [this] { return items.size() < totals.capacity; });
+            totals.fullWaitMs += ms(Clock::now() - start);
+        }
+        lengthChanging(Clock::now());
+        items.push_back(std::move(item));
+        ++totals.items;
+        if (items.size() > totals.maxLength) {
+            totals.maxLength = items.size();
+        }
+        notEmpty.notify_one();
+    }
+
+    // The next item; false once every producer is done and nothing is left
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.empty() && producers > 0) {
+            Clock::time_point start = Clock::now();
+            notEmpty.wait(lock, [this] { return !items.empty() || producers == 0; });
+            totals.emptyWaitMs += ms(Clock::now() - start);
+        }
+        if (items.empty()) {
+            return false;
+        }
+        lengthChanging(Clock::now());
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void producerDone() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--producers == 0) {
+            notEmpty.notify_all();
+        }
+    }
+
+    // Totals so far, with the mean length over the queue's lifetime
+    QueueStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        Clock::time_point now = Clock::now();
+        QueueStats result = totals;
+        double lifeMs = ms(now - created);
+        if (lifeMs > 0) {
+            result.meanLength = (lengthTimesMs + items.size() * ms(now - changed)) / lifeMs;
+        }
+        return result;
+    }
+};
+
+// Report for --stats once every file is done. Utilization is busy time over
+// threads × wall time. Text lines are prefixed with "pipeline: ".
+void printPipelineStats(std::ostream& out, double wallMs, const std::vector<StageStats>& stages,
+                        const std::vector<QueueStats>& queues);
+
+// The same as one JSON object on a single line
+void printPipelineStatsJson(std::ostream& out, double wallMs,
+                            const std::vector<StageStats>& stages,
+                            const std::vector<QueueStats>& queues);
+
+#endif // PIPELINE_HPP
@@ -3,6 +3,17 @@
 
 // Main entry point
 void SemanticAnalyzer::analyze() {
+    throwIfFailed(analyzeRoot());
+}
+
+std::optional<SemanticError> SemanticAnalyzer::tryAnalyze() {
+    if (analyzeRoot()) {
+        return std::nullopt;
+    }
+    return std::move(error);
+}
+
+bool SemanticAnalyzer::analyzeRoot() {
     if (!root) {
         throw std::runtime_error("AST root is null");
     }
@@ -12,7 +23,91 @@ void SemanticAnalyzer::analyze() {
         throw std::runtime_error("Root is not a ProgramNode");
     }
     
-    analyzeProgram(program);
+    return analyzeProgram(program);
+}
+
+// A SemanticErrorContext together with the values it was built from. The
+// factories mirror SemanticErrorContext's.
+struct SemanticAnalyzer::ErrorInfo {
+    SemanticErrorContext context;
+    SemanticErrorDetail detail;
+    
+    static ErrorInfo Function(const std::string& name) {
+        return ErrorInfo{SemanticErrorContext::Function(name), named(name)};
+    }
+    
+    static ErrorInfo Identifier(const std::string& name) {
+        return ErrorInfo{SemanticErrorContext::Identifier(name), named(name)};
+    }
+    
+    static ErrorInfo IdentifierTypeMismatch(const std::string& name, DataType expected,
+                                            DataType found) {
+        return ErrorInfo{SemanticErrorContext::IdentifierTypeMismatch(name, expected, found),
+                         typed(name, {expected}, {found})};
+    }
+    
+    static ErrorInfo ReturnTypeMismatch(const std::string& function, DataType expected,
+                                        DataType found) {
+        return ErrorInfo{SemanticErrorContext::ReturnTypeMismatch(function, expected, found),
+                         typed(function, {expected}, {found})};
+    }
+    
+    static ErrorInfo ActualType(DataType found) {
+        return ErrorInfo{SemanticErrorContext::ActualType(found), typed("", {}, {found})};
+    }
+    
+    static ErrorInfo InvalidOperationBetweenTypes(const std::string& op, DataType left,
+                                                  DataType right) {
+        return ErrorInfo{SemanticErrorContext::InvalidOperationBetweenTypes(op, left, right),
+                         typed(op, {}, {left, right})};
+    }
+    
+    static ErrorInfo ArgCount(const std::string& function, size_t expected, size_t found) {
+        ErrorInfo info{SemanticErrorContext::ArgCount(function, expected, found), named(function)};
+        info.detail.expectedCount = static_cast<long>(expected);
+        info.detail.foundCount = static_cast<long>(found);
+        return info;
+    }
+    
+    // `found` holds the types of the arguments checked so far
+    static ErrorInfo Signature(const std::string& function, const FunctionSignature& expected,
+                               const DataType* found, size_t foundCount) {
+        std::vector<DataType> expectedTypes(expected.paramTypes,
+                                            expected.paramTypes + expected.paramCount);
+        std::vector<DataType> foundTypes(found, found + foundCount);
+        return ErrorInfo{SemanticErrorContext::Signature(function, expectedTypes, foundTypes),
+                         typed(function, std::move(expectedTypes), std::move(foundTypes))};
+    }
+    
+    static SemanticErrorDetail named(const std::string& name) {
+        SemanticErrorDetail detail;
+        detail.name = name;
+        return detail;
+    }
+    
+    static SemanticErrorDetail typed(const std::string& name, std::vector<DataType> expected,
+                                     std::vector<DataType> found) {
+        SemanticErrorDetail detail = named(name);
+        detail.expected = std::move(expected);
+        detail.found = std::move(found);
+        return detail;
+    }
+};
+
+// Record the first semantic error, found at `node`; every caller returns
+// false up to the entry point
+bool SemanticAnalyzer::fail(SemanticErrorType type, const ASTNode* node, ErrorInfo info) {
+    error.type = type;
+    error.context = std::move(info.context);
+    error.node = node;
+    error.detail = std::move(info.detail);
+    return false;
+}
+
+void SemanticAnalyzer::throwIfFailed(bool ok) {
+    if (!ok) {
+        throw SemanticException(error.type, error.context);
+    }
 }
 
 void SemanticAnalyzer::visit(IntegerNode* node) {
@@ -75,68 +170,109 @@ bool SemanticAnalyzer::isAssignmentCompatible(DataType target, DataType source)
 }
 
 // Analyze program
-void SemanticAnalyzer::analyzeProgram(ProgramNode* node) {
-    // Create global scope
-    currentScope = std::make_shared<Scope>(nullptr);
+bool SemanticAnalyzer::analyzeProgram(ProgramNode* node) {
+    PhaseClock clock;
     
-    // First pass: Register all function declarations
-    for (auto decl : node->declarations) {
-        if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(decl)) {
-            // Check if identifier already declared (could be function or variable)
-            if (currentScope->existsLocal(funcDecl->name)) {
-                // Check what kind of symbol it is
-                SymbolInfo* existing = currentScope->lookupLocal(funcDecl->name);
-                if (existing && existing->kind == SymbolKind::FUNCTION) {
-                    throw SemanticException(
-                        SemanticErrorType::REDECLARED_FUNCTION,
-                        SemanticErrorContext::Function(funcDecl->name)
-                    );
-                } else {
-                    // It's a variable - this is also an error
-                    throw SemanticException(
-                        SemanticErrorType::REDECLARED_IDENTIFIER,
-                        SemanticErrorContext::Identifier(funcDecl->name)
-                    );
+    // Create global scope; a previous analyze() may have failed mid-block
+    blocks.clear();
+    currentFunction = nullptr;
+    currentFunctionReturnType = DataType::IOTA;
+    hasReturn = false;
+    isUnreachable = false;
+    {
+        ALLOC_SITE(SCOPE);
+        currentScope = scopes.reset(stats ? &stats->scopes : nullptr);
+    }
+    
+    // First pass: Register all function declarations, unless the shared
+    // table from an earlier run still describes them
+    if (!(shareGlobalTable && globalTable && globalTable->matches(node))) {
+        globalTable.reset();
+        signatures.clear();
+        for (auto decl : node->declarations) {
+            if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(decl)) {
+                // Check if identifier already declared (could be function or variable)
+                if (currentScope->existsLocal(funcDecl->name)) {
+                    // Check what kind of symbol it is
+                    SymbolInfo* existing = currentScope->lookupLocal(funcDecl->name);
+                    if (existing && existing->kind == SymbolKind::FUNCTION) {
+                        return fail(
+                            SemanticErrorType::REDECLARED_FUNCTION,
+                            funcDecl,
+                            ErrorInfo::Function(funcDecl->name)
+                        );
+                    } else {
+                        // It's a variable - this is also an error
+                        return fail(
+                            SemanticErrorType::REDECLARED_IDENTIFIER,
+                            funcDecl,
+                            ErrorInfo::Identifier(funcDecl->name)
+                        );
+                    }
                 }
+                
+                // Add function to symbol table
+                ALLOC_SITE(SYMBOL);
+                SymbolInfo* funcInfo = currentScope->addSymbol(
+                    funcDecl->name, DataType::IOTA, SymbolKind::FUNCTION);
+                
+                // Functions with the same types share one pool entry
+                paramTypes.clear();
+                for (const auto& param : funcDecl->parameters) {
+                    paramTypes.push_back(param.type);
+                }
+                funcInfo->signature = signatures.intern(
+                    funcDecl->returnType, paramTypes.data(), paramTypes.size());
             }
-            
-            // Add function to symbol table
-            auto funcInfo = std::make_unique<SymbolInfo>();
-            funcInfo->name = funcDecl->name;
-            funcInfo->kind = SymbolKind::FUNCTION;
-            funcInfo->returnType = funcDecl->returnType;
-            
-            for (const auto& param : funcDecl->parameters) {
-                funcInfo->paramTypes.push_back(param.type);
-            }
-            
-            currentScope->addSymbol(funcDecl->name, std::move(funcInfo));
         }
+        
+        if (shareGlobalTable) {
+            // Functions are resolved through the frozen table from here on
+            ALLOC_SITE(SYMBOL);
+            globalTable = GlobalSymbolTable::build(*currentScope, signatures);
+            currentScope->clear();
+        }
+    }
+    
+    if (stats) {
+        stats->addPhase("declare", clock);
+        clock.restart();
     }
     
     // Second pass: Analyze all declarations
     for (auto decl : node->declarations) {
         if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(decl)) {
-            analyzeFunctionDecl(funcDecl);
+            if (!analyzeFunctionDecl(funcDecl)) return false;
         } else if (VarDeclNode* varDecl = dynamic_cast<VarDeclNode*>(decl)) {
-            analyzeVarDecl(varDecl);
+            if (!analyzeVarDecl(varDecl)) return false;
         }
     }
+    
+    if (stats) {
+        stats->addPhase("analyze", clock);
+    }
+    return true;
 }
 
 // Analyze function declaration
-void SemanticAnalyzer::analyzeFunctionDecl(FunctionDeclNode* node) {
+bool SemanticAnalyzer::analyzeFunctionDecl(FunctionDeclNode* node) {
+    size_t depth = blocks.size();
+    return enterFunctionDecl(node) && runBlocks(depth);
+}
+
+// Open the function's scope and context and push its body; leaveBlock
+// checks the return paths and restores the enclosing context
+bool SemanticAnalyzer::enterFunctionDecl(FunctionDeclNode* node) {
     // Create new scope for function
-    auto parentScope = currentScope;
-    currentScope = std::make_shared<Scope>(parentScope);
+    BlockFrame& frame = pushBlock(node->bodyItems, node, BlockOwner::FUNCTION, true);
     
     // Save current function context
-    std::string previousFunction = currentFunction;
-    DataType previousReturnType = currentFunctionReturnType;
-    bool previousHasReturn = hasReturn;
-    bool previousUnreachable = isUnreachable;
+    frame.savedFunction = currentFunction;
+    currentFunction = node;
+    frame.savedReturnType = currentFunctionReturnType;
+    frame.savedHasReturn = hasReturn;
+    frame.savedUnreachable = isUnreachable;
     
-    currentFunction = node->name;
     currentFunctionReturnType = node->returnType;
     hasReturn = false;
     isUnreachable = false;
@@ -144,66 +280,49 @@ void SemanticAnalyzer::analyzeFunctionDecl(FunctionDeclNode* node) {
     // Add parameters to function scope
     for (const auto& param : node->parameters) {
         if (currentScope->existsLocal(param.name)) {
-            throw SemanticException(
+            return fail(
                 SemanticErrorType::REDECLARED_IDENTIFIER,
-                SemanticErrorContext::Identifier(param.name)
+                node,
+                ErrorInfo::Identifier(param.name)
             );
         }
         
-        auto paramInfo = std::make_unique<SymbolInfo>(
-            param.name,
-            param.type,
-            SymbolKind::VARIABLE,
-            false
-        );
-        currentScope->addSymbol(param.name, std::move(paramInfo));
-    }
-    
-    // Analyze function body
-    analyzeBlock(node->bodyItems, false);
-    
-    // Check if function has return on all paths (if not void/IOTA)
-    if (currentFunctionReturnType != DataType::IOTA) {
-        if (!checkPathsReturn(node->bodyItems)) {
-            throw SemanticException(
-                SemanticErrorType::MISSING_RETURN,
-                SemanticErrorContext::Function(node->name)
-            );
-        }
+        ALLOC_SITE(SYMBOL);
+        currentScope->addSymbol(param.name, param.type, SymbolKind::VARIABLE, false);
     }
-    
-    // Restore context
-    currentFunction = previousFunction;
-    currentFunctionReturnType = previousReturnType;
-    hasReturn = previousHasReturn;
-    isUnreachable = previousUnreachable;
-    currentScope = parentScope;
+    return true;
 }
 
 // Analyze variable declaration
-void SemanticAnalyzer::analyzeVarDecl(VarDeclNode* node) {
+bool SemanticAnalyzer::analyzeVarDecl(VarDeclNode* node) {
     if (isUnreachable) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::UNREACHABLE_CODE,
-            SemanticErrorContext()
+            node,
+            ErrorInfo()
         );
     }
     
     // Check if identifier already declared in current scope
-    if (currentScope->existsLocal(node->name)) {
+    const SymbolInfo* existing = currentScope->lookupLocal(node->name);
+    if (!existing && globalTable && currentScope == scopes.global()) {
+        existing = globalTable->find(node->name);
+    }
+    if (existing) {
         // Check what kind of symbol it is
-        SymbolInfo* existing = currentScope->lookupLocal(node->name);
-        if (existing && existing->kind == SymbolKind::FUNCTION) {
+        if (existing->kind == SymbolKind::FUNCTION) {
             // Trying to redeclare a function as a variable
-            throw SemanticException(
+            return fail(
                 SemanticErrorType::REDECLARED_FUNCTION,
-                SemanticErrorContext::Function(node->name)
+                node,
+                ErrorInfo::Function(node->name)
             );
         } else {
             // Redeclaring a variable or constant
-            throw SemanticException(
+            return fail(
                 SemanticErrorType::REDECLARED_IDENTIFIER,
-                SemanticErrorContext::Identifier(node->name)
+                node,
+                ErrorInfo::Identifier(node->name)
             );
         }
     }
@@ -212,13 +331,15 @@ void SemanticAnalyzer::analyzeVarDecl(VarDeclNode* node) {
     
     // Check initializer type if present
     if (node->initializer) {
-        DataType initType = analyzeExpr(node->initializer);
+        DataType initType;
+        if (!analyzeExpr(node->initializer, initType)) return false;
         
         // Use assignment compatibility rules from spec section 2.2
         if (!isAssignmentCompatible(declaredType, initType)) {
-            throw SemanticException(
+            return fail(
                 SemanticErrorType::VAR_DECL_TYPE_MISMATCH,
-                SemanticErrorContext::IdentifierTypeMismatch(
+                node,
+                ErrorInfo::IdentifierTypeMismatch(
                     node->name, declaredType, initType
                 )
             );
@@ -226,112 +347,121 @@ void SemanticAnalyzer::analyzeVarDecl(VarDeclNode* node) {
     }
     
     // Add variable to symbol table
-    auto varInfo = std::make_unique<SymbolInfo>(
-        node->name,
-        declaredType,
-        SymbolKind::VARIABLE,
-        node->isConstant
-    );
-    currentScope->addSymbol(node->name, std::move(varInfo));
+    ALLOC_SITE(SYMBOL);
+    currentScope->addSymbol(node->name, declaredType, SymbolKind::VARIABLE, node->isConstant);
+    return true;
 }
 
 // Analyze statement
-void SemanticAnalyzer::analyzeStmt(StmtNode* node) {
+bool SemanticAnalyzer::analyzeStmt(StmtNode* node) {
     if (AssignmentStmtNode* assign = dynamic_cast<AssignmentStmtNode*>(node)) {
-        analyzeAssignment(assign);
+        return analyzeAssignment(assign);
     } else if (ReturnStmtNode* ret = dynamic_cast<ReturnStmtNode*>(node)) {
-        analyzeReturn(ret);
+        return analyzeReturn(ret);
     } else if (PrintStmtNode* print = dynamic_cast<PrintStmtNode*>(node)) {
-        analyzePrint(print);
+        return analyzePrint(print);
     } else if (IfStmtNode* ifStmt = dynamic_cast<IfStmtNode*>(node)) {
-        analyzeIf(ifStmt);
+        return analyzeIf(ifStmt);
     } else if (WhileStmtNode* whileStmt = dynamic_cast<WhileStmtNode*>(node)) {
-        analyzeWhile(whileStmt);
+        return analyzeWhile(whileStmt);
     }
+    return true;
 }
 
 // Analyze assignment
-void SemanticAnalyzer::analyzeAssignment(AssignmentStmtNode* node) {
+bool SemanticAnalyzer::analyzeAssignment(AssignmentStmtNode* node) {
     if (isUnreachable) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::UNREACHABLE_CODE,
-            SemanticErrorContext()
+            node,
+            ErrorInfo()
         );
     }
     
     // Check if variable exists
-    SymbolInfo* symbol = currentScope->lookup(node->variableName);
+    const SymbolInfo* symbol = lookup(node->variableName);
     
     if (!symbol) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::UNDECLARED_IDENTIFIER,
-            SemanticErrorContext::Identifier(node->variableName)
+            node,
+            ErrorInfo::Identifier(node->variableName)
         );
     }
     
     // Check if it's a function
     if (symbol->kind == SymbolKind::FUNCTION) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::FUNCTION_USED_AS_VARIABLE,
-            SemanticErrorContext::Function(node->variableName)
+            node,
+            ErrorInfo::Function(node->variableName)
         );
     }
     
     // Check if trying to assign to constant
     if (symbol->isConstant) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::VAR_ASSIGN_TO_CONSTANT,
-            SemanticErrorContext::Identifier(node->variableName)
+            node,
+            ErrorInfo::Identifier(node->variableName)
         );
     }
     
-    DataType valueType = analyzeExpr(node->value);
+    DataType valueType;
+    if (!analyzeExpr(node->value, valueType)) return false;
     
     // Use assignment compatibility rules from spec section 2.2
     if (!isAssignmentCompatible(symbol->type, valueType)) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::VAR_ASSIGN_TYPE_MISMATCH,
-            SemanticErrorContext::IdentifierTypeMismatch(
+            node,
+            ErrorInfo::IdentifierTypeMismatch(
                 node->variableName, symbol->type, valueType
             )
         );
     }
+    return true;
 }
 
 // Analyze return statement
-void SemanticAnalyzer::analyzeReturn(ReturnStmtNode* node) {
+bool SemanticAnalyzer::analyzeReturn(ReturnStmtNode* node) {
     if (isUnreachable) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::UNREACHABLE_CODE,
-            SemanticErrorContext()
+            node,
+            ErrorInfo()
         );
     }
     
-    if (currentFunction.empty()) {
-        throw SemanticException(
+    if (!currentFunction) {
+        return fail(
             SemanticErrorType::RETURN_OUTSIDE_FUNCTION,
-            SemanticErrorContext()
+            node,
+            ErrorInfo()
         );
     }
     
     if (node->value) {
-        DataType returnType = analyzeExpr(node->value);
+        DataType returnType;
+        if (!analyzeExpr(node->value, returnType)) return false;
         
         // Use assignment compatibility rules from spec section 2.2
         if (!isAssignmentCompatible(currentFunctionReturnType, returnType)) {
-            throw SemanticException(
+            return fail(
                 SemanticErrorType::RETURN_TYPE_MISMATCH,
-                SemanticErrorContext::ReturnTypeMismatch(
-                    currentFunction, currentFunctionReturnType, returnType
+                node,
+                ErrorInfo::ReturnTypeMismatch(
+                    currentFunction->name, currentFunctionReturnType, returnType
                 )
             );
         }
     } else {
         if (currentFunctionReturnType != DataType::IOTA) {
-            throw SemanticException(
+            return fail(
                 SemanticErrorType::RETURN_TYPE_MISMATCH,
-                SemanticErrorContext::ReturnTypeMismatch(
-                    currentFunction, currentFunctionReturnType, DataType::IOTA
+                node,
+                ErrorInfo::ReturnTypeMismatch(
+                    currentFunction->name, currentFunctionReturnType, DataType::IOTA
                 )
             );
         }
@@ -339,326 +469,564 @@ void SemanticAnalyzer::analyzeReturn(ReturnStmtNode* node) {
     
     hasReturn = true;
     isUnreachable = true;
+    return true;
 }
 
 // Analyze print statement
-void SemanticAnalyzer::analyzePrint(PrintStmtNode* node) {
+bool SemanticAnalyzer::analyzePrint(PrintStmtNode* node) {
     if (isUnreachable) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::UNREACHABLE_CODE,
-            SemanticErrorContext()
+            node,
+            ErrorInfo()
         );
     }
     
-    analyzeExpr(node->expression);
+    DataType type;
+    return analyzeExpr(node->expression, type);
 }
 
 // Analyze if statement
-void SemanticAnalyzer::analyzeIf(IfStmtNode* node) {
+bool SemanticAnalyzer::analyzeIf(IfStmtNode* node) {
+    size_t depth = blocks.size();
+    return enterIf(node) && runBlocks(depth);
+}
+
+bool SemanticAnalyzer::enterIf(IfStmtNode* node) {
     if (isUnreachable) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::UNREACHABLE_CODE,
-            SemanticErrorContext()
+            node,
+            ErrorInfo()
         );
     }
     
-    DataType condType = analyzeExpr(node->condition);
+    DataType condType;
+    if (!analyzeExpr(node->condition, condType)) return false;
     
     if (condType != DataType::BOOL) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::CONDITION_NOT_BOOL,
-            SemanticErrorContext::ActualType(condType)
+            node,
+            ErrorInfo::ActualType(condType)
         );
     }
     
     bool prevUnreachable = isUnreachable;
-    
-    analyzeBlock(node->thenItems, true);
-    bool thenUnreachable = isUnreachable;
-    
-    isUnreachable = prevUnreachable;
-    
-    if (!node->elseItems.empty()) {
-        analyzeBlock(node->elseItems, true);
-        bool elseUnreachable = isUnreachable;
-        
-        if (thenUnreachable && elseUnreachable) {
-            isUnreachable = true;
-        } else {
-            isUnreachable = prevUnreachable;
-        }
-    } else {
-        isUnreachable = prevUnreachable;
-    }
+    pushBlock(node->thenItems, node, BlockOwner::IF_THEN, true).savedUnreachable = prevUnreachable;
+    return true;
 }
 
 // Analyze while statement
-void SemanticAnalyzer::analyzeWhile(WhileStmtNode* node) {
+bool SemanticAnalyzer::analyzeWhile(WhileStmtNode* node) {
+    size_t depth = blocks.size();
+    return enterWhile(node) && runBlocks(depth);
+}
+
+bool SemanticAnalyzer::enterWhile(WhileStmtNode* node) {
     if (isUnreachable) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::UNREACHABLE_CODE,
-            SemanticErrorContext()
+            node,
+            ErrorInfo()
         );
     }
     
-    DataType condType = analyzeExpr(node->condition);
+    DataType condType;
+    if (!analyzeExpr(node->condition, condType)) return false;
     
     if (condType != DataType::BOOL) {
-        throw SemanticException(
+        return fail(
             SemanticErrorType::CONDITION_NOT_BOOL,
-            SemanticErrorContext::ActualType(condType)
+            node,
+            ErrorInfo::ActualType(condType)
         );
     }
     
     bool prevUnreachable = isUnreachable;
-    analyzeBlock(node->bodyItems, true);
-    isUnreachable = prevUnreachable;
+    pushBlock(node->bodyItems, node, BlockOwner::WHILE, true).savedUnreachable = prevUnreachable;
+    return true;
 }
 
 // Analyze block
-void SemanticAnalyzer::analyzeBlock(const std::vector<ASTNode*>& block, bool createNewScope) {
-    auto parentScope = currentScope;
+bool SemanticAnalyzer::analyzeBlock(const std::vector<ASTNode*>& block, bool createNewScope) {
+    size_t depth = blocks.size();
+    pushBlock(block, nullptr, BlockOwner::BLOCK, createNewScope);
+    return runBlocks(depth);
+}
+
+SemanticAnalyzer::BlockFrame& SemanticAnalyzer::pushBlock(const std::vector<ASTNode*>& items, ASTNode* owner,
+                                                          BlockOwner ownerKind, bool createNewScope) {
+    blocks.emplace_back();
+    BlockFrame& frame = blocks.back();
+    frame.items = &items;
+    frame.next = 0;
+    frame.owner = owner;
+    frame.ownerKind = ownerKind;
+    frame.newScope = createNewScope;
+    frame.blockUnreachable = false;
+    frame.savedUnreachable = false;
+    frame.thenUnreachable = false;
     
     if (createNewScope) {
-        currentScope = std::make_shared<Scope>(parentScope);
+        ALLOC_SITE(SCOPE);
+        currentScope = scopes.push();
     }
-    
-    bool blockUnreachable = false;
-    
-    for (size_t i = 0; i < block.size(); ++i) {
-        auto item = block[i];
+    return frame;
+}
+
+// Analyze items of the innermost open block until the stack is back at
+// `depth`. Nested bodies are pushed by the enter* functions and finished by
+// leaveBlock, never analyzed by recursion.
+bool SemanticAnalyzer::runBlocks(size_t depth) {
+    while (blocks.size() > depth) {
+        BlockFrame& frame = blocks.back();
+        if (frame.next == frame.items->size()) {
+            if (!leaveBlock()) return false;
+            continue;
+        }
+        ASTNode* item = (*frame.items)[frame.next++];
         
-        if (blockUnreachable) {
-            throw SemanticException(
+        if (frame.blockUnreachable) {
+            return fail(
                 SemanticErrorType::UNREACHABLE_CODE,
-                SemanticErrorContext()
+                item,
+                ErrorInfo()
             );
         }
         
-        if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(item)) {
-            analyzeFunctionDecl(funcDecl);
+        // `frame` is invalid once an enter* call has pushed a block. Each
+        // failed dynamic_cast costs, so the common items are tried first.
+        bool ok = true;
+        if (AssignmentStmtNode* assign = dynamic_cast<AssignmentStmtNode*>(item)) {
+            ok = analyzeAssignment(assign);
         } else if (VarDeclNode* varDecl = dynamic_cast<VarDeclNode*>(item)) {
-            analyzeVarDecl(varDecl);
+            ok = analyzeVarDecl(varDecl);
+        } else if (IfStmtNode* ifStmt = dynamic_cast<IfStmtNode*>(item)) {
+            ok = enterIf(ifStmt);
+        } else if (WhileStmtNode* whileStmt = dynamic_cast<WhileStmtNode*>(item)) {
+            ok = enterWhile(whileStmt);
+        } else if (ReturnStmtNode* ret = dynamic_cast<ReturnStmtNode*>(item)) {
+            // Anything after a return in the same block is unreachable
+            ok = analyzeReturn(ret);
+            frame.blockUnreachable = true;
+            isUnreachable = true;
+        } else if (FunctionDeclNode* funcDecl = dynamic_cast<FunctionDeclNode*>(item)) {
+            ok = enterFunctionDecl(funcDecl);
         } else if (StmtNode* stmt = dynamic_cast<StmtNode*>(item)) {
-            analyzeStmt(stmt);
-            if (isTerminator(stmt)) {
-                blockUnreachable = true;
-                isUnreachable = true;
+            ok = analyzeStmt(stmt);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Finish the innermost block on behalf of its owner, then pop it
+bool SemanticAnalyzer::leaveBlock() {
+    BlockFrame& frame = blocks.back();
+    
+    switch (frame.ownerKind) {
+        case BlockOwner::BLOCK:
+            break;
+        
+        case BlockOwner::FUNCTION: {
+            // Check if function has return on all paths (if not void/IOTA).
+            // The body leaves isUnreachable set exactly when every path
+            // through it ends in a return: directly, or via an if/else whose
+            // branches both do. Loops and nested functions restore the flag.
+            if (currentFunctionReturnType != DataType::IOTA && !isUnreachable) {
+                return fail(
+                    SemanticErrorType::MISSING_RETURN,
+                    frame.owner,
+                    ErrorInfo::Function(static_cast<FunctionDeclNode*>(frame.owner)->name)
+                );
+            }
+            
+            // Restore context
+            currentFunction = frame.savedFunction;
+            currentFunctionReturnType = frame.savedReturnType;
+            hasReturn = frame.savedHasReturn;
+            isUnreachable = frame.savedUnreachable;
+            break;
+        }
+        
+        case BlockOwner::IF_THEN: {
+            IfStmtNode* node = static_cast<IfStmtNode*>(frame.owner);
+            bool thenUnreachable = isUnreachable;
+            bool prevUnreachable = frame.savedUnreachable;
+            isUnreachable = prevUnreachable;
+            currentScope = scopes.pop();
+            blocks.pop_back();
+            
+            if (!node->elseItems.empty()) {
+                BlockFrame& elseFrame = pushBlock(node->elseItems, node, BlockOwner::IF_ELSE, true);
+                elseFrame.savedUnreachable = prevUnreachable;
+                elseFrame.thenUnreachable = thenUnreachable;
             }
+            return true;
         }
+        
+        case BlockOwner::IF_ELSE:
+            if (frame.thenUnreachable && isUnreachable) {
+                isUnreachable = true;
+            } else {
+                isUnreachable = frame.savedUnreachable;
+            }
+            break;
+        
+        case BlockOwner::WHILE:
+            isUnreachable = frame.savedUnreachable;
+            break;
     }
     
-    if (createNewScope) {
-        currentScope = parentScope;
+    if (frame.newScope) {
+        currentScope = scopes.pop();
+    }
+    blocks.pop_back();
+    return true;
+}
+
+// Analyze expression and record the computed type on every node, so later
+// passes (constant folding, bytecode lowering) can use it without re-checking.
+// Finished operand types collect on exprTypes. Shallow expressions recurse
+// (typeExpr), which is the faster way through the usual tree; below
+// kMaxExprRecursion levels, operators and calls wait on exprFrames instead,
+// so a million-deep `+` chain needs heap, not call stack.
+bool SemanticAnalyzer::analyzeExpr(ExprNode* expr, DataType& type) {
+    // A previous expression may have failed halfway through
+    exprFrames.clear();
+    exprTypes.clear();
+    
+    if (!typeExpr(expr, 0)) return false;
+    type = exprTypes.back();
+    return true;
+}
+
+// Push the type of `expr`, `depth` operators below the root. Its operator or
+// call frame stays on the call stack unless that is already deep.
+bool SemanticAnalyzer::typeExpr(ExprNode* expr, unsigned depth) {
+    size_t base = exprFrames.size();
+    if (!pushExpr(expr)) return false;
+    if (exprFrames.size() == base) return true;  // a leaf
+    if (depth >= kMaxExprRecursion) return runExprFrames(base);
+    
+    ExprFrame frame = exprFrames.back();
+    exprFrames.pop_back();
+    while (true) {
+        ExprNode* operand;
+        if (!nextOperand(frame, operand)) return false;
+        if (!operand) break;
+        ++frame.operands;
+        if (!typeExpr(operand, depth + 1)) return false;
+    }
+    return finishExpr(frame);
+}
+
+// Analyze operands of the innermost open frames until exprFrames is back at
+// `depth`
+bool SemanticAnalyzer::runExprFrames(size_t depth) {
+    while (exprFrames.size() > depth) {
+        ExprFrame& frame = exprFrames.back();
+        ExprNode* operand;
+        if (!nextOperand(frame, operand)) return false;
+        if (operand) {
+            ++frame.operands;
+            if (!pushExpr(operand)) return false;  // invalidates `frame`
+            continue;
+        }
+        
+        if (!finishExpr(frame)) return false;
+        exprFrames.pop_back();
     }
+    return true;
+}
+
+// Replace a finished frame's operand types with its own
+bool SemanticAnalyzer::finishExpr(const ExprFrame& frame) {
+    size_t first = exprTypes.size() - frame.operands;
+    DataType result;
+    if (!operatorType(frame, exprTypes.data() + first, result)) return false;
+    frame.node->dataType = result;
+    exprTypes.resize(first + 1);
+    exprTypes[first] = result;
+    return true;
 }
 
-// Analyze expression
-DataType SemanticAnalyzer::analyzeExpr(ExprNode* expr) {
-    if (dynamic_cast<IntegerNode*>(expr)) {
-        return DataType::INT;
+// Type a leaf on the spot, or open a frame for an operator or call. One
+// dynamic_cast ladder per node, most common node types first.
+bool SemanticAnalyzer::pushExpr(ExprNode* expr) {
+    DataType type;
+    if (IdentifierNode* idNode = dynamic_cast<IdentifierNode*>(expr)) {
+        if (!identifierType(idNode, type)) return false;
+    }
+    else if (dynamic_cast<IntegerNode*>(expr)) {
+        type = DataType::INT;
+    }
+    else if (dynamic_cast<BinaryOpNode*>(expr)) {
+        exprFrames.push_back(ExprFrame{expr, ExprKind::BINARY, 0, nullptr});
+        return true;
+    }
+    else if (dynamic_cast<FunctionCallNode*>(expr)) {
+        exprFrames.push_back(ExprFrame{expr, ExprKind::CALL, 0, nullptr});
+        return true;
     }
     else if (dynamic_cast<FloatNode*>(expr)) {
-        return DataType::FLOAT;
+        type = DataType::FLOAT;
     }
     else if (dynamic_cast<BoolNode*>(expr)) {
-        return DataType::BOOL;
+        type = DataType::BOOL;
+    }
+    else if (dynamic_cast<UnaryOpNode*>(expr)) {
+        exprFrames.push_back(ExprFrame{expr, ExprKind::UNARY, 0, nullptr});
+        return true;
+    }
+    else {
+        type = DataType::IOTA;
     }
-    else if (IdentifierNode* idNode = dynamic_cast<IdentifierNode*>(expr)) {
-        SymbolInfo* symbol = currentScope->lookup(idNode->name);
+    expr->dataType = type;
+    exprTypes.push_back(type);
+    return true;
+}
+
+// Set `operand` to the operand to analyze next, or nullptr once all are
+// done. Called once on entry and once after each operand finishes, which is
+// where a call checks its callee and then each argument as it completes.
+bool SemanticAnalyzer::nextOperand(ExprFrame& frame, ExprNode*& operand) {
+    operand = nullptr;
+    switch (frame.kind) {
+        case ExprKind::BINARY: {
+            BinaryOpNode* binOp = static_cast<BinaryOpNode*>(frame.node);
+            if (frame.operands == 0) operand = binOp->left;
+            if (frame.operands == 1) operand = binOp->right;
+            return true;
+        }
+        
+        case ExprKind::UNARY:
+            if (frame.operands == 0) operand = static_cast<UnaryOpNode*>(frame.node)->operand;
+            return true;
+        
+        case ExprKind::CALL:
+            break;
+    }
+    
+    FunctionCallNode* callNode = static_cast<FunctionCallNode*>(frame.node);
+    if (frame.operands == 0) {
+        const SymbolInfo* symbol = lookup(callNode->functionName);
         
         if (!symbol) {
-            throw SemanticException(
-                SemanticErrorType::UNDECLARED_IDENTIFIER,
-                SemanticErrorContext::Identifier(idNode->name)
+            return fail(
+                SemanticErrorType::UNDECLARED_FUNCTION,
+                callNode,
+                ErrorInfo::Function(callNode->functionName)
             );
         }
         
-        if (symbol->kind == SymbolKind::FUNCTION) {
-            throw SemanticException(
-                SemanticErrorType::FUNCTION_USED_AS_VARIABLE,
-                SemanticErrorContext::Function(idNode->name)
+        if (symbol->kind != SymbolKind::FUNCTION) {
+            return fail(
+                SemanticErrorType::NOT_A_FUNCTION,
+                callNode,
+                ErrorInfo::Identifier(callNode->functionName)
             );
         }
         
-        return symbol->type;
+        // Check argument count
+        FunctionSignature callee = signature(*symbol);
+        if (callNode->arguments.size() != callee.paramCount) {
+            return fail(
+                SemanticErrorType::WRONG_NUMBER_OF_ARGUMENTS,
+                callNode,
+                ErrorInfo::ArgCount(
+                    callNode->functionName,
+                    callee.paramCount,
+                    callNode->arguments.size()
+                )
+            );
+        }
+        frame.callee = symbol;
+    } else {
+        // Each argument type must be assignment-compatible with its parameter
+        // type - spec section 2.3
+        size_t i = frame.operands - 1;
+        DataType argType = exprTypes.back();
+        FunctionSignature callee = signature(*frame.callee);
+        if (!isAssignmentCompatible(callee.paramTypes[i], argType)) {
+            ALLOC_SITE(CALL_CHECK);
+            return fail(
+                SemanticErrorType::INVALID_SIGNATURE,
+                callNode,
+                ErrorInfo::Signature(
+                    callNode->functionName,
+                    callee,
+                    exprTypes.data() + exprTypes.size() - frame.operands,
+                    frame.operands
+                )
+            );
+        }
+    }
+    
+    if (frame.operands < callNode->arguments.size()) {
+        operand = callNode->arguments[frame.operands];
+    }
+    return true;
+}
+
+const SymbolInfo* SemanticAnalyzer::lookup(const std::string& name) {
+    if (!globalTable) {
+        return currentScope->lookup(name);
+    }
+    // The shared table is searched, and counted, as the scope outside the
+    // global one
+    return currentScope->lookup(name, [this](const std::string& key) {
+        return globalTable->find(key);
+    });
+}
+
+// Type of a variable reference
+bool SemanticAnalyzer::identifierType(IdentifierNode* idNode, DataType& type) {
+    const SymbolInfo* symbol = lookup(idNode->name);
+    
+    if (!symbol) {
+        return fail(
+            SemanticErrorType::UNDECLARED_IDENTIFIER,
+            idNode,
+            ErrorInfo::Identifier(idNode->name)
+        );
     }
-    else if (BinaryOpNode* binOp = dynamic_cast<BinaryOpNode*>(expr)) {
-        DataType leftType = analyzeExpr(binOp->left);
-        DataType rightType = analyzeExpr(binOp->right);
+    
+    if (symbol->kind == SymbolKind::FUNCTION) {
+        return fail(
+            SemanticErrorType::FUNCTION_USED_AS_VARIABLE,
+            idNode,
+            ErrorInfo::Function(idNode->name)
+        );
+    }
+    
+    type = symbol->type;
+    return true;
+}
+
+// Type of an operator or call from its finished operand types
+bool SemanticAnalyzer::operatorType(const ExprFrame& frame, const DataType* operandTypes, DataType& type) {
+    if (frame.kind == ExprKind::BINARY) {
+        BinaryOpNode* binOp = static_cast<BinaryOpNode*>(frame.node);
+        DataType leftType = operandTypes[0];
+        DataType rightType = operandTypes[1];
         
         if (binOp->op == "+" || binOp->op == "-" || binOp->op == "*" || binOp->op == "/") {
             // Arithmetic operations - both operands must be numeric
             // Per spec section 2.1.B: Any operand is BOOL is an error
             if (!isNumericType(leftType) || !isNumericType(rightType)) {
-                throw SemanticException(
+                return fail(
                     SemanticErrorType::INVALID_BINARY_OPERATION,
-                    SemanticErrorContext::InvalidOperationBetweenTypes(
+                    binOp,
+                    ErrorInfo::InvalidOperationBetweenTypes(
                         binOp->op, leftType, rightType
                     )
                 );
             }
             // Result is FLOAT if either operand is FLOAT, otherwise INT
             if (leftType == DataType::FLOAT || rightType == DataType::FLOAT) {
-                return DataType::FLOAT;
+                type = DataType::FLOAT;
+                return true;
             }
-            return DataType::INT;
+            type = DataType::INT;
+            return true;
         }
         else if (binOp->op == "<" || binOp->op == ">" || binOp->op == "<=" || binOp->op == ">=") {
             // Comparison operators - both operands must be numeric (INT or FLOAT)
             // Per spec section 2.1.B: Comparison between BOOL and numeric is an error
             if (!isNumericType(leftType) || !isNumericType(rightType)) {
-                throw SemanticException(
+                return fail(
                     SemanticErrorType::INVALID_BINARY_OPERATION,
-                    SemanticErrorContext::InvalidOperationBetweenTypes(
+                    binOp,
+                    ErrorInfo::InvalidOperationBetweenTypes(
                         binOp->op, leftType, rightType
                     )
                 );
             }
-            return DataType::BOOL;
+            type = DataType::BOOL;
+            return true;
         }
         else if (binOp->op == "==" || binOp->op == "!=") {
             // Equality operators - both operands must be of the same type
             // Per spec section 2.1.B: Both must be same type (e.g., BOOL == BOOL)
             if (leftType != rightType) {
-                throw SemanticException(
+                return fail(
                     SemanticErrorType::INVALID_BINARY_OPERATION,
-                    SemanticErrorContext::InvalidOperationBetweenTypes(
+                    binOp,
+                    ErrorInfo::InvalidOperationBetweenTypes(
                         binOp->op, leftType, rightType
                     )
                 );
             }
-            return DataType::BOOL;
+            type = DataType::BOOL;
+            return true;
         }
     }
-    else if (UnaryOpNode* unOp = dynamic_cast<UnaryOpNode*>(expr)) {
-        DataType operandType = analyzeExpr(unOp->operand);
+    else if (frame.kind == ExprKind::UNARY) {
+        UnaryOpNode* unOp = static_cast<UnaryOpNode*>(frame.node);
+        DataType operandType = operandTypes[0];
         
         if (unOp->op == "-") {
             // Per spec section 2.1.A: Unary minus requires numeric operand
             if (!isNumericType(operandType)) {
-                throw SemanticException(
+                return fail(
                     SemanticErrorType::INVALID_UNARY_OPERATION,
-                    SemanticErrorContext::ActualType(operandType)
+                    unOp,
+                    ErrorInfo::ActualType(operandType)
                 );
             }
-            return operandType;
+            type = operandType;
+            return true;
         }
     }
-    else if (FunctionCallNode* callNode = dynamic_cast<FunctionCallNode*>(expr)) {
-        SymbolInfo* symbol = currentScope->lookup(callNode->functionName);
-        
-        if (!symbol) {
-            throw SemanticException(
-                SemanticErrorType::UNDECLARED_FUNCTION,
-                SemanticErrorContext::Function(callNode->functionName)
-            );
-        }
-        
-        if (symbol->kind != SymbolKind::FUNCTION) {
-            throw SemanticException(
-                SemanticErrorType::NOT_A_FUNCTION,
-                SemanticErrorContext::Identifier(callNode->functionName)
-            );
-        }
-        
-        // Check argument count
-        if (callNode->arguments.size() != symbol->paramTypes.size()) {
-            throw SemanticException(
-                SemanticErrorType::WRONG_NUMBER_OF_ARGUMENTS,
-                SemanticErrorContext::ArgCount(
-                    callNode->functionName,
-                    symbol->paramTypes.size(),
-                    callNode->arguments.size()
-                )
-            );
-        }
-        
-        // Check argument types - use assignment compatibility per spec section 2.3
-        std::vector<DataType> actualTypes;
-        for (size_t i = 0; i < callNode->arguments.size(); ++i) {
-            DataType argType = analyzeExpr(callNode->arguments[i]);
-            actualTypes.push_back(argType);
-            
-            // Each argument type must be assignment-compatible with parameter type
-            if (!isAssignmentCompatible(symbol->paramTypes[i], argType)) {
-                throw SemanticException(
-                    SemanticErrorType::INVALID_SIGNATURE,
-                    SemanticErrorContext::Signature(
-                        callNode->functionName,
-                        symbol->paramTypes,
-                        actualTypes
-                    )
-                );
-            }
-        }
-        
-        return symbol->returnType;
+    else if (frame.kind == ExprKind::CALL) {
+        // Arguments were checked one by one in nextOperand
+        type = signature(*frame.callee).returnType;
+        return true;
     }
     
-    return DataType::IOTA;
+    type = DataType::IOTA;
+    return true;
 }
 
-// Check if all paths in block return
-bool SemanticAnalyzer::checkPathsReturn(const std::vector<ASTNode*>& block) {
-    for (auto item : block) {
-        if (dynamic_cast<ReturnStmtNode*>(item)) {
-            return true;
-        }
-        
-        if (IfStmtNode* ifStmt = dynamic_cast<IfStmtNode*>(item)) {
-            if (!ifStmt->elseItems.empty()) {
-                bool thenReturns = checkPathsReturn(ifStmt->thenItems);
-                bool elseReturns = checkPathsReturn(ifStmt->elseItems);
-                if (thenReturns && elseReturns) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
-}
-
-// Check if statement is a terminator
-bool SemanticAnalyzer::isTerminator(ASTNode* node) {
-    return dynamic_cast<ReturnStmtNode*>(node) != nullptr;
-}
-
-
 void SemanticAnalyzer::visit(PrintStmtNode* node) {
     // Analyze the expression being printed
     if (node->expression) {
-        analyzeExpr(node->expression);
+        DataType type;
+        throwIfFailed(analyzeExpr(node->expression, type));
     }
 }
 
 void SemanticAnalyzer::visit(IfStmtNode* node) {
-    analyzeIf(node);
+    throwIfFailed(analyzeIf(node));
 }
 
 void SemanticAnalyzer::visit(WhileStmtNode* node) {
-    analyzeWhile(node);
+    throwIfFailed(analyzeWhile(node));
 }
 
 void SemanticAnalyzer::visit(AssignmentStmtNode* node) {
-    analyzeAssignment(node);
+    throwIfFailed(analyzeAssignment(node));
 }
 
 void SemanticAnalyzer::visit(ReturnStmtNode* node) {
-    analyzeReturn(node);
+    throwIfFailed(analyzeReturn(node));
 }
 
 // Stub implementations for nodes that shouldn't be encountered or need forwarding
 void SemanticAnalyzer::visit(ProgramNode* node) {
-    analyzeProgram(node);
+    throwIfFailed(analyzeProgram(node));
 }
 
 void SemanticAnalyzer::visit(FunctionDeclNode* node) {
-    analyzeFunctionDecl(node);
+    throwIfFailed(analyzeFunctionDecl(node));
 }
 
 void SemanticAnalyzer::visit(VarDeclNode* node) {
-    analyzeVarDecl(node);
+    throwIfFailed(analyzeVarDecl(node));
 }
 
 void SemanticAnalyzer::visit(BlockNode* node) {
@@ -668,7 +1036,7 @@ void SemanticAnalyzer::visit(BlockNode* node) {
     for (auto item : node->items) {
         items.push_back(item);
     }
-    analyzeBlock(items, false);
+    throwIfFailed(analyzeBlock(items, false));
 }
 
 void SemanticAnalyzer::visit(IfNode* node) {
@@ -702,15 +1070,18 @@ void SemanticAnalyzer::visit(AssignmentNode* node) {
 }
 
 void SemanticAnalyzer::visit(ExprStmtNode* node) {
-    analyzeExpr(node->expression);
+    DataType type;
+    throwIfFailed(analyzeExpr(node->expression, type));
 }
 
 void SemanticAnalyzer::visit(BinaryOpNode* node) {
-    analyzeExpr(node);
+    DataType type;
+    throwIfFailed(analyzeExpr(node, type));
 }
 
 void SemanticAnalyzer::visit(UnaryOpNode* node) {
-    analyzeExpr(node);
+    DataType type;
+    throwIfFailed(analyzeExpr(node, type));
 }
 
 void SemanticAnalyzer::visit(LiteralNode* node) {
@@ -724,5 +1095,6 @@ void SemanticAnalyzer::visit(IdentifierNode* node) {
 }
 
 void SemanticAnalyzer::visit(FunctionCallNode* node) {
-    analyzeExpr(node);
+    DataType type;
+    throwIfFailed(analyzeExpr(node, type));
 }
\ No newline at end of file
@@ -5,48 +5,189 @@
 #include "visitor.hpp"
 #include "exception.hpp"
 #include "data_type.hpp"
+#include "global_symbols.hpp"
+#include "signature_pool.hpp"
+#include "stats.hpp"
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
+// The values a SemanticErrorContext was built from, kept as fields for
+// machine-readable diagnostics. Fields that do not apply to the error type
+// stay empty or -1.
+struct SemanticErrorDetail {
+    std::string name;                   // identifier, function or operator
+    std::vector<DataType> expected;     // declared, return or parameter types
+    std::vector<DataType> found;        // what the program used instead
+    long expectedCount = -1;            // WRONG_NUMBER_OF_ARGUMENTS only
+    long foundCount = -1;
+};
+
+// A rejected program: the arguments analyze() throws SemanticException
+// with, plus where analysis stopped and the context as fields
+struct SemanticError {
+    SemanticErrorType type;
+    SemanticErrorContext context;
+    const ASTNode* node = nullptr;      // its span locates the error
+    SemanticErrorDetail detail;
+};
+
 class SemanticAnalyzer : public Visitor {
  private:
     ASTNode* root;
-    std::shared_ptr<Scope> currentScope;
-    std::string currentFunction;
+    ScopeStack scopes;
+    Scope* currentScope;                    // innermost open scope
+    const FunctionDeclNode* currentFunction;  // null outside any function
     DataType currentFunctionReturnType;
     bool hasReturn;
     bool isUnreachable;
+    RunStats* stats;
+    bool shareGlobalTable;                  // see shareGlobals()
+    std::shared_ptr<const GlobalSymbolTable> globalTable;
+    SignaturePool signatures;               // of the functions in scopes
+    std::vector<DataType> paramTypes;       // scratch for the first pass
+    SemanticError error;                    // valid once a step returned false
+    
+    // What the statement that owns a block does once the block is finished
+    enum class BlockOwner : uint8_t { BLOCK, FUNCTION, IF_THEN, IF_ELSE, WHILE };
+    
+    // A block being analyzed. Function, if and while bodies are pushed here
+    // instead of being analyzed recursively, so nesting depth is bounded by
+    // memory rather than by the call stack.
+    struct BlockFrame {
+        const std::vector<ASTNode*>* items;
+        size_t next;                        // index of the next item
+        ASTNode* owner;
+        BlockOwner ownerKind;
+        bool newScope;                      // pop a scope on exit
+        bool blockUnreachable;
+        bool savedUnreachable;              // isUnreachable before the owner
+        bool thenUnreachable;               // IF_ELSE: the then-branch's result
+        const FunctionDeclNode* savedFunction;  // FUNCTION: the enclosing context
+        DataType savedReturnType;
+        bool savedHasReturn;
+    };
+    
+    enum class ExprKind : uint8_t { BINARY, UNARY, CALL };
+    
+    // An operator or call whose operands are still being analyzed; leaves
+    // never get a frame
+    struct ExprFrame {
+        ExprNode* node;
+        ExprKind kind;
+        size_t operands;                    // operands pushed so far
+        const SymbolInfo* callee;           // CALL only
+    };
+    
+    std::vector<BlockFrame> blocks;
+    std::vector<ExprFrame> exprFrames;
+    std::vector<DataType> exprTypes;        // finished operands, innermost last
+    
+    // Analysis steps return false after recording a semantic error with
+    // fail(), and callers pass that straight up. Only analyze() and the
+    // Visitor entry points turn it into a SemanticException, so rejecting a
+    // program costs no throw on the tryAnalyze() path.
+    bool analyzeRoot();
+    struct ErrorInfo;
+    bool fail(SemanticErrorType type, const ASTNode* node, ErrorInfo info);
+    void throwIfFailed(bool ok);
     
     // Helper methods for analysis - updated to use parser node types
-    void analyzeProgram(ProgramNode* node);
-    void analyzeFunctionDecl(FunctionDeclNode* node);
-    void analyzeVarDecl(VarDeclNode* node);
-    void analyzeStmt(StmtNode* node);
-    void analyzeAssignment(AssignmentStmtNode* node);  // Changed from AssignmentNode*
-    void analyzeReturn(ReturnStmtNode* node);          // Changed from ReturnNode*
-    void analyzePrint(PrintStmtNode* node);            // Changed from PrintNode*
-    void analyzeIf(IfStmtNode* node);                  // Changed from IfNode*
-    void analyzeWhile(WhileStmtNode* node);            // Changed from WhileNode*
-    void analyzeBlock(const std::vector<ASTNode*>& block, bool createNewScope = false);  // Changed signature
-    
-    DataType analyzeExpr(ExprNode* expr);
+    bool analyzeProgram(ProgramNode* node);
+    bool analyzeFunctionDecl(FunctionDeclNode* node);
+    bool analyzeVarDecl(VarDeclNode* node);
+    bool analyzeStmt(StmtNode* node);
+    bool analyzeAssignment(AssignmentStmtNode* node);  // Changed from AssignmentNode*
+    bool analyzeReturn(ReturnStmtNode* node);          // Changed from ReturnNode*
+    bool analyzePrint(PrintStmtNode* node);            // Changed from PrintNode*
+    bool analyzeIf(IfStmtNode* node);                  // Changed from IfNode*
+    bool analyzeWhile(WhileStmtNode* node);            // Changed from WhileNode*
+    bool analyzeBlock(const std::vector<ASTNode*>& block, bool createNewScope = false);  // Changed signature
+    
+    // Explicit-stack block traversal behind analyzeBlock/If/While/FunctionDecl
+    BlockFrame& pushBlock(const std::vector<ASTNode*>& items, ASTNode* owner,
+                          BlockOwner ownerKind, bool createNewScope);
+    bool runBlocks(size_t depth);
+    bool leaveBlock();
+    bool enterFunctionDecl(FunctionDeclNode* node);
+    bool enterIf(IfStmtNode* node);
+    bool enterWhile(WhileStmtNode* node);
+    
+    // The innermost declaration of `name`, falling back to globalTable
+    const SymbolInfo* lookup(const std::string& name);
+    
+    // Expression nesting typeExpr recurses through before it hands the rest
+    // to exprFrames
+    static constexpr unsigned kMaxExprRecursion = 64;
+    
+    bool analyzeExpr(ExprNode* expr, DataType& type);
+    bool typeExpr(ExprNode* expr, unsigned depth);
+    bool runExprFrames(size_t depth);
+    bool finishExpr(const ExprFrame& frame);
+    bool pushExpr(ExprNode* expr);
+    bool nextOperand(ExprFrame& frame, ExprNode*& operand);
+    bool identifierType(IdentifierNode* idNode, DataType& type);
+    bool operatorType(const ExprFrame& frame, const DataType* operandTypes, DataType& type);
     DataType stringToDataType(const std::string& typeStr);
     bool isNumericType(DataType type);
     bool isComparable(DataType type);
     bool isAssignmentCompatible(DataType target, DataType source);  // New: type compatibility check
     
-    bool checkPathsReturn(const std::vector<ASTNode*>& block);  // Changed signature
-    bool isTerminator(ASTNode* node);
-    
  public:
     explicit SemanticAnalyzer(ASTNode* root) 
-        : root(root), currentScope(nullptr), 
+        : root(root), currentScope(nullptr), currentFunction(nullptr),
           currentFunctionReturnType(DataType::IOTA),
-          hasReturn(false), isUnreachable(false) {}
+          hasReturn(false), isUnreachable(false), stats(nullptr), shareGlobalTable(false) {}
     
+    // Throws SemanticException for the first semantic error
     void analyze();
     
+    // Same analysis, but the first semantic error comes back as a value
+    // instead of being thrown; std::nullopt means the program is valid.
+    // A null or non-program root still throws std::runtime_error.
+    std::optional<SemanticError> tryAnalyze();
+    
+    // The error behind the last failed analyze() or Visitor entry point
+    const SemanticError& lastError() const { return error; }
+    
+    // Analyze a different tree next time. The analyzer's own stacks keep
+    // their capacity, so one analyzer can serve many programs.
+    void reset(ASTNode* newRoot) { root = newRoot; }
+    
+    // Global scope of the last analysis: every function, plus the global
+    // variables declared before any error. Null before the first analysis.
+    // With shareGlobals() on, the functions are in sharedGlobals() instead,
+    // unless the first pass failed.
+    const Scope* globals() const { return scopes.global(); }
+    
+    // From the next analyze() on, freeze the functions declared by the first
+    // pass into a GlobalSymbolTable and resolve calls through it. The table
+    // is kept as a cache: a later program that declares the same functions
+    // skips the first pass and shares it. `cached`, when given, replaces the
+    // kept table, e.g. with one built by another analyzer.
+    void shareGlobals(std::shared_ptr<const GlobalSymbolTable> cached = nullptr) {
+        shareGlobalTable = true;
+        if (cached) {
+            globalTable = std::move(cached);
+        }
+    }
+    
+    // The function table of the last analysis with shareGlobals() on; null
+    // when its first pass failed
+    const std::shared_ptr<const GlobalSymbolTable>& sharedGlobals() const { return globalTable; }
+    
+    // The return and parameter types of a function symbol from the last
+    // analysis
+    FunctionSignature signature(const SymbolInfo& function) const {
+        return globalTable ? globalTable->signatures().get(function.signature)
+                           : signatures.get(function.signature);
+    }
+    
+    // Record the declare/analyze phases and scope counters into `stats`
+    // during the next analyze(); nullptr turns collection off
+    void collectStats(RunStats* stats) { this->stats = stats; }
+    
     // Visitor interface - semantic analyzer nodes
     void visit(ProgramNode* node) override;
     void visit(FunctionDeclNode* node) override;
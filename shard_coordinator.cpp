@@ -0,0 +1,446 @@
+#include "shard_coordinator.hpp"
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Frames are a 32-bit little-endian payload length followed by the payload;
+// integers inside are little-endian too, strings are a length and bytes
+class FrameWriter {
+ private:
+    std::string bytes;
+
+ public:
+    FrameWriter() : bytes(4, '\0') {}
+
+    void u32(uint32_t value) {
+        for (int i = 0; i < 4; ++i) bytes.push_back(static_cast<char>(value >> (8 * i)));
+    }
+    void i64(int64_t value) {
+        uint64_t bits = static_cast<uint64_t>(value);
+        for (int i = 0; i < 8; ++i) bytes.push_back(static_cast<char>(bits >> (8 * i)));
+    }
+    void string(const std::string& value) {
+        u32(static_cast<uint32_t>(value.size()));
+        bytes += value;
+    }
+
+    // The finished frame, with its length filled in
+    const std::string& frame() {
+        uint32_t size = static_cast<uint32_t>(bytes.size() - 4);
+        for (int i = 0; i < 4; ++i) bytes[i] = static_cast<char>(size >> (8 * i));
+        return bytes;
+    }
+};
+
+// Reads one frame's payload; any read past the end marks it malformed
+class FrameReader {
+ private:
+    const char* data;
+    size_t size;
+    size_t pos;
+    bool bad;
+
+ public:
+    FrameReader(const char* data, size_t size) : data(data), size(size), pos(0), bad(false) {}
+
+    uint32_t u32() {
+        if (size - pos < 4) {
+            bad = true;
+            return 0;
+        }
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= uint32_t(static_cast<unsigned char>(data[pos++])) << (8 * i);
+        return value;
+    }
+    int64_t i64() {
+        if (size - pos < 8) {
+            bad = true;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value |= uint64_t(static_cast<unsigned char>(data[pos++])) << (8 * i);
+        return static_cast<int64_t>(value);
+    }
+    // An element count, checked against the bytes left at `minBytes` each
+    uint32_t count(size_t minBytes) {
+        uint32_t value = u32();
+        if (value > (size - pos) / minBytes) {
+            bad = true;
+            return 0;
+        }
+        return value;
+    }
+
+    std::string string() {
+        uint32_t length = u32();
+        if (bad || size - pos < length) {
+            bad = true;
+            return std::string();
+        }
+        std::string value(data + pos, length);
+        pos += length;
+        return value;
+    }
+
+    bool failed() const { return bad; }
+    bool ok() const { return !bad && pos == size; }
+};
+
+uint32_t frameLength(const char* header) {
+    uint32_t size = 0;
+    for (int i = 0; i < 4; ++i) size |= uint32_t(static_cast<unsigned char>(header[i])) << (8 * i);
+    return size;
+}
+
+// MSG_NOSIGNAL: a peer that died must not take this process down with SIGPIPE
+bool sendAll(int fd, const std::string& bytes) {
+    size_t sent = 0;
+    while (sent < bytes.size()) {
+        ssize_t result = send(fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t result = read(fd, data, size);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        data += result;
+        size -= static_cast<size_t>(result);
+    }
+    return true;
+}
+
+void writeTypes(FrameWriter& writer, const std::vector<DataType>& types) {
+    writer.u32(static_cast<uint32_t>(types.size()));
+    for (DataType type : types) writer.u32(static_cast<uint32_t>(type));
+}
+
+std::vector<DataType> readTypes(FrameReader& reader) {
+    std::vector<DataType> types(reader.count(4));
+    for (DataType& type : types) type = static_cast<DataType>(reader.u32());
+    return types;
+}
+
+std::string encodeResult(const ShardResult& result) {
+    FrameWriter writer;
+    writer.u32(result.index);
+    writer.u32(static_cast<uint32_t>(result.status));
+    writer.string(result.out);
+    writer.string(result.err);
+    writer.u32(static_cast<uint32_t>(result.diagnostics.size()));
+    for (const Diagnostic& diagnostic : result.diagnostics) {
+        writer.u32(static_cast<uint32_t>(diagnostic.kind));
+        writer.u32(static_cast<uint32_t>(diagnostic.semanticType));
+        writer.u32(static_cast<uint32_t>(diagnostic.span.firstLine));
+        writer.u32(static_cast<uint32_t>(diagnostic.span.firstColumn));
+        writer.u32(static_cast<uint32_t>(diagnostic.span.lastLine));
+        writer.u32(static_cast<uint32_t>(diagnostic.span.lastColumn));
+        writer.string(diagnostic.message);
+        writer.string(diagnostic.detail.name);
+        writeTypes(writer, diagnostic.detail.expected);
+        writeTypes(writer, diagnostic.detail.found);
+        writer.i64(diagnostic.detail.expectedCount);
+        writer.i64(diagnostic.detail.foundCount);
+    }
+    return writer.frame();
+}
+
+bool decodeResult(const char* data, size_t size, ShardResult& result) {
+    FrameReader reader(data, size);
+    result.index = reader.u32();
+    result.status = static_cast<int>(reader.u32());
+    result.out = reader.string();
+    result.err = reader.string();
+    uint32_t count = reader.count(4);
+    for (uint32_t i = 0; i < count && !reader.failed(); ++i) {
+        Diagnostic diagnostic;
+        diagnostic.kind = static_cast<DiagnosticKind>(reader.u32());
+        diagnostic.semanticType = static_cast<SemanticErrorType>(reader.u32());
+        diagnostic.span.firstLine = static_cast<int>(reader.u32());
+        diagnostic.span.firstColumn = static_cast<int>(reader.u32());
+        diagnostic.span.lastLine = static_cast<int>(reader.u32());
+        diagnostic.span.lastColumn = static_cast<int>(reader.u32());
+        diagnostic.message = reader.string();
+        diagnostic.detail.name = reader.string();
+        diagnostic.detail.expected = readTypes(reader);
+        diagnostic.detail.found = readTypes(reader);
+        diagnostic.detail.expectedCount = static_cast<long>(reader.i64());
+        diagnostic.detail.foundCount = static_cast<long>(reader.i64());
+        result.diagnostics.push_back(std::move(diagnostic));
+    }
+    return reader.ok();
+}
+
+// A worker process: read shards until the coordinator closes the socket
+void workerLoop(int fd, const std::function<void(ShardResult&)>& process) {
+    char header[4];
+    std::string payload;
+    while (readAll(fd, header, sizeof(header))) {
+        payload.resize(frameLength(header));
+        if (!readAll(fd, &payload[0], payload.size())) {
+            return;
+        }
+        FrameReader reader(payload.data(), payload.size());
+        std::vector<uint32_t> shard(reader.count(4));
+        for (uint32_t& index : shard) index = reader.u32();
+        if (!reader.ok()) {
+            return;
+        }
+        for (uint32_t index : shard) {
+            ShardResult result;
+            result.index = index;
+            process(result);
+            if (!sendAll(fd, encodeResult(result))) {
+                return;
+            }
+        }
+    }
+}
+
+std::string describeExit(int status) {
+    if (WIFSIGNALED(status)) {
+        const char* name = strsignal(WTERMSIG(status));
+        return std::string("killed by signal ") + std::to_string(WTERMSIG(status)) +
+               (name ? std::string(" (") + name + ")" : std::string());
+    }
+    if (WIFEXITED(status)) {
+        return "exited with status " + std::to_string(WEXITSTATUS(status));
+    }
+    return "stopped unexpectedly";
+}
+
+struct WorkerProcess {
+    pid_t pid = -1;
+    int fd = -1;
+    std::string inbox;                  // bytes of incomplete frames
+    std::vector<uint32_t> shard;        // files assigned, in processing order
+    size_t reported = 0;                // results received for `shard`
+};
+
+} // namespace
+
+ShardCoordinator::ShardCoordinator(size_t fileCount, unsigned processes, size_t shardSize)
+    : fileCount(fileCount), processes(processes ? processes : 1), shardSize(shardSize),
+      crashCount(0) {
+    if (this->shardSize == 0) {
+        size_t shards = size_t(this->processes) * 4;
+        this->shardSize = (fileCount + shards - 1) / shards;
+    }
+    if (this->shardSize == 0) {
+        this->shardSize = 1;
+    }
+}
+
+bool ShardCoordinator::run(const std::function<void(ShardResult&)>& process,
+                           const std::function<void(ShardResult&)>& emit) {
+    std::deque<std::vector<uint32_t>> pending;
+    for (size_t first = 0; first < fileCount; first += shardSize) {
+        std::vector<uint32_t> shard;
+        for (size_t i = first; i < fileCount && i < first + shardSize; ++i) {
+            shard.push_back(static_cast<uint32_t>(i));
+        }
+        pending.push_back(std::move(shard));
+    }
+
+    std::vector<ShardResult> results(fileCount);
+    std::vector<bool> done(fileCount, false);
+    std::vector<int> attempts(fileCount, 0);
+    size_t nextEmit = 0;
+    std::vector<WorkerProcess> workers;
+
+    auto spawn = [&]() -> bool {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            return false;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+        if (pid == 0) {
+            // Only this worker's end stays open, so every worker sees EOF
+            // as soon as the coordinator closes its side
+            close(fds[0]);
+            for (const WorkerProcess& other : workers) {
+                close(other.fd);
+            }
+            workerLoop(fds[1], process);
+            _exit(0);
+        }
+        close(fds[1]);
+        WorkerProcess worker;
+        worker.pid = pid;
+        worker.fd = fds[0];
+        workers.push_back(std::move(worker));
+        return true;
+    };
+
+    auto finish = [&](uint32_t index, ShardResult& result) {
+        results[index] = std::move(result);
+        done[index] = true;
+        while (nextEmit < fileCount && done[nextEmit]) {
+            emit(results[nextEmit]);
+            results[nextEmit] = ShardResult();
+            ++nextEmit;
+        }
+    };
+
+    // The worker at `w` died or broke the protocol: requeue its unreported
+    // files, blaming the one it was working on
+    auto retire = [&](size_t w) {
+        WorkerProcess& worker = workers[w];
+        close(worker.fd);
+        int status = 0;
+        std::string reason = "closed its connection";
+        if (waitpid(worker.pid, &status, 0) == worker.pid) {
+            reason = describeExit(status);
+        }
+        ++crashCount;
+
+        std::vector<uint32_t> rest(worker.shard.begin() + worker.reported, worker.shard.end());
+        if (!rest.empty() && ++attempts[rest.front()] >= kMaxAttempts) {
+            ShardResult crashed;
+            crashed.index = rest.front();
+            crashed.crash = "worker process " + reason + " on " +
+                            std::to_string(kMaxAttempts) + " attempts";
+            rest.erase(rest.begin());
+            finish(crashed.index, crashed);
+        }
+        if (!rest.empty()) {
+            pending.push_front(std::move(rest));
+        }
+        workers.erase(workers.begin() + w);
+    };
+
+    // Give up on the run: report every file left as crashed
+    auto abandon = [&](const std::string& why) {
+        for (size_t i = nextEmit; i < fileCount; ++i) {
+            if (!done[i]) {
+                ShardResult crashed;
+                crashed.index = static_cast<uint32_t>(i);
+                crashed.crash = why;
+                finish(crashed.index, crashed);
+            }
+        }
+    };
+
+    std::vector<pollfd> polls;
+    std::string frame;
+    bool lost = false;
+    while (nextEmit < fileCount) {
+        while (workers.size() < processes && !pending.empty() && spawn()) {
+        }
+        if (workers.empty()) {
+            abandon("no worker process could be started");
+            return false;
+        }
+
+        for (size_t w = 0; w < workers.size();) {
+            WorkerProcess& worker = workers[w];
+            if (worker.reported < worker.shard.size() || pending.empty()) {
+                ++w;
+                continue;
+            }
+            worker.shard = std::move(pending.front());
+            worker.reported = 0;
+            pending.pop_front();
+            FrameWriter writer;
+            writer.u32(static_cast<uint32_t>(worker.shard.size()));
+            for (uint32_t index : worker.shard) writer.u32(index);
+            if (!sendAll(worker.fd, writer.frame())) {
+                // It died while idle; the shard was never started
+                pending.push_front(std::move(worker.shard));
+                worker.shard.clear();
+                retire(w);
+                continue;
+            }
+            ++w;
+        }
+
+        polls.clear();
+        for (const WorkerProcess& worker : workers) {
+            polls.push_back(pollfd{worker.fd, POLLIN, 0});
+        }
+        if (poll(polls.data(), polls.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            abandon(std::string("poll: ") + std::strerror(errno));
+            lost = true;
+            break;
+        }
+
+        // Walk backwards so retire() does not shift the workers still to visit
+        for (size_t w = workers.size(); w-- > 0;) {
+            if (!polls[w].revents) {
+                continue;
+            }
+            WorkerProcess& worker = workers[w];
+            char buffer[64 * 1024];
+            ssize_t size = read(worker.fd, buffer, sizeof(buffer));
+            if (size < 0 && errno == EINTR) {
+                continue;
+            }
+            if (size <= 0) {
+                retire(w);
+                continue;
+            }
+            worker.inbox.append(buffer, static_cast<size_t>(size));
+
+            bool broken = false;
+            size_t offset = 0;
+            while (worker.inbox.size() - offset >= 4) {
+                uint32_t length = frameLength(worker.inbox.data() + offset);
+                if (worker.inbox.size() - offset - 4 < length) {
+                    break;
+                }
+                ShardResult result;
+                bool decoded = decodeResult(worker.inbox.data() + offset + 4, length, result);
+                offset += 4 + length;
+                if (!decoded || worker.reported >= worker.shard.size() ||
+                    worker.shard[worker.reported] != result.index) {
+                    broken = true;
+                    break;
+                }
+                ++worker.reported;
+                finish(result.index, result);
+            }
+            worker.inbox.erase(0, offset);
+            if (broken) {
+                kill(worker.pid, SIGKILL);
+                retire(w);
+            }
+        }
+    }
+
+    for (WorkerProcess& worker : workers) {
+        close(worker.fd);
+    }
+    for (WorkerProcess& worker : workers) {
+        int status;
+        waitpid(worker.pid, &status, 0);
+    }
+    return !lost;
+}
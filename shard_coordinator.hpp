@@ -0,0 +1,62 @@
+#ifndef SHARD_COORDINATOR_HPP
+#define SHARD_COORDINATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "diagnostics.hpp"
+
+// Multi-process analysis for semanticdriver --processes. The coordinator
+// splits the file list into shards of consecutive files and hands one shard
+// at a time to each of N forked worker processes over a socketpair. A worker
+// processes its shard's files in order and sends one result per file back.
+//
+// Results are buffered and emitted in file order, so the merged output and
+// diagnostics do not depend on which worker got which shard or on timing.
+// When a worker dies, the files of its shard it had not reported go back to
+// the front of the queue and a new worker is forked. The file it was working
+// on is blamed; a file that brings down kMaxAttempts workers is reported as
+// crashed rather than retried forever.
+//
+// Messages are length-prefixed frames on a byte stream and carry file
+// indices, not paths or memory, so the same protocol works over a TCP
+// connection to a worker on another host that sees the same file list.
+
+// What a worker sends back for one file
+struct ShardResult {
+    uint32_t index = 0;
+    int status = 0;
+    std::string out;
+    std::string err;
+    std::vector<Diagnostic> diagnostics;
+    std::string crash;      // set by the coordinator: why the file was given up on
+};
+
+class ShardCoordinator {
+ private:
+    size_t fileCount;
+    unsigned processes;
+    size_t shardSize;
+    size_t crashCount;
+
+ public:
+    static constexpr int kMaxAttempts = 2;
+
+    // `shardSize` 0 picks about four shards per process
+    ShardCoordinator(size_t fileCount, unsigned processes, size_t shardSize = 0);
+
+    // Fork the workers; each calls `process` for the files of its shards
+    // (in the worker process) and exits when the coordinator closes its
+    // socket. `emit` is called in the coordinator once per file, in index
+    // order. Returns false if no worker process could be started or waiting
+    // on the workers failed; the files left are then emitted as crashed.
+    bool run(const std::function<void(ShardResult&)>& process,
+             const std::function<void(ShardResult&)>& emit);
+
+    // Workers that died during run()
+    size_t crashes() const { return crashCount; }
+};
+
+#endif // SHARD_COORDINATOR_HPP
@@ -0,0 +1,64 @@
+#include "signature_pool.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+size_t SignaturePool::hashSignature(DataType returnType, const DataType* paramTypes,
+                                    size_t paramCount) {
+    size_t hash = static_cast<size_t>(returnType) * 0x9e3779b97f4a7c15ULL + paramCount;
+    for (size_t i = 0; i < paramCount; ++i) {
+        hash = (hash ^ static_cast<size_t>(paramTypes[i])) * 0x100000001b3ULL;
+    }
+    return hash ^ (hash >> 29);
+}
+
+bool SignaturePool::sameAs(const Entry& entry, DataType returnType, const DataType* paramTypes,
+                           size_t paramCount) const {
+    return entry.returnType == returnType && entry.paramCount == paramCount &&
+           std::equal(paramTypes, paramTypes + paramCount, types.begin() + entry.offset);
+}
+
+void SignaturePool::insertBucket(uint32_t id, size_t hash) {
+    size_t mask = buckets.size() - 1;
+    size_t i = hash & mask;
+    while (buckets[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    buckets[i] = id + 1;
+}
+
+uint32_t SignaturePool::intern(DataType returnType, const DataType* paramTypes,
+                               size_t paramCount) {
+    size_t hash = hashSignature(returnType, paramTypes, paramCount);
+    if (!buckets.empty()) {
+        size_t mask = buckets.size() - 1;
+        for (size_t i = hash & mask; buckets[i] != 0; i = (i + 1) & mask) {
+            const Entry& entry = entries[buckets[i] - 1];
+            if (entry.hash == hash && sameAs(entry, returnType, paramTypes, paramCount)) {
+                return buckets[i] - 1;
+            }
+        }
+    }
+    if (types.size() + paramCount > UINT32_MAX || entries.size() == UINT32_MAX - 1) {
+        throw std::length_error("SignaturePool: too many signatures");
+    }
+
+    // Double the table once it would pass half full
+    if ((entries.size() + 1) * 2 > buckets.size()) {
+        buckets.assign(buckets.empty() ? 16 : buckets.size() * 2, 0);
+        for (uint32_t id = 0; id < entries.size(); ++id) {
+            insertBucket(id, entries[id].hash);
+        }
+    }
+    uint32_t id = static_cast<uint32_t>(entries.size());
+    entries.push_back(Entry{static_cast<uint32_t>(types.size()),
+                            static_cast<uint32_t>(paramCount), returnType, hash});
+    types.insert(types.end(), paramTypes, paramTypes + paramCount);
+    insertBucket(id, hash);
+    return id;
+}
+
+void SignaturePool::clear() {
+    types.clear();
+    entries.clear();
+    std::fill(buckets.begin(), buckets.end(), 0);
+}
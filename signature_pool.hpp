@@ -0,0 +1,60 @@
+#ifndef SIGNATURE_POOL_HPP
+#define SIGNATURE_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "data_type.hpp"
+
+// A function's return and parameter types, as stored in a SignaturePool.
+// The parameters point into the pool and stay valid until it is cleared or
+// destroyed.
+struct FunctionSignature {
+    DataType returnType;
+    const DataType* paramTypes;
+    size_t paramCount;
+};
+
+// The distinct function signatures of a program. Function symbols refer to
+// theirs by ID (SymbolInfo::signature), so functions with the same return
+// and parameter types share one entry, and a symbol carries no vector of its
+// own. Parameter lists are stored back to back in one array.
+//
+// clear() keeps every buffer, so a pool that serves one program after
+// another stops allocating once it has held the largest of them.
+
+class SignaturePool {
+ private:
+    struct Entry {
+        uint32_t offset;                // first parameter in `types`
+        uint32_t paramCount;
+        DataType returnType;
+        size_t hash;
+    };
+
+    std::vector<DataType> types;        // parameter lists, back to back
+    std::vector<Entry> entries;         // indexed by ID
+    std::vector<uint32_t> buckets;      // ID + 1, or 0; empty or a power of two
+
+    static size_t hashSignature(DataType returnType, const DataType* paramTypes,
+                                size_t paramCount);
+    bool sameAs(const Entry& entry, DataType returnType, const DataType* paramTypes,
+                size_t paramCount) const;
+    void insertBucket(uint32_t id, size_t hash);
+
+ public:
+    // The ID of this signature, adding it if no function had it yet
+    uint32_t intern(DataType returnType, const DataType* paramTypes, size_t paramCount);
+
+    FunctionSignature get(uint32_t id) const {
+        const Entry& entry = entries[id];
+        return FunctionSignature{entry.returnType, types.data() + entry.offset, entry.paramCount};
+    }
+
+    // Distinct signatures interned since the last clear()
+    size_t size() const { return entries.size(); }
+
+    void clear();
+};
+
+#endif // SIGNATURE_POOL_HPP
@@ -0,0 +1,389 @@
+#include "stats.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <iomanip>
+
+namespace {
+
+double clockMs(clockid_t clock) {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Lower and upper bound (inclusive) of a lookup-depth bucket; the last one
+// is open-ended and reports 0 as its upper bound
+void bucketRange(size_t bucket, uint64_t& lo, uint64_t& hi) {
+    lo = uint64_t(1) << bucket;
+    hi = (bucket + 1 < ScopeCounters::kDepthBuckets) ? (lo << 1) - 1 : 0;
+}
+
+NodeKind kindOf(const ASTNode* node) {
+    if (dynamic_cast<const ProgramNode*>(node)) return NodeKind::Program;
+    if (dynamic_cast<const FunctionDeclNode*>(node)) return NodeKind::FunctionDecl;
+    if (dynamic_cast<const VarDeclNode*>(node)) return NodeKind::VarDecl;
+    if (dynamic_cast<const IfStmtNode*>(node)) return NodeKind::If;
+    if (dynamic_cast<const WhileStmtNode*>(node)) return NodeKind::While;
+    if (dynamic_cast<const AssignmentStmtNode*>(node)) return NodeKind::Assignment;
+    if (dynamic_cast<const ReturnStmtNode*>(node)) return NodeKind::Return;
+    if (dynamic_cast<const PrintStmtNode*>(node)) return NodeKind::Print;
+    if (dynamic_cast<const BinaryOpNode*>(node)) return NodeKind::BinaryOp;
+    if (dynamic_cast<const UnaryOpNode*>(node)) return NodeKind::UnaryOp;
+    if (dynamic_cast<const FunctionCallNode*>(node)) return NodeKind::FunctionCall;
+    if (dynamic_cast<const IdentifierNode*>(node)) return NodeKind::Identifier;
+    if (dynamic_cast<const IntegerNode*>(node)) return NodeKind::Integer;
+    if (dynamic_cast<const FloatNode*>(node)) return NodeKind::Float;
+    if (dynamic_cast<const BoolNode*>(node)) return NodeKind::Bool;
+    return NodeKind::Other;
+}
+
+// One row of the --perf table: each event's count, or "-" when it is not
+// open, with IPC after instructions
+void printPerfRow(std::ostream& out, const std::string& label, const std::string& name,
+                  uint32_t events, const PerfSample& sample) {
+    out << label << ":   " << std::left << std::setw(10) << name << std::right;
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        PerfEvent event = static_cast<PerfEvent>(i);
+        out << std::setw(15);
+        if (events & perfEventBit(event)) out << sample.value[i];
+        else out << "-";
+
+        if (event == PerfEvent::INSTRUCTIONS) {
+            uint32_t both = perfEventBit(PerfEvent::CYCLES) | perfEventBit(PerfEvent::INSTRUCTIONS);
+            out << std::setw(7);
+            if ((events & both) == both && sample[PerfEvent::CYCLES]) {
+                out << std::setprecision(2)
+                    << double(sample[PerfEvent::INSTRUCTIONS]) / sample[PerfEvent::CYCLES]
+                    << std::setprecision(3);
+            } else {
+                out << "-";
+            }
+        }
+    }
+    out << "\n";
+}
+
+// "name count/nodes" for each open event
+void printPerNode(std::ostream& out, uint32_t events, const PerfSample& sample, uint64_t nodes) {
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        if (events & perfEventBit(static_cast<PerfEvent>(i))) {
+            out << " " << perfEventName(static_cast<PerfEvent>(i)) << " "
+                << double(sample.value[i]) / nodes;
+        }
+    }
+}
+
+// JSON field for an event: "LLC-misses" -> "llc_misses"
+std::string perfJsonKey(PerfEvent event) {
+    std::string key = perfEventName(event);
+    for (char& c : key) {
+        c = (c == '-') ? '_' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+void addSample(PerfSample& total, const PerfSample& sample) {
+    for (size_t i = 0; i < kPerfEventCount; ++i) {
+        total.value[i] += sample.value[i];
+    }
+}
+
+template <typename Node>
+void pushAll(std::vector<const ASTNode*>& pending, const std::vector<Node*>& items) {
+    pending.insert(pending.end(), items.begin(), items.end());
+}
+
+} // namespace
+
+const char* nodeKindName(NodeKind kind) {
+    switch (kind) {
+#define X(name) case NodeKind::name: return #name;
+        AST_NODE_KINDS(X)
+#undef X
+        case NodeKind::Count: break;
+    }
+    return "?";
+}
+
+uint64_t NodeCounts::total() const {
+    uint64_t sum = 0;
+    for (uint64_t n : byKind) {
+        sum += n;
+    }
+    return sum;
+}
+
+// Walks an explicit stack, like ASTNode::print, so any nesting depth works
+void countNodes(const ASTNode* root, NodeCounts& counts) {
+    std::vector<const ASTNode*> pending;
+    pending.push_back(root);
+    while (!pending.empty()) {
+        const ASTNode* node = pending.back();
+        pending.pop_back();
+        if (!node) {
+            continue;
+        }
+        NodeKind kind = kindOf(node);
+        ++counts.byKind[static_cast<size_t>(kind)];
+
+        switch (kind) {
+            case NodeKind::Program:
+                pushAll(pending, static_cast<const ProgramNode*>(node)->declarations);
+                break;
+            case NodeKind::FunctionDecl:
+                pushAll(pending, static_cast<const FunctionDeclNode*>(node)->bodyItems);
+                break;
+            case NodeKind::VarDecl:
+                pending.push_back(static_cast<const VarDeclNode*>(node)->initializer);
+                break;
+            case NodeKind::If: {
+                auto ifStmt = static_cast<const IfStmtNode*>(node);
+                pending.push_back(ifStmt->condition);
+                pushAll(pending, ifStmt->thenItems);
+                pushAll(pending, ifStmt->elseItems);
+                break;
+            }
+            case NodeKind::While: {
+                auto whileStmt = static_cast<const WhileStmtNode*>(node);
+                pending.push_back(whileStmt->condition);
+                pushAll(pending, whileStmt->bodyItems);
+                break;
+            }
+            case NodeKind::Assignment:
+                pending.push_back(static_cast<const AssignmentStmtNode*>(node)->value);
+                break;
+            case NodeKind::Return:
+                pending.push_back(static_cast<const ReturnStmtNode*>(node)->value);
+                break;
+            case NodeKind::Print:
+                pending.push_back(static_cast<const PrintStmtNode*>(node)->expression);
+                break;
+            case NodeKind::BinaryOp:
+                pending.push_back(static_cast<const BinaryOpNode*>(node)->left);
+                pending.push_back(static_cast<const BinaryOpNode*>(node)->right);
+                break;
+            case NodeKind::UnaryOp:
+                pending.push_back(static_cast<const UnaryOpNode*>(node)->operand);
+                break;
+            case NodeKind::FunctionCall:
+                pushAll(pending, static_cast<const FunctionCallNode*>(node)->arguments);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+PhaseClock::PhaseClock() {
+    restart();
+}
+
+void PhaseClock::restart() {
+    const AllocCounters& alloc = threadAllocCounters();
+    allocationsStart = alloc.allocations;
+    allocBytesStart = alloc.bytes;
+    resetAllocPeak();
+    if (threadPerfEvents()) {
+        readThreadPerfCounters(perfStart);
+    }
+    wallStart = clockMs(CLOCK_MONOTONIC);
+    cpuStart = clockMs(CLOCK_THREAD_CPUTIME_ID);
+}
+
+PhaseTime PhaseClock::elapsed(const std::string& name) const {
+    double wallEnd = clockMs(CLOCK_MONOTONIC);
+    double cpuEnd = clockMs(CLOCK_THREAD_CPUTIME_ID);
+    PhaseTime phase{name, wallEnd - wallStart, cpuEnd - cpuStart, 0, 0, 0,
+                    threadPerfEvents(), PerfSample()};
+    if (phase.perfEvents) {
+        PerfReading perfEnd;
+        readThreadPerfCounters(perfEnd);
+        phase.perf = perfDelta(perfStart, perfEnd);
+    }
+    const AllocCounters& alloc = threadAllocCounters();
+    phase.allocations = alloc.allocations - allocationsStart;
+    phase.allocBytes = alloc.bytes - allocBytesStart;
+    phase.peakLiveBytes = alloc.peakLiveBytes;
+    return phase;
+}
+
+void RunStats::finishAllocationCount() {
+    const AllocCounters& now = threadAllocCounters();
+    allocations.allocations = now.allocations - allocations.allocations;
+    allocations.bytes = now.bytes - allocations.bytes;
+    allocations.frees = now.frees - allocations.frees;
+    allocations.liveBytes = now.liveBytes - allocations.liveBytes;
+    // Peak tracking restarts with each phase, so the file's peak is theirs
+    allocations.peakLiveBytes = now.peakLiveBytes;
+    for (const auto& phase : phases) {
+        allocations.peakLiveBytes = std::max(allocations.peakLiveBytes, phase.peakLiveBytes);
+    }
+    for (size_t i = 0; i < kAllocSiteCount; ++i) {
+        allocations.siteAllocations[i] = now.siteAllocations[i] - allocations.siteAllocations[i];
+        allocations.siteBytes[i] = now.siteBytes[i] - allocations.siteBytes[i];
+    }
+}
+
+void RunStats::print(std::ostream& out, const std::string& label) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    double wall = 0, cpu = 0;
+    out << label << ": phase          wall ms      cpu ms";
+    if (kAllocStatsEnabled) {
+        out << "      allocs    alloc KB  peak live KB";
+    }
+    out << "\n";
+    for (const auto& phase : phases) {
+        out << label << ":   " << std::left << std::setw(10) << phase.name << std::right
+            << std::setw(12) << phase.wallMs << std::setw(12) << phase.cpuMs;
+        if (kAllocStatsEnabled) {
+            out << std::setw(12) << phase.allocations << std::setw(12) << phase.allocBytes / 1024.0
+                << std::setw(14) << phase.peakLiveBytes / 1024.0;
+        }
+        out << "\n";
+        wall += phase.wallMs;
+        cpu += phase.cpuMs;
+    }
+    out << label << ":   " << std::left << std::setw(10) << "total" << std::right
+        << std::setw(12) << wall << std::setw(12) << cpu;
+    if (kAllocStatsEnabled) {
+        out << std::setw(12) << allocations.allocations << std::setw(12)
+            << allocations.bytes / 1024.0 << std::setw(14) << allocations.peakLiveBytes / 1024.0;
+    }
+    out << "\n";
+
+    // Hardware counters; phases measured on a thread without them are skipped
+    uint32_t perfEvents = 0;
+    for (const auto& phase : phases) {
+        perfEvents |= phase.perfEvents;
+    }
+    if (perfEvents) {
+        out << label << ": counters ";
+        for (size_t i = 0; i < kPerfEventCount; ++i) {
+            out << std::setw(15) << perfEventName(static_cast<PerfEvent>(i));
+            if (static_cast<PerfEvent>(i) == PerfEvent::INSTRUCTIONS) {
+                out << std::setw(7) << "IPC";
+            }
+        }
+        out << "\n";
+        PerfSample total, analysis;
+        for (const auto& phase : phases) {
+            if (!phase.perfEvents) {
+                continue;
+            }
+            printPerfRow(out, label, phase.name, phase.perfEvents, phase.perf);
+            addSample(total, phase.perf);
+            if (phase.name == "declare" || phase.name == "analyze") {
+                addSample(analysis, phase.perf);
+            }
+        }
+        printPerfRow(out, label, "total", perfEvents, total);
+        if (nodes.total()) {
+            out << label << ": per AST node, declare+analyze:";
+            printPerNode(out, perfEvents, analysis, nodes.total());
+            out << "\n" << label << ": per AST node, all phases:";
+            printPerNode(out, perfEvents, total, nodes.total());
+            out << "\n";
+        }
+    }
+
+    out << label << ": nodes " << nodes.total() << ":";
+    for (size_t k = 0; k < static_cast<size_t>(NodeKind::Count); ++k) {
+        if (nodes.byKind[k]) {
+            out << " " << nodeKindName(static_cast<NodeKind>(k)) << " " << nodes.byKind[k];
+        }
+    }
+    out << "\n";
+
+    out << label << ": scopes " << scopes.scopesCreated << " (peak depth " << scopes.peakDepth
+        << "), symbols " << scopes.symbolsAdded << ", lookups " << scopes.lookups << "\n";
+    out << label << ": lookup chain depth:";
+    for (size_t b = 0; b < ScopeCounters::kDepthBuckets; ++b) {
+        if (!scopes.lookupDepth[b]) {
+            continue;
+        }
+        uint64_t lo, hi;
+        bucketRange(b, lo, hi);
+        out << " " << lo;
+        if (hi == 0) out << "+";
+        else if (hi != lo) out << "-" << hi;
+        out << ": " << scopes.lookupDepth[b];
+    }
+    out << "\n";
+
+    if (kAllocStatsEnabled) {
+        out << label << ": allocations by site:";
+        for (size_t i = 0; i < kAllocSiteCount; ++i) {
+            if (allocations.siteAllocations[i]) {
+                out << " " << allocSiteName(static_cast<AllocSite>(i)) << " "
+                    << allocations.siteAllocations[i] << " ("
+                    << allocations.siteBytes[i] / 1024.0 << " KB)";
+            }
+        }
+        out << "\n";
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void RunStats::printJson(std::ostream& out, const std::string& label) const {
+    out << "{\"file\": " << jsonString(label) << ", \"phases\": [";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        out << (i ? ", " : "") << "{\"name\": " << jsonString(phases[i].name)
+            << ", \"wall_ms\": " << phases[i].wallMs << ", \"cpu_ms\": " << phases[i].cpuMs;
+        if (kAllocStatsEnabled) {
+            out << ", \"allocations\": " << phases[i].allocations
+                << ", \"alloc_bytes\": " << phases[i].allocBytes
+                << ", \"peak_live_bytes\": " << phases[i].peakLiveBytes;
+        }
+        for (size_t e = 0; e < kPerfEventCount; ++e) {
+            if (phases[i].perfEvents & perfEventBit(static_cast<PerfEvent>(e))) {
+                out << ", \"" << perfJsonKey(static_cast<PerfEvent>(e)) << "\": "
+                    << phases[i].perf.value[e];
+            }
+        }
+        out << "}";
+    }
+
+    out << "], \"nodes\": {\"total\": " << nodes.total();
+    for (size_t k = 0; k < static_cast<size_t>(NodeKind::Count); ++k) {
+        out << ", \"" << nodeKindName(static_cast<NodeKind>(k)) << "\": " << nodes.byKind[k];
+    }
+
+    out << "}, \"scopes_created\": " << scopes.scopesCreated
+        << ", \"peak_scope_depth\": " << scopes.peakDepth
+        << ", \"symbols_added\": " << scopes.symbolsAdded
+        << ", \"lookups\": " << scopes.lookups << ", \"lookup_depth_histogram\": [";
+    bool first = true;
+    for (size_t b = 0; b < ScopeCounters::kDepthBuckets; ++b) {
+        if (!scopes.lookupDepth[b]) {
+            continue;
+        }
+        uint64_t lo, hi;
+        bucketRange(b, lo, hi);
+        out << (first ? "" : ", ") << "{\"min\": " << lo << ", \"max\": ";
+        if (hi == 0) out << "null";
+        else out << hi;
+        out << ", \"count\": " << scopes.lookupDepth[b] << "}";
+        first = false;
+    }
+    out << "]";
+
+    if (kAllocStatsEnabled) {
+        out << ", \"allocations\": " << allocations.allocations
+            << ", \"alloc_bytes\": " << allocations.bytes
+            << ", \"peak_live_bytes\": " << allocations.peakLiveBytes << ", \"alloc_sites\": {";
+        for (size_t i = 0; i < kAllocSiteCount; ++i) {
+            out << (i ? ", " : "") << "\"" << allocSiteName(static_cast<AllocSite>(i))
+                << "\": {\"allocations\": " << allocations.siteAllocations[i]
+                << ", \"bytes\": " << allocations.siteBytes[i] << "}";
+        }
+        out << "}";
+    }
+    out << "}\n";
+}
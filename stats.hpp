@@ -0,0 +1,105 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "alloc_stats.hpp"
+#include "astnode.hpp"
+#include "perf_counters.hpp"
+
+// Per-file measurements behind semanticdriver --stats: wall and CPU time for
+// each phase, AST node counts by kind, and the scope/symbol-table counters.
+
+#define AST_NODE_KINDS(X) \
+    X(Program)            \
+    X(FunctionDecl)       \
+    X(VarDecl)            \
+    X(If)                 \
+    X(While)              \
+    X(Assignment)         \
+    X(Return)             \
+    X(Print)              \
+    X(BinaryOp)           \
+    X(UnaryOp)            \
+    X(FunctionCall)       \
+    X(Identifier)         \
+    X(Integer)            \
+    X(Float)              \
+    X(Bool)               \
+    X(Other)
+
+enum class NodeKind : uint8_t {
+#define X(name) name,
+    AST_NODE_KINDS(X)
+#undef X
+    Count
+};
+
+const char* nodeKindName(NodeKind kind);
+
+struct NodeCounts {
+    uint64_t byKind[static_cast<size_t>(NodeKind::Count)] = {};
+
+    uint64_t total() const;
+};
+
+// Count every node reachable from `root`
+void countNodes(const ASTNode* root, NodeCounts& counts);
+
+// Wall and thread CPU time of one phase, plus its heap traffic in an
+// ALLOC_STATS build and its hardware counters under --perf
+struct PhaseTime {
+    std::string name;
+    double wallMs;
+    double cpuMs;
+    uint64_t allocations;
+    uint64_t allocBytes;
+    int64_t peakLiveBytes;
+    uint32_t perfEvents;    // perfEventBit() set of the counters in `perf`
+    PerfSample perf;
+};
+
+// Starts timing on construction; elapsed() can be read any number of times.
+// restart() also restarts the thread's peak live-byte tracking.
+class PhaseClock {
+ private:
+    double wallStart;
+    double cpuStart;
+    uint64_t allocationsStart;
+    uint64_t allocBytesStart;
+    PerfReading perfStart;
+
+ public:
+    PhaseClock();
+
+    void restart();
+    PhaseTime elapsed(const std::string& name) const;
+};
+
+struct RunStats {
+    std::vector<PhaseTime> phases;
+    NodeCounts nodes;
+    ScopeCounters scopes;
+
+    // Per-site allocation totals between startAllocationCount() and
+    // finishAllocationCount()
+    AllocCounters allocations;
+
+    void startAllocationCount() { allocations = threadAllocCounters(); }
+    void finishAllocationCount();
+
+    void addPhase(const std::string& name, const PhaseClock& clock) {
+        phases.push_back(clock.elapsed(name));
+    }
+
+    // Multi-line report, every line prefixed with `label: `
+    void print(std::ostream& out, const std::string& label) const;
+
+    // One JSON object on a single line, with `label` as its "file" field
+    void printJson(std::ostream& out, const std::string& label) const;
+};
+
+#endif // STATS_HPP
@@ -0,0 +1,46 @@
+#include "trace.hpp"
+#include "json.hpp"
+#include <fstream>
+
+int64_t TraceBuffer::nowUs() const {
+    return tracer->nowUs();
+}
+
+Tracer::Tracer(size_t threads) : origin(std::chrono::steady_clock::now()) {
+    buffers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        buffers.emplace_back(this, static_cast<uint32_t>(i + 1));
+    }
+}
+
+int64_t Tracer::nowUs() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - origin).count();
+}
+
+bool Tracer::write(const std::string& path, const std::vector<std::string>& files) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << buffer.tid << ", \"args\": {\"name\": \"worker " << buffer.tid - 1 << "\"}}";
+        first = false;
+
+        for (const auto& event : buffer.events) {
+            out << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"driver\", \"ph\": \"X\", \"pid\": 1"
+                << ", \"tid\": " << buffer.tid << ", \"ts\": " << event.startUs
+                << ", \"dur\": " << event.durationUs;
+            if (event.file != kNoFile && event.file < files.size()) {
+                out << ", \"args\": {\"file\": " << jsonString(files[event.file]) << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
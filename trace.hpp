@@ -0,0 +1,91 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Chrome trace-event recording (chrome://tracing, ui.perfetto.dev) for
+// semanticdriver --trace. Each worker thread appends complete ("X") events
+// to its own TraceBuffer without locking; Tracer::write merges them once
+// every thread has finished.
+//
+// With tracing off the buffers are nullptr and a TraceSpan costs one branch
+// on construction and one on destruction.
+
+struct TraceEvent {
+    const char* name;     // string literal
+    uint32_t file;        // index into the file list passed to write(), or kNoFile
+    int64_t startUs;
+    int64_t durationUs;
+};
+
+class Tracer;
+
+class TraceBuffer {
+ private:
+    const Tracer* tracer;
+    uint32_t tid;
+    std::vector<TraceEvent> events;
+
+    friend class Tracer;
+
+ public:
+    TraceBuffer(const Tracer* tracer, uint32_t tid) : tracer(tracer), tid(tid) {}
+
+    int64_t nowUs() const;
+    void add(const char* name, uint32_t file, int64_t startUs, int64_t endUs) {
+        events.push_back(TraceEvent{name, file, startUs, endUs - startUs});
+    }
+};
+
+class Tracer {
+ private:
+    std::chrono::steady_clock::time_point origin;
+    std::vector<TraceBuffer> buffers;
+
+ public:
+    static constexpr uint32_t kNoFile = UINT32_MAX;
+
+    // One buffer per thread; the caller hands buffer(i) to thread i
+    explicit Tracer(size_t threads);
+
+    // Buffers point back at their tracer
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    TraceBuffer* buffer(size_t thread) { return &buffers[thread]; }
+    int64_t nowUs() const;
+
+    // Write {"traceEvents": [...]} with a thread-name record per buffer.
+    // Returns false if the file cannot be written.
+    bool write(const std::string& path, const std::vector<std::string>& files) const;
+};
+
+// Records [construction, end() or destruction) into `buffer` when non-null
+class TraceSpan {
+ private:
+    TraceBuffer* buffer;
+    const char* name;
+    uint32_t file;
+    int64_t startUs;
+
+ public:
+    TraceSpan(TraceBuffer* buffer, const char* name, uint32_t file = Tracer::kNoFile)
+        : buffer(buffer), name(name), file(file), startUs(buffer ? buffer->nowUs() : 0) {}
+
+    ~TraceSpan() { end(); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void end() {
+        if (buffer) {
+            buffer->add(name, file, startUs, buffer->nowUs());
+            buffer = nullptr;
+        }
+    }
+};
+
+#endif // TRACE_HPP
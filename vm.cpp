@@ -0,0 +1,290 @@
+#include "vm.hpp"
+#include <stdexcept>
+#include <string>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+namespace {
+
+// Integer arithmetic wraps instead of invoking undefined behaviour
+inline int64_t wrapAdd(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+inline int64_t wrapSub(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) - static_cast<uint64_t>(b));
+}
+
+inline int64_t wrapMul(int64_t a, int64_t b) {
+    return static_cast<int64_t>(static_cast<uint64_t>(a) * static_cast<uint64_t>(b));
+}
+
+[[noreturn]] void runtimeError(const std::string& message) {
+    throw std::runtime_error("Runtime error: " + message);
+}
+
+} // namespace
+
+VirtualMachine::VirtualMachine(const BytecodeModule& module, std::ostream& out,
+                               size_t stackSlots, size_t maxFrames)
+    : module(module), out(out), stack(stackSlots), globals(module.numGlobals),
+      maxFrames(maxFrames) {
+    frames.reserve(maxFrames);
+}
+
+void VirtualMachine::run() {
+    if (module.initFunction >= 0) {
+        execute(module.initFunction);
+    }
+    if (module.mainFunction >= 0) {
+        execute(module.mainFunction);
+    }
+}
+
+// Run one function to completion. Calls made by the bytecode stay inside this
+// loop; only the entry function's RETURN (or HALT) leaves it.
+Value VirtualMachine::execute(int32_t entry) {
+    const BytecodeFunction* entryFn = &module.functions[entry];
+    Value* const stackEnd = stack.data() + stack.size();
+    const double* floatConstants = module.floatConstants.data();
+    Value* globalSlots = globals.data();
+
+    Value* base = stack.data();
+    Value* sp = base + entryFn->numLocals;
+    if (sp + entryFn->maxStack > stackEnd) {
+        runtimeError("stack overflow");
+    }
+    const Instruction* code = entryFn->code.data();
+    const Instruction* ip = code;
+    frames.clear();
+
+#ifdef VM_COMPUTED_GOTO
+    static void* const dispatchTable[] = {
+#define VM_LABEL(name, hasOperand) &&op_##name,
+        BYTECODE_OPCODES(VM_LABEL)
+#undef VM_LABEL
+    };
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *dispatchTable[static_cast<uint8_t>(ip->op)]
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT() do { ++ip; VM_DISPATCH(); } while (0)
+
+// Pop the right operand and combine it into the left one in place
+#define VM_BINARY(field, resultField, expr)                                 \
+    do {                                                                    \
+        --sp;                                                               \
+        auto a = sp[-1].field;                                              \
+        auto b = sp[0].field;                                               \
+        sp[-1].resultField = (expr);                                        \
+    } while (0)
+
+#ifdef VM_COMPUTED_GOTO
+    VM_DISPATCH();
+#else
+dispatch:
+    switch (ip->op) {
+#endif
+
+    VM_CASE(PUSH_INT) {
+        (sp++)->i = ip->operand;
+        VM_NEXT();
+    }
+    VM_CASE(PUSH_FLOAT) {
+        (sp++)->f = floatConstants[ip->operand];
+        VM_NEXT();
+    }
+    VM_CASE(POP) {
+        --sp;
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_LOCAL) {
+        *sp++ = base[ip->operand];
+        VM_NEXT();
+    }
+    VM_CASE(STORE_LOCAL) {
+        base[ip->operand] = *--sp;
+        VM_NEXT();
+    }
+    VM_CASE(LOAD_GLOBAL) {
+        *sp++ = globalSlots[ip->operand];
+        VM_NEXT();
+    }
+    VM_CASE(STORE_GLOBAL) {
+        globalSlots[ip->operand] = *--sp;
+        VM_NEXT();
+    }
+    VM_CASE(IADD) {
+        VM_BINARY(i, i, wrapAdd(a, b));
+        VM_NEXT();
+    }
+    VM_CASE(ISUB) {
+        VM_BINARY(i, i, wrapSub(a, b));
+        VM_NEXT();
+    }
+    VM_CASE(IMUL) {
+        VM_BINARY(i, i, wrapMul(a, b));
+        VM_NEXT();
+    }
+    VM_CASE(IDIV) {
+        int64_t b = sp[-1].i;
+        if (b == 0) {
+            runtimeError("division by zero");
+        }
+        --sp;
+        // INT64_MIN / -1 overflows; define it as wrapping negation
+        sp[-1].i = (b == -1) ? wrapSub(0, sp[-1].i) : sp[-1].i / b;
+        VM_NEXT();
+    }
+    VM_CASE(INEG) {
+        sp[-1].i = wrapSub(0, sp[-1].i);
+        VM_NEXT();
+    }
+    VM_CASE(FADD) {
+        VM_BINARY(f, f, a + b);
+        VM_NEXT();
+    }
+    VM_CASE(FSUB) {
+        VM_BINARY(f, f, a - b);
+        VM_NEXT();
+    }
+    VM_CASE(FMUL) {
+        VM_BINARY(f, f, a * b);
+        VM_NEXT();
+    }
+    VM_CASE(FDIV) {
+        VM_BINARY(f, f, a / b);
+        VM_NEXT();
+    }
+    VM_CASE(FNEG) {
+        sp[-1].f = -sp[-1].f;
+        VM_NEXT();
+    }
+    VM_CASE(ILT) {
+        VM_BINARY(i, i, a < b);
+        VM_NEXT();
+    }
+    VM_CASE(IGT) {
+        VM_BINARY(i, i, a > b);
+        VM_NEXT();
+    }
+    VM_CASE(ILE) {
+        VM_BINARY(i, i, a <= b);
+        VM_NEXT();
+    }
+    VM_CASE(IGE) {
+        VM_BINARY(i, i, a >= b);
+        VM_NEXT();
+    }
+    VM_CASE(IEQ) {
+        VM_BINARY(i, i, a == b);
+        VM_NEXT();
+    }
+    VM_CASE(INE) {
+        VM_BINARY(i, i, a != b);
+        VM_NEXT();
+    }
+    VM_CASE(FLT) {
+        VM_BINARY(f, i, a < b);
+        VM_NEXT();
+    }
+    VM_CASE(FGT) {
+        VM_BINARY(f, i, a > b);
+        VM_NEXT();
+    }
+    VM_CASE(FLE) {
+        VM_BINARY(f, i, a <= b);
+        VM_NEXT();
+    }
+    VM_CASE(FGE) {
+        VM_BINARY(f, i, a >= b);
+        VM_NEXT();
+    }
+    VM_CASE(FEQ) {
+        VM_BINARY(f, i, a == b);
+        VM_NEXT();
+    }
+    VM_CASE(FNE) {
+        VM_BINARY(f, i, a != b);
+        VM_NEXT();
+    }
+    VM_CASE(I2F) {
+        sp[-1].f = static_cast<double>(sp[-1].i);
+        VM_NEXT();
+    }
+    VM_CASE(I2B) {
+        sp[-1].i = (sp[-1].i != 0);
+        VM_NEXT();
+    }
+    VM_CASE(JUMP) {
+        ip = code + ip->operand;
+        VM_DISPATCH();
+    }
+    VM_CASE(JUMP_IF_FALSE) {
+        if ((--sp)->i == 0) {
+            ip = code + ip->operand;
+            VM_DISPATCH();
+        }
+        VM_NEXT();
+    }
+    VM_CASE(CALL) {
+        const BytecodeFunction& callee = module.functions[ip->operand];
+        Value* calleeBase = sp - callee.numParams;
+        Value* calleeSp = calleeBase + callee.numLocals;
+        if (frames.size() == maxFrames || calleeSp + callee.maxStack > stackEnd) {
+            runtimeError("stack overflow in call to '" + callee.name + "'");
+        }
+        frames.push_back(Frame{code, ip + 1, base});
+        base = calleeBase;
+        sp = calleeSp;
+        code = callee.code.data();
+        ip = code;
+        VM_DISPATCH();
+    }
+    VM_CASE(RETURN) {
+        Value result = sp[-1];
+        if (frames.empty()) {
+            return result;
+        }
+        const Frame& caller = frames.back();
+        sp = base;
+        *sp++ = result;
+        base = caller.base;
+        code = caller.code;
+        ip = caller.returnIp;
+        frames.pop_back();
+        VM_DISPATCH();
+    }
+    VM_CASE(PRINT_INT) {
+        out << (--sp)->i << '\n';
+        VM_NEXT();
+    }
+    VM_CASE(PRINT_FLOAT) {
+        out << (--sp)->f << '\n';
+        VM_NEXT();
+    }
+    VM_CASE(PRINT_BOOL) {
+        out << ((--sp)->i ? "true" : "false") << '\n';
+        VM_NEXT();
+    }
+    VM_CASE(MISSING_RETURN) {
+        runtimeError("control reached the end of a function without returning");
+    }
+    VM_CASE(HALT) {
+        return Value::Int(0);
+    }
+
+#ifndef VM_COMPUTED_GOTO
+    }
+    runtimeError("invalid opcode");
+#endif
+
+#undef VM_BINARY
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef VM_CASE
+}
@@ -0,0 +1,44 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include "bytecode.hpp"
+#include <iostream>
+#include <vector>
+
+// Stack-based interpreter for BytecodeModule. Each call frame is a window of
+// the value stack: parameters and locals sit at fixed slots from the frame
+// base, temporaries above them. Values are untagged; every instruction is
+// already specialised for its operand types, so the loop never branches on a
+// value's type. Dispatch uses computed goto where the compiler supports it and
+// falls back to a switch otherwise.
+class VirtualMachine {
+ private:
+    struct Frame {
+        const Instruction* code;
+        const Instruction* returnIp;
+        Value* base;
+    };
+
+    const BytecodeModule& module;
+    std::ostream& out;
+    std::vector<Value> stack;
+    std::vector<Value> globals;
+    std::vector<Frame> frames;
+    size_t maxFrames;
+
+    Value execute(int32_t entry);
+
+ public:
+    static constexpr size_t kDefaultStackSlots = 1 << 20;
+    static constexpr size_t kDefaultMaxFrames = 1 << 16;
+
+    explicit VirtualMachine(const BytecodeModule& module,
+                            std::ostream& out = std::cout,
+                            size_t stackSlots = kDefaultStackSlots,
+                            size_t maxFrames = kDefaultMaxFrames);
+
+    // Run the global initializers, then `main` if the program defines one
+    void run();
+};
+
+#endif // VM_HPP
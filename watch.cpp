@@ -0,0 +1,263 @@
+#include "watch.hpp"
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "frontend.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// "dir/name", or just "name" in the current directory, so a file named on
+// the command line and the same file reported by inotify get one key
+std::string joinPath(const std::string& directory, const std::string& name) {
+    if (directory == ".") {
+        return name;
+    }
+    if (!directory.empty() && directory.back() == '/') {
+        return directory + name;
+    }
+    return directory + "/" + name;
+}
+
+std::string trimSlashes(std::string path) {
+    while (path.size() > 1 && path.back() == '/') {
+        path.pop_back();
+    }
+    return path;
+}
+
+void splitPath(const std::string& path, std::string& directory, std::string& name) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        directory = ".";
+        name = path;
+    } else {
+        directory = slash == 0 ? "/" : path.substr(0, slash);
+        name = path.substr(slash + 1);
+    }
+}
+
+// Programs are *.txt files (see bench/programs); this also skips editor
+// swap and backup files such as .main.txt.swp and main.txt~
+bool isSourceName(const std::string& name) {
+    return name.size() > 4 && name[0] != '.' && name.compare(name.size() - 4, 4, ".txt") == 0;
+}
+
+} // namespace
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+}
+
+#ifdef __linux__
+
+bool FileWatcher::open(std::string& error) {
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        error = std::string("inotify_init1: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool FileWatcher::watchDirectory(const std::string& directory, std::string& error) {
+    // IN_CLOSE_WRITE rather than IN_MODIFY: a file is read once the writer
+    // is done with it, not after every write() of a save
+    int wd = inotify_add_watch(fd, directory.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE);
+    if (wd < 0) {
+        error = directory + ": inotify_add_watch: " + std::strerror(errno);
+        return false;
+    }
+    directories[wd] = directory;
+    return true;
+}
+
+bool FileWatcher::wait(int settleMs, std::vector<std::string>& paths, bool& overflow) {
+    paths.clear();
+    overflow = false;
+    std::set<std::string> seen;
+    alignas(inotify_event) char buffer[64 * 1024];
+    int timeout = -1;
+    for (;;) {
+        pollfd ready{fd, POLLIN, 0};
+        int count = poll(&ready, 1, timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            return false;
+        }
+        for (char* next = buffer; next < buffer + size;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(next);
+            next += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            auto directory = directories.find(event->wd);
+            if (event->len == 0 || (event->mask & IN_ISDIR) || directory == directories.end()) {
+                continue;
+            }
+            std::string path = joinPath(directory->second, event->name);
+            if (seen.insert(path).second) {
+                paths.push_back(path);
+            }
+        }
+        timeout = settleMs;
+    }
+}
+
+#else
+
+bool FileWatcher::open(std::string& error) {
+    error = "inotify is only available on Linux";
+    return false;
+}
+
+bool FileWatcher::watchDirectory(const std::string&, std::string& error) {
+    error = "inotify is only available on Linux";
+    return false;
+}
+
+bool FileWatcher::wait(int, std::vector<std::string>& paths, bool& overflow) {
+    paths.clear();
+    overflow = false;
+    return false;
+}
+
+#endif // __linux__
+
+bool WatchSession::add(const std::string& path, std::string& error) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        std::string directory = trimSlashes(path);
+        directories.insert(directory);
+        watchedDirectories.insert(directory);
+        scanDirectory(directory);
+        return true;
+    }
+
+    std::string directory, name;
+    splitPath(trimSlashes(path), directory, name);
+    files[joinPath(directory, name)].named = true;
+    watchedDirectories.insert(directory);
+    return true;
+}
+
+void WatchSession::scanDirectory(const std::string& directory) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+    while (const dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (!isSourceName(name)) {
+            continue;
+        }
+        std::string path = joinPath(directory, name);
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            files[path];
+        }
+    }
+    closedir(dir);
+}
+
+void WatchSession::check(const std::string& path, WatchedFile& file) {
+    file.readable = readSourceFile(path, source);
+    if (!file.readable) {
+        file.readError = errno;
+        file.context.reset();
+        return;
+    }
+    if (!file.context) {
+        file.context = std::make_unique<AnalysisContext>();
+    }
+    file.context->analyze(source);
+}
+
+size_t WatchSession::checkAll() {
+    for (const std::string& directory : directories) {
+        scanDirectory(directory);
+    }
+    size_t checked = 0;
+    for (auto it = files.begin(); it != files.end();) {
+        check(it->first, it->second);
+        ++checked;
+        if (!it->second.readable && !it->second.named) {
+            it = files.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return checked;
+}
+
+bool WatchSession::update(const std::string& path) {
+    auto it = files.find(path);
+    if (it == files.end()) {
+        std::string directory, name;
+        splitPath(path, directory, name);
+        if (!directories.count(directory) || !isSourceName(name)) {
+            return false;
+        }
+        it = files.emplace(path, WatchedFile()).first;
+    }
+    check(it->first, it->second);
+    if (!it->second.readable && !it->second.named) {
+        // Deleted or renamed away from a watched directory
+        files.erase(it);
+    }
+    return true;
+}
+
+void WatchSession::printSummary(std::ostream& out, size_t checked, double ms) const {
+    size_t failed = 0;
+    for (const auto& entry : files) {
+        const WatchedFile& file = entry.second;
+        if (!file.readable || !file.context->diagnostics().empty()) {
+            ++failed;
+        }
+    }
+    out << "watch: re-checked " << checked << " of " << files.size() << " files in " << ms
+        << " ms: " << files.size() - failed << " ok, " << failed << " failed\n";
+    for (const auto& entry : files) {
+        const WatchedFile& file = entry.second;
+        if (!file.readable) {
+            out << entry.first << ": cannot read file";
+            if (file.readError != 0) {
+                out << ": " << std::strerror(file.readError);
+            }
+            out << "\n";
+        } else if (!file.context->diagnostics().empty()) {
+            out << entry.first << ": " << file.context->diagnostics().front().message << "\n";
+        }
+    }
+    out.flush();
+}
@@ -0,0 +1,80 @@
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "analysis_context.hpp"
+
+// semanticdriver --watch: every file's AST and analysis result stay in
+// memory, and only the files inotify reports as written, renamed into place
+// or removed are read, parsed and analyzed again.
+
+// inotify(7) watches on directories. Files are watched through their parent
+// directory, so an editor that saves by writing a new file and renaming it
+// over the old one is seen like any other write.
+class FileWatcher {
+ private:
+    int fd;
+    std::map<int, std::string> directories;  // watch descriptor -> directory
+
+ public:
+    FileWatcher() : fd(-1) {}
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Fails on non-Linux builds and when the inotify instance limit is hit
+    bool open(std::string& error);
+    bool watchDirectory(const std::string& directory, std::string& error);
+
+    // Block until a watched directory changes, then keep collecting events
+    // until none arrive for `settleMs`, so the several events of one save
+    // form one batch. `paths` gets each changed path once; `overflow` is set
+    // when the kernel dropped events and everything must be re-checked.
+    // Returns false if reading the events fails.
+    bool wait(int settleMs, std::vector<std::string>& paths, bool& overflow);
+};
+
+// The files under watch and their latest results
+class WatchSession {
+ private:
+    struct WatchedFile {
+        std::unique_ptr<AnalysisContext> context;
+        bool readable = false;
+        int readError = 0;   // errno when !readable, or 0 if unknown
+        bool named = false;  // given on the command line; kept when deleted
+    };
+
+    std::map<std::string, WatchedFile> files;  // by path, for the summary
+    std::set<std::string> directories;         // directories given on the command line
+    std::set<std::string> watchedDirectories;  // every directory that needs a watch
+    std::string source;                        // reused read buffer
+
+    void check(const std::string& path, WatchedFile& file);
+    void scanDirectory(const std::string& directory);
+
+ public:
+    // Add a file, or every *.txt file in a directory (not recursively)
+    bool add(const std::string& path, std::string& error);
+
+    const std::set<std::string>& watchDirectories() const { return watchedDirectories; }
+
+    // Check every file, picking up files created in watched directories;
+    // returns the number checked
+    size_t checkAll();
+
+    // Re-check `path` after a change. Returns false if it is not a watched
+    // file and not a new *.txt file in a watched directory.
+    bool update(const std::string& path);
+
+    // "watch: re-checked 1 of 120 files in 0.8 ms: 118 ok, 2 failed", then
+    // one "path: message" line per failing file
+    void printSummary(std::ostream& out, size_t checked, double ms) const;
+};
+
+#endif // WATCH_HPP